@@ -16,9 +16,6 @@
 //-----------------------------------------------------------------------------
 
 namespace astyle {
-//
-// this must be global
-static int g_preprocessorCppExternCBrace;
 
 //-----------------------------------------------------------------------------
 // ASBeautifier class
@@ -35,17 +32,8 @@ ASBeautifier::ASBeautifier()
 	activeBeautifierStack = nullptr;
 	waitingBeautifierStackLengthStack = nullptr;
 	activeBeautifierStackLengthStack = nullptr;
-
-	headerStack = nullptr;
-	tempStacks = nullptr;
-	parenDepthStack = nullptr;
-	blockStatementStack = nullptr;
-	parenStatementStack = nullptr;
-	braceBlockStateStack = nullptr;
-	continuationIndentStack = nullptr;
-	continuationIndentStackSizeStack = nullptr;
-	parenIndentStack = nullptr;
-	preprocIndentStack = nullptr;
+	cppExternCBraceState = 0;
+	preprocessorCppExternCBrace = &cppExternCBraceState;
 	sourceIterator = nullptr;
 	isModeManuallySet = false;
 	shouldForceTabIndentation = false;
@@ -72,26 +60,38 @@ ASBeautifier::ASBeautifier()
 	setAlignMethodColon(false);
 
 	// initialize ASBeautifier member vectors
+	// they point to the shared language vectors set by initVectors()
 	beautifierFileType = 9;		// reset to an invalid type
-	headers = new vector<const string*>;
-	nonParenHeaders = new vector<const string*>;
-	assignmentOperators = new vector<const string*>;
-	nonAssignmentOperators = new vector<const string*>;
-	preBlockStatements = new vector<const string*>;
-	preCommandHeaders = new vector<const string*>;
-	indentableHeaders = new vector<const string*>;
+	headers = nullptr;
+	nonParenHeaders = nullptr;
+	assignmentOperators = nullptr;
+	nonAssignmentOperators = nullptr;
+	preBlockStatements = nullptr;
+	preCommandHeaders = nullptr;
+	indentableHeaders = nullptr;
 }
 
 /**
  * ASBeautifier's copy constructor
- * Copy the vector objects to vectors in the new ASBeautifier
- * object so the new object can be destroyed without deleting
- * the vector objects in the copied vector.
- * This is the reason a copy constructor is needed.
+ * The stacks are ASSharedStack objects that share the elements with
+ * the copied object. An element vector is copied only when one of the
+ * objects changes it, so a clone for a preprocessor conditional is
+ * created without copying the stacks.
  *
  * Must explicitly call the base class copy constructor.
  */
-ASBeautifier::ASBeautifier(const ASBeautifier& other) : ASBase(other)
+ASBeautifier::ASBeautifier(const ASBeautifier& other)
+	: ASBase(other),
+	  headerStack(other.headerStack),
+	  tempStacks(other.tempStacks),
+	  parenDepthStack(other.parenDepthStack),
+	  blockStatementStack(other.blockStatementStack),
+	  parenStatementStack(other.parenStatementStack),
+	  braceBlockStateStack(other.braceBlockStateStack),
+	  continuationIndentStack(other.continuationIndentStack),
+	  continuationIndentStackSizeStack(other.continuationIndentStackSizeStack),
+	  parenIndentStack(other.parenIndentStack),
+	  preprocIndentStack(other.preprocIndentStack)
 {
 	// these don't need to copy the stack
 	waitingBeautifierStack = nullptr;
@@ -99,40 +99,9 @@ ASBeautifier::ASBeautifier(const ASBeautifier& other) : ASBase(other)
 	waitingBeautifierStackLengthStack = nullptr;
 	activeBeautifierStackLengthStack = nullptr;
 
-	// vector '=' operator performs a DEEP copy of all elements in the vector
-
-	headerStack = new vector<const string*>;
-	*headerStack = *other.headerStack;
-
-	tempStacks = copyTempStacks(other);
-
-	parenDepthStack = new vector<int>;
-	*parenDepthStack = *other.parenDepthStack;
-
-	blockStatementStack = new vector<bool>;
-	*blockStatementStack = *other.blockStatementStack;
-
-	parenStatementStack = new vector<bool>;
-	*parenStatementStack = *other.parenStatementStack;
-
-	braceBlockStateStack = new vector<bool>;
-	*braceBlockStateStack = *other.braceBlockStateStack;
-
-	continuationIndentStack = new vector<int>;
-	*continuationIndentStack = *other.continuationIndentStack;
-
-	continuationIndentStackSizeStack = new vector<int>;
-	*continuationIndentStackSizeStack = *other.continuationIndentStackSizeStack;
-
-	parenIndentStack = new vector<int>;
-	*parenIndentStack = *other.parenIndentStack;
-
-	preprocIndentStack = new vector<pair<int, int> >;
-	*preprocIndentStack = *other.preprocIndentStack;
-
 	// Copy the pointers to vectors.
-	// This is ok because the original ASBeautifier object
-	// is not deleted until end of job.
+	// This is ok because the language vectors are shared
+	// by all objects and are never deleted.
 	beautifierFileType = other.beautifierFileType;
 	headers = other.headers;
 	nonParenHeaders = other.nonParenHeaders;
@@ -141,6 +110,8 @@ ASBeautifier::ASBeautifier(const ASBeautifier& other) : ASBase(other)
 	preBlockStatements = other.preBlockStatements;
 	preCommandHeaders = other.preCommandHeaders;
 	indentableHeaders = other.indentableHeaders;
+	// the extern "C" state is shared with the original
+	preprocessorCppExternCBrace = other.preprocessorCppExternCBrace;
 
 	// protected variables
 	// variables set by ASFormatter
@@ -238,6 +209,8 @@ ASBeautifier::ASBeautifier(const ASBeautifier& other) : ASBase(other)
 	spaceIndentObjCMethodAlignment = other.spaceIndentObjCMethodAlignment;
 	bracePosObjCMethodAlignment = other.bracePosObjCMethodAlignment;
 	colonIndentObjCMethodAlignment = other.colonIndentObjCMethodAlignment;
+	keywordIndentObjCMethodAlignment = other.keywordIndentObjCMethodAlignment;
+	cppExternCBraceState = 0;
 	lineOpeningBlocksNum = other.lineOpeningBlocksNum;
 	lineClosingBlocksNum = other.lineClosingBlocksNum;
 	fileType = other.fileType;
@@ -272,16 +245,6 @@ ASBeautifier::~ASBeautifier()
 	deleteBeautifierContainer(activeBeautifierStack);
 	deleteContainer(waitingBeautifierStackLengthStack);
 	deleteContainer(activeBeautifierStackLengthStack);
-	deleteContainer(headerStack);
-	deleteTempStacksContainer(tempStacks);
-	deleteContainer(parenDepthStack);
-	deleteContainer(blockStatementStack);
-	deleteContainer(parenStatementStack);
-	deleteContainer(braceBlockStateStack);
-	deleteContainer(continuationIndentStack);
-	deleteContainer(continuationIndentStackSizeStack);
-	deleteContainer(parenIndentStack);
-	deleteContainer(preprocIndentStack);
 }
 
 /**
@@ -300,29 +263,29 @@ void ASBeautifier::init(ASSourceIterator* iter)
 	sourceIterator = iter;
 	initVectors();
 	ASBase::init(getFileType());
-	g_preprocessorCppExternCBrace = 0;
+	*preprocessorCppExternCBrace = 0;
 
-	initContainer(waitingBeautifierStack, new vector<ASBeautifier*>);
-	initContainer(activeBeautifierStack, new vector<ASBeautifier*>);
+	initBeautifierContainer(waitingBeautifierStack);
+	initBeautifierContainer(activeBeautifierStack);
 
-	initContainer(waitingBeautifierStackLengthStack, new vector<int>);
-	initContainer(activeBeautifierStackLengthStack, new vector<int>);
+	initContainer(waitingBeautifierStackLengthStack);
+	initContainer(activeBeautifierStackLengthStack);
 
-	initContainer(headerStack, new vector<const string*>);
+	headerStack.clear();
 
-	initTempStacksContainer(tempStacks, new vector<vector<const string*>*>);
-	tempStacks->emplace_back(new vector<const string*>);
+	tempStacks.clear();
+	tempStacks.pushStack();
 
-	initContainer(parenDepthStack, new vector<int>);
-	initContainer(blockStatementStack, new vector<bool>);
-	initContainer(parenStatementStack, new vector<bool>);
-	initContainer(braceBlockStateStack, new vector<bool>);
-	braceBlockStateStack->push_back(true);
-	initContainer(continuationIndentStack, new vector<int>);
-	initContainer(continuationIndentStackSizeStack, new vector<int>);
-	continuationIndentStackSizeStack->emplace_back(0);
-	initContainer(parenIndentStack, new vector<int>);
-	initContainer(preprocIndentStack, new vector<pair<int, int> >);
+	parenDepthStack.clear();
+	blockStatementStack.clear();
+	parenStatementStack.clear();
+	braceBlockStateStack.clear();
+	braceBlockStateStack.write().push_back(true);
+	continuationIndentStack.clear();
+	continuationIndentStackSizeStack.clear();
+	continuationIndentStackSizeStack.write().emplace_back(0);
+	parenIndentStack.clear();
+	preprocIndentStack.clear();
 
 	previousLastLineHeader = nullptr;
 	currentHeader = nullptr;
@@ -364,6 +327,7 @@ void ASBeautifier::init(ASSourceIterator* iter)
 	spaceIndentObjCMethodAlignment = 0;
 	bracePosObjCMethodAlignment = 0;
 	colonIndentObjCMethodAlignment = 0;
+	keywordIndentObjCMethodAlignment = 0;
 	lineOpeningBlocksNum = 0;
 	lineClosingBlocksNum = 0;
 	templateDepth = 0;
@@ -426,21 +390,14 @@ void ASBeautifier::initVectors()
 
 	beautifierFileType = fileType;
 
-	headers->clear();
-	nonParenHeaders->clear();
-	assignmentOperators->clear();
-	nonAssignmentOperators->clear();
-	preBlockStatements->clear();
-	preCommandHeaders->clear();
-	indentableHeaders->clear();
-
-	ASResource::buildHeaders(headers, fileType, true);
-	ASResource::buildNonParenHeaders(nonParenHeaders, fileType, true);
-	ASResource::buildAssignmentOperators(assignmentOperators);
-	ASResource::buildNonAssignmentOperators(nonAssignmentOperators);
-	ASResource::buildPreBlockStatements(preBlockStatements, fileType);
-	ASResource::buildPreCommandHeaders(preCommandHeaders, fileType);
-	ASResource::buildIndentableHeaders(indentableHeaders);
+	const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+	headers = &languageVectors.beautifierHeaders;
+	nonParenHeaders = &languageVectors.beautifierNonParenHeaders;
+	assignmentOperators = &languageVectors.assignmentOperators;
+	nonAssignmentOperators = &languageVectors.nonAssignmentOperators;
+	preBlockStatements = &languageVectors.preBlockStatements;
+	preCommandHeaders = &languageVectors.preCommandHeaders;
+	indentableHeaders = &languageVectors.indentableHeaders;
 }
 
 /**
@@ -943,7 +900,7 @@ string ASBeautifier::beautify(const string& originalLine)
 	{
 		// trim the end of comment and SQL lines
 		line = originalLine;
-		size_t trimEnd = line.find_last_not_of(" \t");
+		size_t trimEnd = ASScanner::findLastNonBlank(line);
 		if (trimEnd == string::npos)
 			trimEnd = 0;
 		else
@@ -951,7 +908,7 @@ string ASBeautifier::beautify(const string& originalLine)
 		if (trimEnd < line.length())
 			line.erase(trimEnd);
 		// does a brace open the line
-		size_t firstChar = line.find_first_not_of(" \t");
+		size_t firstChar = ASScanner::findNonBlank(line);
 		if (firstChar != string::npos)
 		{
 			if (line[firstChar] == '{')
@@ -977,7 +934,7 @@ string ASBeautifier::beautify(const string& originalLine)
 				lineIsLineCommentOnly = true;
 			else if (line.compare(0, 2, "/*") == 0)
 			{
-				if (line.find("*/", 2) != string::npos)
+				if (ASScanner::findCommentEnd(line, 2) != string::npos)
 					lineIsCommentOnly = true;
 			}
 		}
@@ -1062,7 +1019,7 @@ string ASBeautifier::beautify(const string& originalLine)
 			if (isInIndentablePreprocBlock || isInIndentablePreproc)
 			{
 				string indentedLine;
-				if ((preproc.length() >= 2 && preproc.substr(0, 2) == "if")) // #if, #ifdef, #ifndef
+				if ((preproc.length() >= 2 && preproc.compare(0, 2, "if") == 0)) // #if, #ifdef, #ifndef
 				{
 					indentedLine = preLineWS(preprocBlockIndent, 0) + line;
 					preprocBlockIndent += 1;
@@ -1086,14 +1043,14 @@ string ASBeautifier::beautify(const string& originalLine)
 			if (shouldIndentPreprocConditional && preproc.length() > 0)
 			{
 				string indentedLine;
-				if (preproc.length() >= 2 && preproc.substr(0, 2) == "if") // #if, #ifdef, #ifndef
+				if (preproc.length() >= 2 && preproc.compare(0, 2, "if") == 0) // #if, #ifdef, #ifndef
 				{
 					pair<int, int> entry;	// indentCount, spaceIndentCount
 					if (!isInDefine && activeBeautifierStack != nullptr && !activeBeautifierStack->empty())
 						entry = activeBeautifierStack->back()->computePreprocessorIndent();
 					else
 						entry = computePreprocessorIndent();
-					preprocIndentStack->emplace_back(entry);
+					preprocIndentStack.write().emplace_back(entry);
 					indentedLine = preLineWS(preprocIndentStack->back().first,
 					                         preprocIndentStack->back().second) + line;
 					return getIndentedLineReturn(indentedLine, originalLine);
@@ -1113,7 +1070,7 @@ string ASBeautifier::beautify(const string& originalLine)
 					{
 						indentedLine = preLineWS(preprocIndentStack->back().first,
 						                         preprocIndentStack->back().second) + line;
-						preprocIndentStack->pop_back();
+						preprocIndentStack.write().pop_back();
 						return getIndentedLineReturn(indentedLine, originalLine);
 					}
 				}
@@ -1230,7 +1187,8 @@ string ASBeautifier::beautify(const string& originalLine)
 
 	// finally, insert indentations into beginning of line
 
-	string indentedLine = preLineWS(indentCount, spaceIndentCount) + line;
+	string indentedLine = preLineWS(indentCount, spaceIndentCount, line.length());
+	indentedLine.append(line);
 	indentedLine = getIndentedLineReturn(indentedLine, originalLine);
 
 	prevFinalLineSpaceIndentCount = spaceIndentCount;
@@ -1253,7 +1211,8 @@ const string& ASBeautifier::getIndentedLineReturn(const string& newLine, const s
 	return newLine;
 }
 
-string ASBeautifier::preLineWS(int lineIndentCount, int lineSpaceIndentCount) const
+string ASBeautifier::preLineWS(int lineIndentCount, int lineSpaceIndentCount,
+                               size_t textLength /*0*/) const
 {
 	if (shouldForceTabIndentation)
 	{
@@ -1272,11 +1231,16 @@ string ASBeautifier::preLineWS(int lineIndentCount, int lineSpaceIndentCount) co
 		}
 	}
 
+	// reserve room for the text that follows so appending it does not reallocate
 	string ws;
+	if (lineIndentCount < 0)
+		lineIndentCount = 0;
+	if (lineSpaceIndentCount < 0)
+		lineSpaceIndentCount = 0;
+	ws.reserve(lineIndentCount * indentString.length() + lineSpaceIndentCount + textLength);
 	for (int i = 0; i < lineIndentCount; i++)
-		ws += indentString;
-	while ((lineSpaceIndentCount--) > 0)
-		ws += string(" ");
+		ws.append(indentString);
+	ws.append(lineSpaceIndentCount, ' ');
 	return ws;
 }
 
@@ -1300,17 +1264,17 @@ void ASBeautifier::registerContinuationIndent(const string& line, int i, int spa
 		int currIndent = continuationIndent * indentLength + previousIndent;
 		if (currIndent > maxContinuationIndent && line[i] != '{')
 			currIndent = indentLength * 2 + spaceIndentCount_;
-		continuationIndentStack->emplace_back(currIndent);
+		continuationIndentStack.write().emplace_back(currIndent);
 		if (updateParenStack)
-			parenIndentStack->emplace_back(previousIndent);
+			parenIndentStack.write().emplace_back(previousIndent);
 		return;
 	}
 
 	if (updateParenStack)
 	{
-		parenIndentStack->emplace_back(i + spaceIndentCount_ - runInIndentContinuation);
+		parenIndentStack.write().emplace_back(i + spaceIndentCount_ - runInIndentContinuation);
 		if (parenIndentStack->back() < 0)
-			parenIndentStack->back() = 0;
+			parenIndentStack.write().back() = 0;
 	}
 
 	int tabIncrement = tabIncrementIn;
@@ -1345,7 +1309,7 @@ void ASBeautifier::registerContinuationIndent(const string& line, int i, int spa
 	        && !isInEnum && !braceBlockStateStack->empty() && braceBlockStateStack->back())
 		continuationIndentCount = 0;
 
-	continuationIndentStack->emplace_back(continuationIndentCount);
+	continuationIndentStack.write().emplace_back(continuationIndentCount);
 }
 
 /**
@@ -1364,7 +1328,7 @@ void ASBeautifier::registerContinuationIndentColon(const string& line, int i, in
 		if (firstWord != string::npos)
 		{
 			int continuationIndentCount = firstWord + spaceIndentCount + tabIncrementIn;
-			continuationIndentStack->emplace_back(continuationIndentCount);
+			continuationIndentStack.write().emplace_back(continuationIndentCount);
 			isContinuation = true;
 		}
 	}
@@ -1468,21 +1432,33 @@ int ASBeautifier::convertTabToSpaces(int i, int tabIncrementIn) const
  */
 string ASBeautifier::trim(const string& str) const
 {
-	int start = 0;
-	int end = str.length() - 1;
-
-	while (start < end && isWhiteSpace(str[start]))
-		start++;
+	size_t start;
+	size_t length = findTrimBounds(str, start);
+	string returnStr(str, start, length);
+	return returnStr;
+}
 
-	while (start <= end && isWhiteSpace(str[end]))
-		end--;
+/**
+ * find the part of a line that trim() would keep, without copying it.
+ *
+ * @return          the length of the trimmed line.
+ * @param str       the line to trim.
+ * @param start     set to the position of the first character kept.
+ */
+size_t ASBeautifier::findTrimBounds(const string& str, size_t& start) const
+{
+	start = 0;
+	size_t first = ASScanner::findNonBlank(str);
+	if (first == string::npos)
+		return 0;
+	size_t end = ASScanner::findLastNonBlank(str);
 
 	// don't trim if it ends in a continuation
-	if (end > -1 && str[end] == '\\')
+	if (str[end] == '\\')
 		end = str.length() - 1;
 
-	string returnStr(str, start, end + 1 - start);
-	return returnStr;
+	start = first;
+	return end + 1 - first;
 }
 
 /**
@@ -1503,43 +1479,51 @@ string ASBeautifier::rtrim(const string& str) const
 }
 
 /**
- * Copy tempStacks for the copy constructor.
- * The value of the vectors must also be copied.
+ * Copy the ASBeautifier objects in a waiting or active beautifier stack.
+ * The copies use the extern "C" state of this object.
+ * Used by copyBeautifierStacks().
  */
-vector<vector<const string*>*>* ASBeautifier::copyTempStacks(const ASBeautifier& other) const
+vector<ASBeautifier*>* ASBeautifier::copyBeautifierContainer(const vector<ASBeautifier*>* container) const
 {
-	vector<vector<const string*>*>* tempStacksNew = new vector<vector<const string*>*>;
-	vector<vector<const string*>*>::iterator iter;
-	for (iter = other.tempStacks->begin();
-	        iter != other.tempStacks->end();
-	        ++iter)
+	vector<ASBeautifier*>* containerNew = new vector<ASBeautifier*>;
+	for (const ASBeautifier* beautifier : *container)
 	{
-		vector<const string*>* newVec = new vector<const string*>;
-		*newVec = **iter;
-		tempStacksNew->emplace_back(newVec);
+		ASBeautifier* beautifierNew = new ASBeautifier(*beautifier);
+		beautifierNew->preprocessorCppExternCBrace = preprocessorCppExternCBrace;
+		containerNew->emplace_back(beautifierNew);
 	}
-	return tempStacksNew;
+	return containerNew;
 }
 
 /**
- * delete a member vectors to eliminate memory leak reporting
+ * Copy the beautifier stacks and the extern "C" state that are
+ * not copied by the copy constructor.
+ * Used by the ASFormatter copy constructor to save the complete state.
  */
-void ASBeautifier::deleteBeautifierVectors()
+void ASBeautifier::copyBeautifierStacks(const ASBeautifier& other)
 {
-	beautifierFileType = 9;		// reset to an invalid type
-	delete headers;
-	delete nonParenHeaders;
-	delete preBlockStatements;
-	delete preCommandHeaders;
-	delete assignmentOperators;
-	delete nonAssignmentOperators;
-	delete indentableHeaders;
+	cppExternCBraceState = *other.preprocessorCppExternCBrace;
+	preprocessorCppExternCBrace = &cppExternCBraceState;
+
+	if (other.waitingBeautifierStack != nullptr)
+		waitingBeautifierStack = copyBeautifierContainer(other.waitingBeautifierStack);
+	if (other.activeBeautifierStack != nullptr)
+		activeBeautifierStack = copyBeautifierContainer(other.activeBeautifierStack);
+	if (other.waitingBeautifierStackLengthStack != nullptr)
+	{
+		waitingBeautifierStackLengthStack = new vector<int>;
+		*waitingBeautifierStackLengthStack = *other.waitingBeautifierStackLengthStack;
+	}
+	if (other.activeBeautifierStackLengthStack != nullptr)
+	{
+		activeBeautifierStackLengthStack = new vector<int>;
+		*activeBeautifierStackLengthStack = *other.activeBeautifierStackLengthStack;
+	}
 }
 
 /**
  * delete a vector object
  * T is the type of vector
- * used for all vectors except tempStacks
  */
 template<typename T>
 void ASBeautifier::deleteContainer(T& container)
@@ -1575,51 +1559,40 @@ void ASBeautifier::deleteBeautifierContainer(vector<ASBeautifier*>*& container)
 }
 
 /**
- * Delete the tempStacks vector object.
- * The tempStacks is a vector of pointers to strings allocated with the 'new' operator.
- * Therefore the strings have to be deleted in addition to the tempStacks entries.
+ * Initialize the ASBeautifier vector object.
+ * The ASBeautifier objects from the previous file are deleted.
+ * The vector is reused so its memory is not allocated again.
  */
-void ASBeautifier::deleteTempStacksContainer(vector<vector<const string*>*>*& container)
+void ASBeautifier::initBeautifierContainer(vector<ASBeautifier*>*& container)
 {
-	if (container != nullptr)
+	if (container == nullptr)
 	{
-		vector<vector<const string*>*>::iterator iter = container->begin();
-		while (iter < container->end())
-		{
-			delete *iter;
-			++iter;
-		}
-		container->clear();
-		delete (container);
-		container = nullptr;
+		container = new vector<ASBeautifier*>;
+		return;
+	}
+	vector<ASBeautifier*>::iterator iter = container->begin();
+	while (iter < container->end())
+	{
+		delete *iter;
+		++iter;
 	}
+	container->clear();
 }
 
 /**
  * initialize a vector object
- * T is the type of vector used for all vectors
+ * T is the type of the vector elements
  */
 template<typename T>
-void ASBeautifier::initContainer(T& container, T value)
-{
-	// since the ASFormatter object is never deleted,
-	// the existing vectors must be deleted before creating new ones
-	if (container != nullptr)
-		deleteContainer(container);
-	container = value;
-}
-
-/**
- * Initialize the tempStacks vector object.
- * The tempStacks is a vector of pointers to strings allocated with the 'new' operator.
- * Any residual entries are deleted before the vector is initialized.
- */
-void ASBeautifier::initTempStacksContainer(vector<vector<const string*>*>*& container,
-                                           vector<vector<const string*>*>* value)
+void ASBeautifier::initContainer(vector<T>*& container)
 {
-	if (container != nullptr)
-		deleteTempStacksContainer(container);
-	container = value;
+	// since the ASFormatter object is never deleted, the vectors
+	// from the previous file are cleared and reused for the new file.
+	// the memory allocated for the previous file is not allocated again.
+	if (container == nullptr)
+		container = new vector<T>;
+	else
+		container->clear();
 }
 
 /**
@@ -1718,7 +1691,7 @@ bool ASBeautifier::isLineEndComment(const string& line, int startPos) const
 	assert(line.compare(startPos, 2, "/*") == 0);
 
 	// comment must be closed on this line with nothing after it
-	size_t endNum = line.find("*/", startPos + 2);
+	size_t endNum = ASScanner::findCommentEnd(line, startPos + 2);
 	if (endNum != string::npos)
 	{
 		size_t nextChar = line.find_first_not_of(" \t", endNum + 2);
@@ -1836,11 +1809,7 @@ bool ASBeautifier::isIndentedPreprocessor(const string& line, size_t currPos) co
 		if (start == string::npos || !isLegalNameChar(line[start]))
 			return false;
 		// bypass pragma
-		for (; start < line.length(); start++)
-		{
-			if (!isLegalNameChar(line[start]))
-				break;
-		}
+		start = findWordEnd(line, start);
 		start++;
 		if (start >= line.length())
 			return false;
@@ -1849,12 +1818,7 @@ bool ASBeautifier::isIndentedPreprocessor(const string& line, size_t currPos) co
 		if (start == string::npos)
 			return false;
 		// point to end of second word
-		size_t end;
-		for (end = start; end < line.length(); end++)
-		{
-			if (!isLegalNameChar(line[end]))
-				break;
-		}
+		size_t end = findWordEnd(line, start);
 		// check for "pragma omp"
 		string word = line.substr(start, end - start);
 		if (word == "omp" || word == "region" || word == "endregion")
@@ -1908,7 +1872,7 @@ bool ASBeautifier::isInPreprocessorUnterminatedComment(const string& line)
 		if (startPos == string::npos)
 			return false;
 	}
-	size_t endNum = line.find("*/");
+	size_t endNum = ASScanner::findCommentEnd(line);
 	if (endNum != string::npos)
 	{
 		isInPreprocessorComment = false;
@@ -1923,9 +1887,9 @@ void ASBeautifier::popLastContinuationIndent()
 	assert(!continuationIndentStackSizeStack->empty());
 	int previousIndentStackSize = continuationIndentStackSizeStack->back();
 	if (continuationIndentStackSizeStack->size() > 1)
-		continuationIndentStackSizeStack->pop_back();
+		continuationIndentStackSizeStack.write().pop_back();
 	while (previousIndentStackSize < (int) continuationIndentStack->size())
-		continuationIndentStack->pop_back();
+		continuationIndentStack.write().pop_back();
 }
 
 // for unit testing
@@ -1962,10 +1926,10 @@ void ASBeautifier::processPreprocessor(const string& preproc, const string& line
 			isInDefine = true;
 		}
 	}
-	else if (preproc.length() >= 2 && preproc.substr(0, 2) == "if")
+	else if (preproc.length() >= 2 && preproc.compare(0, 2, "if") == 0)
 	{
-		if (isPreprocessorConditionalCplusplus(line) && !g_preprocessorCppExternCBrace)
-			g_preprocessorCppExternCBrace = 1;
+		if (isPreprocessorConditionalCplusplus(line) && *preprocessorCppExternCBrace == 0)
+			*preprocessorCppExternCBrace = 1;
 		// push a new beautifier into the stack
 		waitingBeautifierStackLengthStack->push_back(waitingBeautifierStack->size());
 		activeBeautifierStackLengthStack->push_back(activeBeautifierStack->size());
@@ -2110,7 +2074,7 @@ void ASBeautifier::computePreliminaryIndentation()
 	if (isInEnum && lineBeginsWithComma && !continuationIndentStack->empty())
 	{
 		// unregister '=' indent from the previous line
-		continuationIndentStack->pop_back();
+		continuationIndentStack.write().pop_back();
 		isContinuation = false;
 		spaceIndentCount = 0;
 	}
@@ -2152,7 +2116,7 @@ void ASBeautifier::computePreliminaryIndentation()
 
 	if (isInConditional)
 		--indentCount;
-	if (g_preprocessorCppExternCBrace >= 4)
+	if (*preprocessorCppExternCBrace >= 4)
 		--indentCount;
 }
 
@@ -2249,16 +2213,12 @@ void ASBeautifier::adjustParsedLineIndentation(size_t iPrelim, bool isInExtraHea
  */
 int ASBeautifier::adjustIndentCountForBreakElseIfComments() const
 {
-	assert(isElseHeaderIndent && !tempStacks->empty());
+	assert(isElseHeaderIndent && !tempStacks.empty());
 	int indentCountIncrement = 0;
-	vector<const string*>* lastTempStack = tempStacks->back();
-	if (lastTempStack != nullptr)
+	for (size_t i = 0; i < tempStacks.headerCount(); i++)
 	{
-		for (size_t i = 0; i < lastTempStack->size(); i++)
-		{
-			if (*lastTempStack->at(i) == AS_ELSE)
-				indentCountIncrement++;
-		}
+		if (*tempStacks.getHeader(i) == AS_ELSE)
+			indentCountIncrement++;
 	}
 	return indentCountIncrement;
 }
@@ -2297,7 +2257,7 @@ void ASBeautifier::adjustObjCMethodDefinitionIndentation(const string& line_)
 		else if (continuationIndentStack->empty()
 		         || continuationIndentStack->back() == 0)
 		{
-			continuationIndentStack->emplace_back(indentLength);
+			continuationIndentStack.write().emplace_back(indentLength);
 			isContinuation = true;
 		}
 	}
@@ -2313,7 +2273,6 @@ void ASBeautifier::adjustObjCMethodDefinitionIndentation(const string& line_)
 
 void ASBeautifier::adjustObjCMethodCallIndentation(const string& line_)
 {
-	static int keywordIndentObjCMethodAlignment = 0;
 	if (shouldAlignMethodColon && objCColonAlignSubsequent != -1)
 	{
 		if (isInObjCMethodCallFirst)
@@ -2381,7 +2340,7 @@ void ASBeautifier::clearObjCMethodDefinitionAlignment()
 	isInObjCMethodDefinition = false;
 	isImmediatelyPostObjCMethodDefinition = false;
 	if (!continuationIndentStack->empty())
-		continuationIndentStack->pop_back();
+		continuationIndentStack.write().pop_back();
 }
 
 /**
@@ -2599,8 +2558,8 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				else if (isSharpStyle() && prevCh == '@')
 					isInVerbatimQuote = true;
 				// check for "C" following "extern"
-				else if (g_preprocessorCppExternCBrace == 2 && line.compare(i, 3, "\"C\"") == 0)
-					++g_preprocessorCppExternCBrace;
+				else if (*preprocessorCppExternCBrace == 2 && line.compare(i, 3, "\"C\"") == 0)
+					++*preprocessorCppExternCBrace;
 			}
 			else if (isInVerbatimQuote && ch == '"')
 			{
@@ -2645,7 +2604,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				--indentCount;
 			// isElseHeaderIndent is set by ASFormatter if shouldBreakElseIfs is requested
 			// if there is an 'else' after these comments a tempStacks indent is required
-			if (isElseHeaderIndent && lineOpensWithLineComment && !tempStacks->empty())
+			if (isElseHeaderIndent && lineOpensWithLineComment && !tempStacks.empty())
 				indentCount += adjustIndentCountForBreakElseIfComments();
 			isInLineComment = true;
 			i++;
@@ -2658,7 +2617,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				--indentCount;
 			// isElseHeaderIndent is set by ASFormatter if shouldBreakElseIfs is requested
 			// if there is an 'else' after these comments a tempStacks indent is required
-			if (isElseHeaderIndent && lineOpensWithComment && !tempStacks->empty())
+			if (isElseHeaderIndent && lineOpensWithComment && !tempStacks.empty())
 				indentCount += adjustIndentCountForBreakElseIfComments();
 			isInComment = true;
 			i++;
@@ -2678,7 +2637,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			// if there is an 'else' after these comments a tempStacks indent is required
 			if (firstText == i)
 			{
-				if (isElseHeaderIndent && !lineOpensWithComment && !tempStacks->empty())
+				if (isElseHeaderIndent && !lineOpensWithComment && !tempStacks.empty())
 					indentCount += adjustIndentCountForBreakElseIfComments();
 			}
 			isInComment = false;
@@ -2707,7 +2666,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				--indentCount;
 			// isElseHeaderIndent is set by ASFormatter if shouldBreakElseIfs is requested
 			// if there is an 'else' after these comments a tempStacks indent is required
-			if (!lineOpensWithComment && isElseHeaderIndent && !tempStacks->empty())
+			if (!lineOpensWithComment && isElseHeaderIndent && !tempStacks.empty())
 				indentCount += adjustIndentCountForBreakElseIfComments();
 			// bypass rest of the comment up to the comment end
 			while (i + 1 < line.length()
@@ -2726,7 +2685,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			{
 				// insert the probation header as a new header
 				isInHeader = true;
-				headerStack->emplace_back(probationHeader);
+				headerStack.write().emplace_back(probationHeader);
 
 				// handle the specific probation header
 				isInConditional = (probationHeader == &AS_SYNCHRONIZED);
@@ -2770,7 +2729,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			if (ch == '<')
 			{
 				++templateDepth;
-				continuationIndentStackSizeStack->push_back(continuationIndentStack->size());
+				continuationIndentStackSizeStack.write().push_back(continuationIndentStack->size());
 				registerContinuationIndent(line, i, spaceIndentCount, tabIncrementIn, 0, true);
 			}
 			else if (ch == '>')
@@ -2796,7 +2755,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				        && !headerStack->empty()
 				        && headerStack->back() == &AS_STRUCT)
 				{
-					headerStack->pop_back();
+					headerStack.write().pop_back();
 					isInClassHeader = false;
 					if (line.find(AS_STRUCT, 0) > i)	// if not on this line
 						indentCount -= classInitializerIndents;
@@ -2806,7 +2765,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 
 				if (parenDepth == 0)
 				{
-					parenStatementStack->push_back(isContinuation);
+					parenStatementStack.write().push_back(isContinuation);
 					isContinuation = true;
 				}
 				parenDepth++;
@@ -2820,7 +2779,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					}
 				}
 
-				continuationIndentStackSizeStack->push_back(continuationIndentStack->size());
+				continuationIndentStackSizeStack.write().push_back(continuationIndentStack->size());
 
 				if (currentHeader != nullptr)
 					registerContinuationIndent(line, i, spaceIndentCount, tabIncrementIn, minConditionalIndent, true);
@@ -2844,7 +2803,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					if (!parenStatementStack->empty())      // in case of unmatched closing parens
 					{
 						isContinuation = parenStatementStack->back();
-						parenStatementStack->pop_back();
+						parenStatementStack.write().pop_back();
 					}
 					isInAsm = false;
 					isInConditional = false;
@@ -2857,7 +2816,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					if (!parenIndentStack->empty())
 					{
 						int poppedIndent = parenIndentStack->back();
-						parenIndentStack->pop_back();
+						parenIndentStack.write().pop_back();
 
 						if (i == 0)
 							spaceIndentCount = poppedIndent;
@@ -2916,11 +2875,11 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					}
 			}
 
-			braceBlockStateStack->push_back(isBlockOpener);
+			braceBlockStateStack.write().push_back(isBlockOpener);
 
 			if (!isBlockOpener)
 			{
-				continuationIndentStackSizeStack->push_back(continuationIndentStack->size());
+				continuationIndentStackSizeStack.write().push_back(continuationIndentStack->size());
 				registerContinuationIndent(line, i, spaceIndentCount, tabIncrementIn, 0, true);
 				parenDepth++;
 				if (i == 0)
@@ -2970,11 +2929,11 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			if (!headerStack->empty()
 			        && (*headerStack).back() == &AS_STRUCT
 			        && isInIndentableStruct)
-				(*headerStack).back() = &AS_CLASS;
+				headerStack.write().back() = &AS_CLASS;
 
 			// is a brace inside a paren?
-			parenDepthStack->emplace_back(parenDepth);
-			blockStatementStack->push_back(isContinuation);
+			parenDepthStack.write().emplace_back(parenDepth);
+			blockStatementStack.write().push_back(isContinuation);
 
 			if (!continuationIndentStack->empty())
 			{
@@ -2991,8 +2950,8 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			}
 
 			blockTabCount += (isContinuation ? 1 : 0);
-			if (g_preprocessorCppExternCBrace == 3)
-				++g_preprocessorCppExternCBrace;
+			if (*preprocessorCppExternCBrace == 3)
+				++*preprocessorCppExternCBrace;
 			parenDepth = 0;
 			isInTrailingReturnType = false;
 			isInClassHeader = false;
@@ -3006,8 +2965,8 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			foundPreCommandMacro = false;
 			isInExternC = false;
 
-			tempStacks->emplace_back(new vector<const string*>);
-			headerStack->emplace_back(&AS_OPEN_BRACE);
+			tempStacks.pushStack();
+			headerStack.write().emplace_back(&AS_OPEN_BRACE);
 			lastLineHeader = &AS_OPEN_BRACE;
 
 			continue;
@@ -3048,9 +3007,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 
 				isInHeader = true;
 
-				vector<const string*>* lastTempStack = nullptr;;
-				if (!tempStacks->empty())
-					lastTempStack = tempStacks->back();
+				bool hasTempStack = !tempStacks.empty();
 
 				// if a new block is opened, push a new stack into tempStacks to hold the
 				// future list of headers in the new block.
@@ -3059,24 +3016,24 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				if (newHeader == &AS_IF && lastLineHeader == &AS_ELSE)
 				{
 					if (!headerStack->empty())
-						headerStack->pop_back();
+						headerStack.write().pop_back();
 				}
 
 				// take care of 'else'
 				else if (newHeader == &AS_ELSE)
 				{
-					if (lastTempStack != nullptr)
+					if (hasTempStack)
 					{
-						int indexOfIf = indexOf(*lastTempStack, &AS_IF);
+						int indexOfIf = tempStacks.indexOfHeader(&AS_IF);
 						if (indexOfIf != -1)
 						{
 							// recreate the header list in headerStack up to the previous 'if'
-							// from the temporary snapshot stored in lastTempStack.
-							int restackSize = lastTempStack->size() - indexOfIf - 1;
+							// from the temporary snapshot stored in the last tempStack.
+							int restackSize = tempStacks.headerCount() - indexOfIf - 1;
 							for (int r = 0; r < restackSize; r++)
 							{
-								headerStack->emplace_back(lastTempStack->back());
-								lastTempStack->pop_back();
+								headerStack.write().emplace_back(tempStacks.lastHeader());
+								tempStacks.popHeader();
 							}
 							if (!closingBraceReached)
 								indentCount += restackSize;
@@ -3092,18 +3049,18 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				// check if 'while' closes a previous 'do'
 				else if (newHeader == &AS_WHILE)
 				{
-					if (lastTempStack != nullptr)
+					if (hasTempStack)
 					{
-						int indexOfDo = indexOf(*lastTempStack, &AS_DO);
+						int indexOfDo = tempStacks.indexOfHeader(&AS_DO);
 						if (indexOfDo != -1)
 						{
 							// recreate the header list in headerStack up to the previous 'do'
-							// from the temporary snapshot stored in lastTempStack.
-							int restackSize = lastTempStack->size() - indexOfDo - 1;
+							// from the temporary snapshot stored in the last tempStack.
+							int restackSize = tempStacks.headerCount() - indexOfDo - 1;
 							for (int r = 0; r < restackSize; r++)
 							{
-								headerStack->emplace_back(lastTempStack->back());
-								lastTempStack->pop_back();
+								headerStack.write().emplace_back(tempStacks.lastHeader());
+								tempStacks.popHeader();
 							}
 							if (!closingBraceReached)
 								indentCount += restackSize;
@@ -3113,20 +3070,20 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				// check if 'catch' closes a previous 'try' or 'catch'
 				else if (newHeader == &AS_CATCH || newHeader == &AS_FINALLY)
 				{
-					if (lastTempStack != nullptr)
+					if (hasTempStack)
 					{
-						int indexOfTry = indexOf(*lastTempStack, &AS_TRY);
+						int indexOfTry = tempStacks.indexOfHeader(&AS_TRY);
 						if (indexOfTry == -1)
-							indexOfTry = indexOf(*lastTempStack, &AS_CATCH);
+							indexOfTry = tempStacks.indexOfHeader(&AS_CATCH);
 						if (indexOfTry != -1)
 						{
 							// recreate the header list in headerStack up to the previous 'try'
-							// from the temporary snapshot stored in lastTempStack.
-							int restackSize = lastTempStack->size() - indexOfTry - 1;
+							// from the temporary snapshot stored in the last tempStack.
+							int restackSize = tempStacks.headerCount() - indexOfTry - 1;
 							for (int r = 0; r < restackSize; r++)
 							{
-								headerStack->emplace_back(lastTempStack->back());
-								lastTempStack->pop_back();
+								headerStack.write().emplace_back(tempStacks.lastHeader());
+								tempStacks.popHeader();
 							}
 
 							if (!closingBraceReached)
@@ -3172,7 +3129,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 
 				if (isIndentableHeader)
 				{
-					headerStack->emplace_back(newHeader);
+					headerStack.write().emplace_back(newHeader);
 					isContinuation = false;
 					if (indexOf(*nonParenHeaders, newHeader) == -1)
 					{
@@ -3302,10 +3259,10 @@ void ASBeautifier::parseCurrentLine(const string& line)
 		if ((ch == ';' || (parenDepth > 0 && ch == ',')) && !continuationIndentStackSizeStack->empty())
 			while ((int) continuationIndentStackSizeStack->back() + (parenDepth > 0 ? 1 : 0)
 			        < (int) continuationIndentStack->size())
-				continuationIndentStack->pop_back();
+				continuationIndentStack.write().pop_back();
 
 		else if (ch == ',' && isInEnum && isNonInStatementArray && !continuationIndentStack->empty())
-			continuationIndentStack->pop_back();
+			continuationIndentStack.write().pop_back();
 
 		// handle commas
 		// previous "isInStatement" will be from an assignment operator or class initializer
@@ -3332,7 +3289,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				{
 					int prevWord = getContinuationIndentComma(line, i);
 					int continuationIndentCount = prevWord + spaceIndentCount + tabIncrementIn;
-					continuationIndentStack->emplace_back(continuationIndentCount);
+					continuationIndentStack.write().emplace_back(continuationIndentCount);
 					isContinuation = true;
 				}
 			}
@@ -3351,7 +3308,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				if (braceBlockStateStack->size() > 1)
 				{
 					bool braceBlockState = braceBlockStateStack->back();
-					braceBlockStateStack->pop_back();
+					braceBlockStateStack.write().pop_back();
 					if (!braceBlockState)
 					{
 						if (!continuationIndentStackSizeStack->empty())
@@ -3365,7 +3322,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 							if (!parenIndentStack->empty())
 							{
 								int poppedIndent = parenIndentStack->back();
-								parenIndentStack->pop_back();
+								parenIndentStack.write().pop_back();
 								if (i == 0)
 									spaceIndentCount = poppedIndent;
 							}
@@ -3384,9 +3341,9 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				if (!parenDepthStack->empty())
 				{
 					parenDepth = parenDepthStack->back();
-					parenDepthStack->pop_back();
+					parenDepthStack.write().pop_back();
 					isContinuation = blockStatementStack->back();
-					blockStatementStack->pop_back();
+					blockStatementStack.write().pop_back();
 
 					if (isContinuation)
 						blockTabCount--;
@@ -3404,13 +3361,13 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					const string* popped = headerStack->back();
 					while (popped != &AS_OPEN_BRACE)
 					{
-						headerStack->pop_back();
+						headerStack.write().pop_back();
 						popped = headerStack->back();
 					}
-					headerStack->pop_back();
+					headerStack.write().pop_back();
 
 					if (headerStack->empty())
-						g_preprocessorCppExternCBrace = 0;
+						*preprocessorCppExternCBrace = 0;
 
 					// do not indent namespace brace unless namespaces are indented
 					if (!namespaceIndent && !headerStack->empty()
@@ -3419,12 +3376,8 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					        && i == 0)		// must be the first brace on the line
 						shouldIndentBracedLine = false;
 
-					if (!tempStacks->empty())
-					{
-						vector<const string*>* temp = tempStacks->back();
-						tempStacks->pop_back();
-						delete temp;
-					}
+					if (!tempStacks.empty())
+						tempStacks.popStack();
 				}
 
 				ch = ' '; // needed due to cases such as '}else{', so that headers ('else' in this case) will be identified...
@@ -3439,13 +3392,11 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			 * (such as a previous 'if' for an 'else' header) within the tempStacks,
 			 * and recreates the temporary snapshot by manipulating the tempStacks.
 			 */
-			if (!tempStacks->back()->empty())
-				while (!tempStacks->back()->empty())
-					tempStacks->back()->pop_back();
+			tempStacks.clearHeaders();
 			while (!headerStack->empty() && headerStack->back() != &AS_OPEN_BRACE)
 			{
-				tempStacks->back()->emplace_back(headerStack->back());
-				headerStack->pop_back();
+				tempStacks.pushHeader(headerStack->back());
+				headerStack.write().pop_back();
 			}
 
 			if (parenDepth == 0 && ch == ';')
@@ -3495,7 +3446,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 				                 || headerStack->back() != &AS_OPEN_BRACE)))
 				{
 					if (!isSharpStyle())
-						headerStack->emplace_back(newHeader);
+						headerStack.write().emplace_back(newHeader);
 					// do not need 'where' in the headerStack
 					// do not need second 'class' statement in a row
 					else if (!(newHeader == &AS_WHERE
@@ -3503,7 +3454,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 					               && !headerStack->empty()
 					               && (headerStack->back() == &AS_CLASS
 					                   || headerStack->back() == &AS_STRUCT))))
-						headerStack->emplace_back(newHeader);
+						headerStack.write().emplace_back(newHeader);
 
 					if (!headerStack->empty())
 					{
@@ -3518,7 +3469,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 						{
 							// remove continuationIndent from namespace
 							if (!continuationIndentStack->empty())
-								continuationIndentStack->pop_back();
+								continuationIndentStack.write().pop_back();
 							isContinuation = false;
 						}
 					}
@@ -3544,17 +3495,17 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			if (isCStyle() && findKeyword(line, i, AS_OPERATOR))
 				isInOperator = true;
 
-			if (g_preprocessorCppExternCBrace == 1 && findKeyword(line, i, AS_EXTERN))
-				++g_preprocessorCppExternCBrace;
+			if (*preprocessorCppExternCBrace == 1 && findKeyword(line, i, AS_EXTERN))
+				++*preprocessorCppExternCBrace;
 
-			if (g_preprocessorCppExternCBrace == 3)	// extern "C" is not followed by a '{'
-				g_preprocessorCppExternCBrace = 0;
+			if (*preprocessorCppExternCBrace == 3)	// extern "C" is not followed by a '{'
+				*preprocessorCppExternCBrace = 0;
 
 			// "new" operator is a pointer, not a calculation
 			if (findKeyword(line, i, AS_NEW))
 			{
 				if (isContinuation && !continuationIndentStack->empty() && prevNonSpaceCh == '=')
-					continuationIndentStack->back() = 0;
+					continuationIndentStack.write().back() = 0;
 			}
 
 			if (isCStyle() && findKeyword(line, i, AS_AUTO) && isTopLevel())
@@ -3585,8 +3536,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 			}
 
 			// bypass the entire name for all others
-			string name = getCurrentWord(line, i);
-			i += name.length() - 1;
+			i = findWordEnd(line, i) - 1;
 			continue;
 		}
 
@@ -3719,7 +3669,7 @@ void ASBeautifier::parseCurrentLine(const string& line)
 							haveAssignmentThisLine = true;
 							int prevWordIndex = getContinuationIndentAssign(line, i);
 							int continuationIndentCount = prevWordIndex + spaceIndentCount + tabIncrementIn;
-							continuationIndentStack->emplace_back(continuationIndentCount);
+							continuationIndentStack.write().emplace_back(continuationIndentCount);
 							isContinuation = true;
 						}
 					}
@@ -48,7 +48,7 @@ void ASEnhancer::init(int  _fileType,
                       bool _preprocBlockIndent,
                       bool _preprocDefineIndent,
                       bool _emptyLineFill,
-                      vector<const pair<const string, const string>* >* _indentableMacros)
+                      const vector<const pair<const string, const string>* >* _indentableMacros)
 {
 	// formatting variables from ASFormatter and ASBeautifier
 	ASBase::init(_fileType);
@@ -532,7 +532,7 @@ void ASEnhancer::parseCurrentLine(string& line, bool isInPreprocessor, bool isIn
 			if (sw.switchBraceCount == 1 && sw.unindentCase)
 				shouldUnindentComment = true;
 			isInComment = true;
-			size_t commentEnd = line.find("*/", i);
+			size_t commentEnd = ASScanner::findCommentEnd(line, i);
 			if (commentEnd == string::npos)
 				i = line.length() - 1;
 			else
@@ -554,7 +554,7 @@ void ASEnhancer::parseCurrentLine(string& line, bool isInPreprocessor, bool isIn
 			// unindent if not in case braces
 			if (sw.switchBraceCount == 1 && sw.unindentCase)
 				shouldUnindentComment = true;
-			size_t commentEnd = line.find("*/", i);
+			size_t commentEnd = ASScanner::findCommentEnd(line, i);
 			if (commentEnd == string::npos)
 				i = line.length() - 1;
 			else
@@ -575,9 +575,9 @@ void ASEnhancer::parseCurrentLine(string& line, bool isInPreprocessor, bool isIn
 		{
 			string preproc;
 			preproc = line.substr(i + 1);
-			if (preproc.substr(0, 2) == "if") // #if, #ifdef, #ifndef)
+			if (preproc.compare(0, 2, "if") == 0) // #if, #ifdef, #ifndef)
 				eventPreprocDepth += 1;
-			if (preproc.substr(0, 5) == "endif" && eventPreprocDepth > 0)
+			if (preproc.compare(0, 5, "endif") == 0 && eventPreprocDepth > 0)
 				eventPreprocDepth -= 1;
 		}
 
@@ -640,8 +640,7 @@ void ASEnhancer::parseCurrentLine(string& line, bool isInPreprocessor, bool isIn
 			// bypass the entire word
 			if (isPotentialKeyword)
 			{
-				string name = getCurrentWord(line, i);
-				i += name.length() - 1;
+				i = findWordEnd(line, i) - 1;
 			}
 			continue;
 		}
@@ -733,8 +732,7 @@ size_t ASEnhancer::processSwitchBlock(string& line, size_t index)
 	}
 	if (isPotentialKeyword)
 	{
-		string name = getCurrentWord(line, i);          // bypass the entire name
-		i += name.length() - 1;
+		i = findWordEnd(line, i) - 1;    // bypass the entire name
 	}
 	return i;
 }
@@ -28,12 +28,6 @@ namespace astyle {
 ASFormatter::ASFormatter()
 {
 	sourceIterator = nullptr;
-	enhancer = new ASEnhancer;
-	preBraceHeaderStack = nullptr;
-	braceTypeStack = nullptr;
-	parenStack = nullptr;
-	structStack = nullptr;
-	questionMarkStack = nullptr;
 	lineCommentNoIndent = false;
 	formattingStyle = STYLE_NONE;
 	braceFormatMode = NONE_MODE;
@@ -49,6 +43,7 @@ ASFormatter::ASFormatter()
 	shouldPadParensInside = false;
 	shouldPadHeader = false;
 	shouldStripCommentPrefix = false;
+	shouldVerify = false;
 	shouldUnPadParens = false;
 	attachClosingBraceMode = false;
 	shouldBreakOneLineBlocks = true;
@@ -85,17 +80,18 @@ ASFormatter::ASFormatter()
 	shouldUnPadParamType = false;
 
 	// initialize ASFormatter member vectors
+	// they point to the shared language vectors set by buildLanguageVectors()
 	formatterFileType = 9;		// reset to an invalid type
-	headers = new vector<const string*>;
-	nonParenHeaders = new vector<const string*>;
-	preDefinitionHeaders = new vector<const string*>;
-	preCommandHeaders = new vector<const string*>;
-	operators = new vector<const string*>;
-	assignmentOperators = new vector<const string*>;
-	castOperators = new vector<const string*>;
+	headers = nullptr;
+	nonParenHeaders = nullptr;
+	preDefinitionHeaders = nullptr;
+	preCommandHeaders = nullptr;
+	operators = nullptr;
+	assignmentOperators = nullptr;
+	castOperators = nullptr;
 
 	// initialize ASEnhancer member vectors
-	indentableMacros = new vector<const pair<const string, const string>* >;
+	indentableMacros = nullptr;
 }
 
 /**
@@ -103,31 +99,9 @@ ASFormatter::ASFormatter()
  */
 ASFormatter::~ASFormatter()
 {
-	// delete ASFormatter stack vectors
-	deleteContainer(preBraceHeaderStack);
-	deleteContainer(braceTypeStack);
-	deleteContainer(parenStack);
-	deleteContainer(structStack);
-	deleteContainer(questionMarkStack);
-
-	// delete ASFormatter member vectors
+	// the stack vectors and the enhancer are deleted by ASCopyPtr
+	// the member vectors are the shared language vectors and are not deleted
 	formatterFileType = 9;		// reset to an invalid type
-	delete headers;
-	delete nonParenHeaders;
-	delete preDefinitionHeaders;
-	delete preCommandHeaders;
-	delete operators;
-	delete assignmentOperators;
-	delete castOperators;
-
-	// delete ASEnhancer member vectors
-	delete indentableMacros;
-
-	// must be done when the ASFormatter object is deleted (not ASBeautifier)
-	// delete ASBeautifier member vectors
-	ASBeautifier::deleteBeautifierVectors();
-
-	delete enhancer;
 }
 
 /**
@@ -159,12 +133,14 @@ void ASFormatter::init(ASSourceIterator* si)
 	               getEmptyLineFill(),
 	               indentableMacros);
 
-	initContainer(preBraceHeaderStack, new vector<const string*>);
-	initContainer(parenStack, new vector<int>);
-	initContainer(structStack, new vector<bool>);
-	initContainer(questionMarkStack, new vector<bool>);
+	// the vectors from the previous file are cleared and reused for the new file.
+	// the memory allocated for the previous file is not allocated again.
+	preBraceHeaderStack->clear();
+	parenStack->clear();
+	structStack->clear();
+	questionMarkStack->clear();
 	parenStack->emplace_back(0);               // parenStack must contain this default entry
-	initContainer(braceTypeStack, new vector<BraceType>);
+	braceTypeStack->clear();
 	braceTypeStack->emplace_back(NULL_TYPE);   // braceTypeStack must contain this default entry
 	clearFormattedLineSplitPoints();
 
@@ -182,6 +158,8 @@ void ASFormatter::init(ASSourceIterator* si)
 	charNum = 0;
 	checksumIn = 0;
 	checksumOut = 0;
+	verifyHashIn = ASVerifyHash();
+	verifyHashOut = ASVerifyHash();
 	currentLineFirstBraceNum = string::npos;
 	formattedLineCommentNum = 0;
 	leadingSpaces = 0;
@@ -236,6 +214,7 @@ void ASFormatter::init(ASSourceIterator* si)
 	isInLineBreak = false;
 	endOfAsmReached = false;
 	endOfCodeReached = false;
+	isVerifyLinePending = false;
 	isFormattingModeOff = false;
 	isInEnum = false;
 	isInExecSQL = false;
@@ -246,6 +225,7 @@ void ASFormatter::init(ASSourceIterator* si)
 	elseHeaderFollowsComments = false;
 	caseHeaderFollowsComments = false;
 	isPreviousBraceBlockRelated = false;
+	foundUnmatchedBrace = false;
 	isInPotentialCalculation = false;
 	needHeaderOpeningBrace = false;
 	shouldBreakLineAtNextChar = false;
@@ -304,8 +284,9 @@ void ASFormatter::init(ASSourceIterator* si)
 }
 
 /**
- * build vectors for each programing language
+ * set the vectors for each programing language
  * depending on the file extension.
+ * The vectors are built once per process and shared by all objects.
  */
 void ASFormatter::buildLanguageVectors()
 {
@@ -314,23 +295,15 @@ void ASFormatter::buildLanguageVectors()
 
 	formatterFileType = getFileType();
 
-	headers->clear();
-	nonParenHeaders->clear();
-	preDefinitionHeaders->clear();
-	preCommandHeaders->clear();
-	operators->clear();
-	assignmentOperators->clear();
-	castOperators->clear();
-	indentableMacros->clear();	// ASEnhancer
-
-	ASResource::buildHeaders(headers, getFileType());
-	ASResource::buildNonParenHeaders(nonParenHeaders, getFileType());
-	ASResource::buildPreDefinitionHeaders(preDefinitionHeaders, getFileType());
-	ASResource::buildPreCommandHeaders(preCommandHeaders, getFileType());
-	ASResource::buildOperators(operators, getFileType());
-	ASResource::buildAssignmentOperators(assignmentOperators);
-	ASResource::buildCastOperators(castOperators);
-	ASResource::buildIndentableMacros(indentableMacros);	//ASEnhancer
+	const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(getFileType());
+	headers = &languageVectors.formatterHeaders;
+	nonParenHeaders = &languageVectors.formatterNonParenHeaders;
+	preDefinitionHeaders = &languageVectors.preDefinitionHeaders;
+	preCommandHeaders = &languageVectors.preCommandHeaders;
+	operators = &languageVectors.operators;
+	assignmentOperators = &languageVectors.assignmentOperators;
+	castOperators = &languageVectors.castOperators;
+	indentableMacros = &languageVectors.indentableMacros;	// ASEnhancer
 }
 
 /**
@@ -671,7 +644,7 @@ string ASFormatter::nextLine()
 			{
 				// indent the #if preprocessor blocks
 				string preproc = ASBeautifier::extractPreprocessorStatement(currentLine);
-				if (preproc.length() >= 2 && preproc.substr(0, 2) == "if") // #if, #ifdef, #ifndef
+				if (preproc.length() >= 2 && preproc.compare(0, 2, "if") == 0) // #if, #ifdef, #ifndef
 				{
 					if (isImmediatelyPostPreprocessor)
 						breakLine();
@@ -786,7 +759,7 @@ string ASFormatter::nextLine()
 			        && !isBeforeAnyComment()
 			        && (shouldBreakOneLineStatements || !isHeaderInMultiStatementLine))
 			{
-				string nextText = peekNextText(currentLine.substr(charNum));
+				string nextText = peekNextText(currentLine, charNum);
 				if (nextText.length() > 0
 				        && isCharPotentialHeader(nextText, 0)
 				        && ASBase::findHeader(nextText, 0, headers) == &AS_IF)
@@ -816,7 +789,7 @@ string ASFormatter::nextLine()
 				}
 				else if (currentHeader == &AS_ELSE)
 				{
-					string nextText = peekNextText(currentLine.substr(charNum), true);
+					string nextText = peekNextText(currentLine, charNum, true);
 					if (nextText.length() > 0
 					        && ((isCharPotentialHeader(nextText, 0)
 					             && ASBase::findHeader(nextText, 0, headers) != &AS_IF)
@@ -862,6 +835,7 @@ string ASFormatter::nextLine()
 							++charNum;
 						}
 						size_t commentLength = currentLine.length() - commentStart;
+						addVerifyHashIn(currentLine.substr(commentStart));
 						currentLine.erase(commentStart, commentLength);
 						charNum = charNumSave;
 						currentChar = currentLine[charNum];
@@ -1085,6 +1059,7 @@ string ASFormatter::nextLine()
 				{
 					previousBraceType = NULL_TYPE;
 					isPreviousBraceBlockRelated = false;
+					foundUnmatchedBrace = true;
 				}
 
 				if (!preBraceHeaderStack->empty())
@@ -1646,10 +1621,12 @@ string ASFormatter::nextLine()
 				isSharpDelegate = true;
 
 			// append the entire name
-			string name = getCurrentWord(currentLine, charNum);
+			size_t nameLength = findWordEnd(currentLine, charNum) - charNum;
 			// must pad the 'and' and 'or' operators if required
-			if (name == "and" || name == "or")
+			if (currentLine.compare(charNum, nameLength, "and") == 0
+			        || currentLine.compare(charNum, nameLength, "or") == 0)
 			{
+				string name = currentLine.substr(charNum, nameLength);
 				if (shouldPadOperators && previousNonWSChar != ':')
 				{
 					appendSpacePad();
@@ -1668,8 +1645,8 @@ string ASFormatter::nextLine()
 			}
 			else
 			{
-				appendSequence(name);
-				goForward(name.length() - 1);
+				appendSequence(currentLine, charNum, nameLength);
+				goForward(nameLength - 1);
 			}
 
 			continue;
@@ -1881,7 +1858,8 @@ string ASFormatter::nextLine()
 	// return a beautified (i.e. correctly indented) line.
 
 	string beautifiedLine;
-	size_t readyFormattedLineLength = trim(readyFormattedLine).length();
+	size_t readyFormattedLineStart;
+	size_t readyFormattedLineLength = findTrimBounds(readyFormattedLine, readyFormattedLineStart);
 	bool isInNamespace = isBraceType(braceTypeStack->back(), NAMESPACE_TYPE);
 
 	if (prependEmptyLine		// prepend a blank line before this formatted line
@@ -1922,6 +1900,7 @@ string ASFormatter::nextLine()
 
 	prependEmptyLine = false;
 	assert(computeChecksumOut(beautifiedLine));
+	addVerifyHashOut(beautifiedLine);
 	return beautifiedLine;
 }
 
@@ -2200,6 +2179,20 @@ void ASFormatter::setStripCommentPrefix(bool state)
 	shouldStripCommentPrefix = state;
 }
 
+/**
+ * Set verify mode.
+ * options:
+ *    true     hash the non-whitespace characters of the input and output.
+ *             getVerifyFailed() is true if they are different.
+ *    false    the characters are not hashed.
+ *
+ * @param state         the verify mode.
+ */
+void ASFormatter::setVerifyMode(bool state)
+{
+	shouldVerify = state;
+}
+
 /**
  * set objective-c '-' or '+' class prefix padding mode.
  * options:
@@ -2528,7 +2521,7 @@ bool ASFormatter::isBeforeAnyLineEndComment(int startPos) const
 		else if (currentLine.compare(peekNum, 2, "/*") == 0)
 		{
 			// comment must be closed on this line with nothing after it
-			size_t endNum = currentLine.find("*/", peekNum + 2);
+			size_t endNum = ASScanner::findCommentEnd(currentLine, peekNum + 2);
 			if (endNum != string::npos)
 			{
 				size_t nextChar = currentLine.find_first_not_of(" \t", endNum + 2);
@@ -2555,7 +2548,7 @@ bool ASFormatter::isBeforeMultipleLineEndComments(int startPos) const
 		if (currentLine.compare(peekNum, 2, "/*") == 0)
 		{
 			// comment must be closed on this line with nothing after it
-			size_t endNum = currentLine.find("*/", peekNum + 2);
+			size_t endNum = ASScanner::findCommentEnd(currentLine, peekNum + 2);
 			if (endNum != string::npos)
 			{
 				size_t nextChar = currentLine.find_first_not_of(" \t", endNum + 2);
@@ -2614,6 +2607,12 @@ bool ASFormatter::getNextChar()
  */
 bool ASFormatter::getNextLine(bool emptyLineWasDeleted /*false*/)
 {
+	// the verify hash includes the braces added and removed on the line
+	if (isVerifyLinePending)
+	{
+		addVerifyHashIn(currentLine);
+		isVerifyLinePending = false;
+	}
 	if (!sourceIterator->hasMoreLines())
 	{
 		endOfCodeReached = true;
@@ -2626,6 +2625,7 @@ bool ASFormatter::getNextLine(bool emptyLineWasDeleted /*false*/)
 		currentLine = sourceIterator->nextLine(emptyLineWasDeleted);
 		assert(computeChecksumIn(currentLine));
 	}
+	isVerifyLinePending = true;
 	// reset variables for new line
 	inLineNumber++;
 	if (endOfAsmReached)
@@ -2771,7 +2771,7 @@ void ASFormatter::initNewLine()
 	{
 		doesLineStartComment = true;
 		if ((int) currentLine.length() > charNum + 2
-		        && currentLine.find("*/", charNum + 2) != string::npos)
+		        && ASScanner::findCommentEnd(currentLine, charNum + 2) != string::npos)
 			lineIsCommentOnly = true;
 	}
 	else if (isSequenceReached("//"))
@@ -2858,6 +2858,23 @@ void ASFormatter::appendSequence(const string& sequence, bool canBreakLine)
 		testForTimeToSplitFormattedLine();
 }
 
+/**
+ * Append part of a line to the current formatted line.
+ * Same as appendSequence() without making a copy of the part.
+ *
+ * @param line             the line containing the sequence.
+ * @param start            the position of the sequence in the line.
+ * @param length           the length of the sequence.
+ */
+void ASFormatter::appendSequence(const string& line, size_t start, size_t length)
+{
+	if (isInLineBreak)
+		breakLine();
+	formattedLine.append(line, start, length);
+	if (formattedLine.length() > maxCodeLength)
+		testForTimeToSplitFormattedLine();
+}
+
 /**
  * Append an operator sequence to the current formatted line.
  * The formattedLine split points are updated.
@@ -3174,13 +3191,13 @@ bool ASFormatter::isPointerOrReference() const
 		lastWord = " ";
 
 	// check for preceding or following numeric values
-	string nextText = peekNextText(currentLine.substr(charNum + 1));
-	if (nextText.length() == 0)
-		nextText = " ";
+	char nextTextChar = peekNextTextChar(currentLine, charNum + 1);
+	if (nextTextChar == '\0')
+		nextTextChar = ' ';
 	if (isDigit(lastWord[0])
-	        || isDigit(nextText[0])
-	        || nextText[0] == '!'
-	        || nextText[0] == '~')
+	        || isDigit(nextTextChar)
+	        || nextTextChar == '!'
+	        || nextTextChar == '~')
 		return false;
 
 	// check for multiply then a dereference (a * *b)
@@ -3211,7 +3228,7 @@ bool ASFormatter::isPointerOrReference() const
 			return true;
 		string followingText;
 		if ((int) currentLine.length() > charNum + 2)
-			followingText = peekNextText(currentLine.substr(charNum + 2));
+			followingText = peekNextText(currentLine, charNum + 2);
 		if (followingText.length() > 0 && followingText[0] == ')')
 			return true;
 		if (currentHeader != nullptr || isInPotentialCalculation)
@@ -3353,13 +3370,13 @@ bool ASFormatter::isDereferenceOrAddressOf() const
 	            || parenStack->back() != 0))
 		return true;
 
-	string nextText = peekNextText(currentLine.substr(charNum + 1));
-	if (nextText.length() > 0)
+	char nextTextChar = peekNextTextChar(currentLine, charNum + 1);
+	if (nextTextChar != '\0')
 	{
-		if (nextText[0] == ')' || nextText[0] == '>'
-		        || nextText[0] == ',' || nextText[0] == '=')
+		if (nextTextChar == ')' || nextTextChar == '>'
+		        || nextTextChar == ',' || nextTextChar == '=')
 			return false;
-		if (nextText[0] == ';')
+		if (nextTextChar == ';')
 			return true;
 	}
 
@@ -3380,7 +3397,7 @@ bool ASFormatter::isDereferenceOrAddressOf() const
 		return false;
 
 	bool isDA = (!(isLegalNameChar(previousNonWSChar) || previousNonWSChar == '>')
-	             || (nextText.length() > 0 && !isLegalNameChar(nextText[0]) && nextText[0] != '/')
+	             || (nextTextChar != '\0' && !isLegalNameChar(nextTextChar) && nextTextChar != '/')
 	             || (ispunct((unsigned char)previousNonWSChar) && previousNonWSChar != '.')
 	             || isCharImmediatelyPostReturn);
 
@@ -3597,18 +3614,18 @@ int ASFormatter::isOneLineBlockReached(const string& line, int startChar) const
 
 	for (int i = startChar; i < lineLength; ++i)
 	{
-		ch = line[i];
-
 		if (isInComment_)
 		{
-			if (line.compare(i, 2, "*/") == 0)
-			{
-				isInComment_ = false;
-				++i;
-			}
+			size_t commentEnd = ASScanner::findCommentEnd(line, i);
+			if (commentEnd == string::npos)
+				break;
+			isInComment_ = false;
+			i = commentEnd + 1;
 			continue;
 		}
 
+		ch = line[i];
+
 		if (isInQuote_)
 		{
 			if (ch == '\\')
@@ -3618,6 +3635,23 @@ int ASFormatter::isOneLineBlockReached(const string& line, int startChar) const
 			continue;
 		}
 
+		// bypass the text up to the next quote, comment, brace, or semicolon
+		size_t syntaxChar = ASScanner::findSyntaxChar(line, i);
+		if (syntaxChar != (size_t) i)
+		{
+			size_t textEnd = (syntaxChar == string::npos) ? lineLength : syntaxChar;
+			size_t lastText = ASScanner::findLastNonBlank(line, textEnd - 1);
+			if (lastText != string::npos && lastText >= (size_t) i)
+			{
+				hasText = true;
+				prevCh = line[lastText];
+			}
+			if (syntaxChar == string::npos)
+				break;
+			i = syntaxChar;
+			ch = line[i];
+		}
+
 		if (ch == '"'
 		        || (ch == '\'' && !isDigitSeparator(line, i)))
 		{
@@ -3649,7 +3683,7 @@ int ASFormatter::isOneLineBlockReached(const string& line, int startChar) const
 				// is this an array?
 				if (parenStack->back() == 0 && prevCh != '}')
 				{
-					size_t peekNum = line.find_first_not_of(" \t", i + 1);
+					size_t peekNum = ASScanner::findNonBlank(line, i + 1);
 					if (peekNum != string::npos && line[peekNum] == ',')
 						return 2;
 				}
@@ -3680,7 +3714,7 @@ int ASFormatter::isOneLineBlockReached(const string& line, int startChar) const
 bool ASFormatter::isNextWordSharpNonParenHeader(int startChar) const
 {
 	// look ahead to find the next non-comment text
-	string nextText = peekNextText(currentLine.substr(startChar));
+	string nextText = peekNextText(currentLine, startChar);
 	if (nextText.length() == 0)
 		return false;
 	if (nextText[0] == '[')
@@ -3704,7 +3738,7 @@ bool ASFormatter::isNextWordSharpNonParenHeader(int startChar) const
 bool ASFormatter::isNextCharOpeningBrace(int startChar) const
 {
 	bool retVal = false;
-	string nextText = peekNextText(currentLine.substr(startChar));
+	string nextText = peekNextText(currentLine, startChar);
 	if (nextText.length() > 0
 	        && nextText.compare(0, 1, "{") == 0)
 		retVal = true;
@@ -3726,7 +3760,7 @@ bool ASFormatter::isOperatorPaddingDisabled() const
 		// comment must end on this line
 		if (commentStart != string::npos)
 		{
-			size_t commentEnd = currentLine.find("*/", commentStart + 2);
+			size_t commentEnd = ASScanner::findCommentEnd(currentLine, commentStart + 2);
 			if (commentEnd == string::npos)
 				commentStart = string::npos;
 		}
@@ -3830,32 +3864,46 @@ bool ASFormatter::isMultiStatementLine() const
 
 /**
  * get the next non-whitespace substring on following lines, bypassing all comments.
+ * the first line is checked in place from firstLineStart, so callers do not
+ * need to copy it. the peek stream is not opened unless the first line is used up.
  *
- * @param   firstLine   the first line to check
+ * @param   firstLine       the first line to check
+ * @param   firstLineStart  the position in firstLine to start the check
  * @return  the next non-whitespace substring.
  */
 string ASFormatter::peekNextText(const string& firstLine,
+                                 size_t firstLineStart /*0*/,
                                  bool endOnEmptyLine /*false*/,
                                  shared_ptr<ASPeekStream> streamArg /*nullptr*/) const
 {
 	assert(sourceIterator->getPeekStart() == 0 || streamArg != nullptr);	// Borland may need != 0
 	bool isFirstLine = true;
-	string nextLine_ = firstLine;
+	const string* nextLine_ = &firstLine;
+	string peekedLine;
 	size_t firstChar = string::npos;
 	shared_ptr<ASPeekStream> stream = streamArg;
-	if (stream == nullptr)					// Borland may need == 0
-		stream = make_shared<ASPeekStream>(sourceIterator);
 
 	// find the first non-blank text, bypassing all comments.
 	bool isInComment_ = false;
-	while (stream->hasMoreLines() || isFirstLine)
+	while (true)
 	{
+		size_t lineStart = 0;
 		if (isFirstLine)
+		{
 			isFirstLine = false;
+			lineStart = firstLineStart;
+		}
 		else
-			nextLine_ = stream->peekNextLine();
+		{
+			if (stream == nullptr)				// Borland may need == 0
+				stream = make_shared<ASPeekStream>(sourceIterator);
+			if (!stream->hasMoreLines())
+				break;
+			peekedLine = stream->peekNextLine();
+			nextLine_ = &peekedLine;
+		}
 
-		firstChar = nextLine_.find_first_not_of(" \t");
+		firstChar = ASScanner::findNonBlank(*nextLine_, lineStart);
 		if (firstChar == string::npos)
 		{
 			if (endOnEmptyLine && !isInComment_)
@@ -3863,7 +3911,7 @@ string ASFormatter::peekNextText(const string& firstLine,
 			continue;
 		}
 
-		if (nextLine_.compare(firstChar, 2, "/*") == 0)
+		if (nextLine_->compare(firstChar, 2, "/*") == 0)
 		{
 			firstChar += 2;
 			isInComment_ = true;
@@ -3871,17 +3919,17 @@ string ASFormatter::peekNextText(const string& firstLine,
 
 		if (isInComment_)
 		{
-			firstChar = nextLine_.find("*/", firstChar);
+			firstChar = ASScanner::findCommentEnd(*nextLine_, firstChar);
 			if (firstChar == string::npos)
 				continue;
 			firstChar += 2;
 			isInComment_ = false;
-			firstChar = nextLine_.find_first_not_of(" \t", firstChar);
+			firstChar = ASScanner::findNonBlank(*nextLine_, firstChar);
 			if (firstChar == string::npos)
 				continue;
 		}
 
-		if (nextLine_.compare(firstChar, 2, "//") == 0)
+		if (nextLine_->compare(firstChar, 2, "//") == 0)
 			continue;
 
 		// found the next text
@@ -3889,10 +3937,30 @@ string ASFormatter::peekNextText(const string& firstLine,
 	}
 
 	if (firstChar == string::npos)
-		nextLine_ = "";
-	else
-		nextLine_ = nextLine_.substr(firstChar);
-	return nextLine_;
+		return string();
+	return nextLine_->substr(firstChar);
+}
+
+/**
+ * get the first character of the next text, bypassing all comments.
+ * the following lines are peeked only if the text is not on the first line,
+ * so the usual case does not copy anything.
+ *
+ * @param   firstLine       the first line to check
+ * @param   firstLineStart  the position in firstLine to start the check
+ * @return  the first character of the next text, or '\0' if there is none.
+ */
+char ASFormatter::peekNextTextChar(const string& firstLine, size_t firstLineStart) const
+{
+	size_t firstChar = ASScanner::findNonBlank(firstLine, firstLineStart);
+	if (firstChar != string::npos
+	        && firstLine.compare(firstChar, 2, "/*") != 0
+	        && firstLine.compare(firstChar, 2, "//") != 0)
+		return firstLine[firstChar];
+	string nextText = peekNextText(firstLine, firstLineStart);
+	if (nextText.empty())
+		return '\0';
+	return nextText[0];
 }
 
 /**
@@ -3908,7 +3976,7 @@ void ASFormatter::adjustComments()
 	// block comment must be closed on this line with nothing after it
 	if (isSequenceReached("/*"))
 	{
-		size_t endNum = currentLine.find("*/", charNum + 2);
+		size_t endNum = ASScanner::findCommentEnd(currentLine, charNum + 2);
 		if (endNum == string::npos)
 			return;
 		// following line comments may be a tag from AStyleWx //[[)>
@@ -5086,7 +5154,7 @@ void ASFormatter::formatClosingBrace(BraceType braceType)
 		if (currentHeader == &AS_CASE || currentHeader == &AS_DEFAULT)
 		{
 			// do not yet insert a line if "break" statement is outside the braces
-			string nextText = peekNextText(currentLine.substr(charNum + 1));
+			string nextText = peekNextText(currentLine, charNum + 1);
 			if (nextText.length() > 0
 			        && nextText.substr(0, 5) != "break")
 				isAppendPostBlockEmptyLineRequested = true;
@@ -5187,6 +5255,7 @@ void ASFormatter::formatArrayBraces(BraceType braceType, bool isOpeningArrayBrac
 					if (isBeforeAnyLineEndComment(charNum) && !currentLineBeginsWithBrace)
 					{
 						currentChar = ' ';            // remove brace from current line
+						currentLine[charNum] = currentChar;
 						appendOpeningBrace = true;    // append brace to following line
 					}
 				}
@@ -5213,6 +5282,7 @@ void ASFormatter::formatArrayBraces(BraceType braceType, bool isOpeningArrayBrac
 					if (isBeforeAnyLineEndComment(charNum) && !currentLineBeginsWithBrace)
 					{
 						currentChar = ' ';            // remove brace from current line
+						currentLine[charNum] = currentChar;
 						appendOpeningBrace = true;    // append brace to following line
 					}
 				}
@@ -5450,62 +5520,6 @@ void ASFormatter::formatArrayRunIn()
 	isInLineBreak = false;
 }
 
-/**
- * delete a braceTypeStack vector object
- * BraceTypeStack did not work with the DeleteContainer template
- */
-void ASFormatter::deleteContainer(vector<BraceType>*& container)
-{
-	if (container != nullptr)
-	{
-		container->clear();
-		delete (container);
-		container = nullptr;
-	}
-}
-
-/**
- * delete a vector object
- * T is the type of vector
- * used for all vectors except braceTypeStack
- */
-template<typename T>
-void ASFormatter::deleteContainer(T& container)
-{
-	if (container != nullptr)
-	{
-		container->clear();
-		delete (container);
-		container = nullptr;
-	}
-}
-
-/**
- * initialize a braceType vector object
- * braceType did not work with the DeleteContainer template
- */
-void ASFormatter::initContainer(vector<BraceType>*& container, vector<BraceType>* value)
-{
-	if (container != nullptr)
-		deleteContainer(container);
-	container = value;
-}
-
-/**
- * initialize a vector object
- * T is the type of vector
- * used for all vectors except braceTypeStack
- */
-template<typename T>
-void ASFormatter::initContainer(T& container, T value)
-{
-	// since the ASFormatter object is never deleted,
-	// the existing vectors must be deleted before creating new ones
-	if (container != nullptr)
-		deleteContainer(container);
-	container = value;
-}
-
 /**
  * convert a tab to spaces.
  * charNum points to the current character to convert to spaces.
@@ -5572,7 +5586,7 @@ const string* ASFormatter::checkForHeaderFollowingComment(const string& firstLin
 	bool endOnEmptyLine = (currentHeader == nullptr);
 	if (isInSwitchStatement())
 		endOnEmptyLine = false;
-	string nextText = peekNextText(firstLine, endOnEmptyLine);
+	string nextText = peekNextText(firstLine, 0, endOnEmptyLine);
 
 	if (nextText.length() == 0 || !isCharPotentialHeader(nextText, 0))
 		return nullptr;
@@ -5634,7 +5648,7 @@ bool ASFormatter::commentAndHeaderFollows()
 		return false;
 
 	// find the next non-comment text, and reset
-	string nextText = peekNextText(nextLine_, false, stream);
+	string nextText = peekNextText(nextLine_, 0, false, stream);
 	if (nextText.length() == 0 || !isCharPotentialHeader(nextText, 0))
 		return false;
 
@@ -5767,6 +5781,15 @@ void ASFormatter::formatCommentBody()
 {
 	assert(isInComment);
 
+	// append the comment up to the closer at once if the characters need no checks
+	if (maxCodeLength == string::npos && !shouldConvertTabs)
+	{
+		size_t commentEnd = ASScanner::findCommentEnd(currentLine, charNum);
+		if (commentEnd == string::npos)
+			commentEnd = currentLine.length();
+		appendCommentText(commentEnd);
+	}
+
 	// append the comment
 	while (charNum < (int) currentLine.length())
 	{
@@ -5785,6 +5808,28 @@ void ASFormatter::formatCommentBody()
 		stripCommentPrefix();
 }
 
+/**
+ * append the comment text from charNum to textEnd to the formatted line.
+ * used for a comment when the characters do not need to be checked
+ * for line splitting or tab conversion.
+ * charNum and currentChar are left as if each character had been appended.
+ *
+ * @param textEnd      the position following the last character to append.
+ */
+void ASFormatter::appendCommentText(size_t textEnd)
+{
+	assert(isInComment || isInLineComment);
+	assert(maxCodeLength == string::npos && !shouldConvertTabs);
+	if (textEnd <= (size_t) charNum)
+		return;
+	if (isInLineBreak)
+		breakLine();
+	formattedLine.append(currentLine, charNum, textEnd - charNum);
+	isImmediatelyPostCommentOnly = false;
+	charNum = textEnd;
+	currentChar = currentLine[charNum - 1];
+}
+
 /**
  * format a comment opener
  * the comment opener will be appended to the current formattedLine or a new formattedLine as necessary
@@ -5917,6 +5962,10 @@ void ASFormatter::formatLineCommentBody()
 {
 	assert(isInLineComment);
 
+	// append the comment at once if the characters need no checks
+	if (maxCodeLength == string::npos && !shouldConvertTabs)
+		appendCommentText(currentLine.length());
+
 	// append the comment
 	while (charNum < (int) currentLine.length())
 //	        && !isLineReady	// commented out in release 2.04, unnecessary
@@ -6501,7 +6550,7 @@ size_t ASFormatter::findNextChar(const string& line, char searchChar, int search
 			return string::npos;
 		if (line.compare(i, 2, "/*") == 0)
 		{
-			size_t endComment = line.find("*/", i + 2);
+			size_t endComment = ASScanner::findCommentEnd(line, i + 2);
 			if (endComment == string::npos)
 				return string::npos;
 			i = endComment + 2;
@@ -6892,8 +6941,7 @@ bool ASFormatter::isStructAccessModified(const string& firstLine, size_t index)
 				        || findKeyword(nextLine_, i, AS_PRIVATE)
 				        || findKeyword(nextLine_, i, AS_PROTECTED))
 					return true;
-				string name = getCurrentWord(nextLine_, i);
-				i += name.length() - 1;
+				i = findWordEnd(nextLine_, i) - 1;
 			}
 		}	// end of for loop
 	}	// end of while loop
@@ -6978,7 +7026,7 @@ bool ASFormatter::isIndentablePreprocessorBlock(const string& firstLine, size_t
 			if (nextLine_[i] == '#')
 			{
 				string preproc = ASBeautifier::extractPreprocessorStatement(nextLine_);
-				if (preproc.length() >= 2 && preproc.substr(0, 2) == "if") // #if, #ifdef, #ifndef
+				if (preproc.length() >= 2 && preproc.compare(0, 2, "if") == 0) // #if, #ifdef, #ifndef
 				{
 					numBlockIndents += 1;
 					isInIndentableBlock = true;
@@ -7044,7 +7092,7 @@ EndOfWhileLoop:
 		isInIndentableBlock = false;
 	// find next executable instruction
 	// this WILL RESET the get pointer
-	string nextText = peekNextText("", false, stream);
+	string nextText = peekNextText(string(), 0, false, stream);
 	// bypass header include guards
 	if (isFirstPreprocConditional)
 	{
@@ -7350,8 +7398,7 @@ void ASFormatter::checkIfTemplateOpener()
 				templateDepth = 0;
 				return;
 			}
-			string name = getCurrentWord(nextLine_, i);
-			i += name.length() - 1;
+			i = findWordEnd(nextLine_, i) - 1;
 		}	// end for loop
 	}	// end while loop
 }
@@ -7737,7 +7784,7 @@ size_t ASFormatter::findFormattedLineSplitPoint() const
 		// if end of the currentLine, find a new split point
 		size_t newCharNum;
 		if (!isWhiteSpace(currentChar) && isCharPotentialHeader(currentLine, charNum))
-			newCharNum = getCurrentWord(currentLine, charNum).length() + charNum;
+			newCharNum = findWordEnd(currentLine, charNum);
 		else
 			newCharNum = charNum + 2;
 		if (newCharNum + 1 > currentLine.length())
@@ -7822,6 +7869,24 @@ bool ASFormatter::computeChecksumOut(const string& beautifiedLine)
 	return true;
 }
 
+/**
+ * Return true if all of the braces opened since init have been closed,
+ * and there have been no closing braces without an opening brace.
+ * Used by AStyleMainRange to find the end of a range.
+ */
+bool ASFormatter::getBracesAreBalanced() const
+{
+	return braceTypeStack->size() == 1 && !foundUnmatchedBrace;
+}
+
+/**
+ * Return true if a closing brace without an opening brace has been found.
+ */
+bool ASFormatter::getFoundUnmatchedBrace() const
+{
+	return foundUnmatchedBrace;
+}
+
 /**
  * Return isLineReady for the final check at end of file.
  */
@@ -7849,6 +7914,60 @@ int ASFormatter::getChecksumDiff() const
 	return checksumOut - checksumIn;
 }
 
+/**
+ * Return true if the verify hashes of the input and output are different.
+ * The non-whitespace characters have been changed by the formatting.
+ * Valid after all of the lines have been formatted.
+ */
+bool ASFormatter::getVerifyFailed() const
+{
+	return shouldVerify && verifyHashIn != verifyHashOut;
+}
+
+/**
+ * Return true if the verify option is set.
+ */
+bool ASFormatter::getVerifyMode() const
+{
+	return shouldVerify;
+}
+
+/**
+ * Compute the verify hash of a text, for unit testing.
+ * The lines are separated by '\n' characters.
+ *
+ * @param text          the text to hash.
+ * @return              the hash of the text.
+ */
+uint64_t ASFormatter::computeVerifyHash(const string& text)
+{
+	ASVerifyHash verifyHash;
+	size_t lineStart = 0;
+	while (lineStart <= text.length())
+	{
+		size_t lineEnd = text.find('\n', lineStart);
+		if (lineEnd == string::npos)
+			lineEnd = text.length();
+		verifyHash.addLine(text.substr(lineStart, lineEnd - lineStart));
+		lineStart = lineEnd + 1;
+	}
+	return verifyHash.getHash();
+}
+
+// add a line of the input to the input verify hash
+void ASFormatter::addVerifyHashIn(const string& text)
+{
+	if (shouldVerify)
+		verifyHashIn.addLine(text);
+}
+
+// add a line of the output to the output verify hash
+void ASFormatter::addVerifyHashOut(const string& text)
+{
+	if (shouldVerify)
+		verifyHashOut.addLine(text);
+}
+
 // for unit testing
 int ASFormatter::getFormatterFileType() const
 {
@@ -8158,7 +8277,7 @@ void ASFormatter::stripCommentPrefix()
 			return;
 		int commentOpener = firstChar;
 		// ignore single line comments
-		int commentEnd = formattedLine.find("*/", firstChar + 2);
+		int commentEnd = ASScanner::findCommentEnd(formattedLine, firstChar + 2);
 		if (commentEnd != -1)
 			return;
 		// first char after the comment opener must be at least one indent
@@ -8242,4 +8361,244 @@ void ASFormatter::stripCommentPrefix()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// ASCheckpoint class
+//-----------------------------------------------------------------------------
+
+/**
+ * Constructor of ASCheckpoint
+ * Save the state of an initialized formatter between two calls to nextLine().
+ *
+ * @param formatter_    the formatter to be saved.
+ * @param lineNumber_   the number of lines output by the formatter.
+ */
+ASCheckpoint::ASCheckpoint(const ASFormatter& formatter_, int lineNumber_)
+{
+	assert(formatter_.sourceIterator != nullptr);
+	assert(formatter_.sourceIterator->getPeekStart() == 0);
+	formatter = copyFormatter(formatter_);
+	streamPosition = formatter_.sourceIterator->tellg();
+	lineNumber = lineNumber_;
+}
+
+/**
+ * Destructor of ASCheckpoint
+ */
+ASCheckpoint::~ASCheckpoint()
+{
+	delete formatter;
+}
+
+/**
+ * Create a formatter that resumes formatting at the checkpoint.
+ * The formatter is NOT initialized, init() would discard the saved state.
+ * The caller must delete the returned object.
+ *
+ * @param si    a source iterator for the same source positioned at getStreamPosition().
+ * @return      a new formatter that continues with the line after getLineNumber().
+ */
+ASFormatter* ASCheckpoint::resumeFormatter(ASSourceIterator* si) const
+{
+	assert(si->tellg() == streamPosition);
+	ASFormatter* resumed = copyFormatter(*formatter);
+	resumed->sourceIterator = si;
+	return resumed;
+}
+
+/**
+ * Copy a formatter with the complete parse state.
+ * The ASFormatter copy constructor is a member-wise copy, the stack vectors
+ * are copied by ASCopyPtr. The ASBeautifier copy constructor shares the
+ * beautifier stacks with the original, so they are copied here.
+ *
+ * @param formatter_    the formatter to be copied.
+ * @return              a new formatter that must be deleted by the caller.
+ */
+ASFormatter* ASCheckpoint::copyFormatter(const ASFormatter& formatter_)
+{
+	ASFormatter* copy = new ASFormatter(formatter_);
+	copy->copyBeautifierStacks(formatter_);
+	return copy;
+}
+
+//-----------------------------------------------------------------------------
+// ASVerifyHash class
+//-----------------------------------------------------------------------------
+
+/**
+ * Constructor of ASVerifyHash
+ * The hashes are 64 bit FNV-1a hashes of the characters.
+ */
+ASVerifyHash::ASVerifyHash()
+	: codeHash(0xcbf29ce484222325ULL), commentHash(0xcbf29ce484222325ULL),
+	  textState(CODE_TEXT), quoteChar('"')
+{ }
+
+/**
+ * Add the non-whitespace characters of a line to the hash.
+ * The characters in comments are added to the comment hash, and all other
+ * characters, including quotes, are added to the code hash. The stars in
+ * block comments are not added because the formatter may remove them.
+ *
+ * @param line          the line to add, without the line end.
+ */
+void ASVerifyHash::addLine(const string& line)
+{
+	const size_t lineLength = line.length();
+	bool isInLineComment = false;
+	for (size_t i = 0; i < lineLength; i++)
+	{
+		const char ch = line[i];
+		if (ch == ' ' || ch == '\t')
+			continue;
+		if (isInLineComment)
+		{
+			addChar(commentHash, ch);
+			continue;
+		}
+		if (textState == COMMENT_TEXT)
+		{
+			if (ch == '*' && i + 1 < lineLength && line[i + 1] == '/')
+			{
+				addChar(commentHash, '/');
+				textState = CODE_TEXT;
+				i++;
+			}
+			else if (ch != '*')
+				addChar(commentHash, ch);
+			continue;
+		}
+		if (textState == QUOTE_TEXT)
+		{
+			addChar(codeHash, ch);
+			if (ch == '\\' && i + 1 < lineLength)
+				addChar(codeHash, line[++i]);
+			else if (ch == quoteChar)
+				textState = CODE_TEXT;
+			continue;
+		}
+		if (textState == RAW_STRING_TEXT)
+		{
+			if (line.compare(i, rawStringEnd.length(), rawStringEnd) == 0)
+			{
+				for (char endChar : rawStringEnd)
+					addChar(codeHash, endChar);
+				i += rawStringEnd.length() - 1;
+				textState = CODE_TEXT;
+			}
+			else
+				addChar(codeHash, ch);
+			continue;
+		}
+		if (textState == VERBATIM_TEXT)
+		{
+			addChar(codeHash, ch);
+			if (ch == '"')
+			{
+				if (i + 1 < lineLength && line[i + 1] == '"')
+					addChar(codeHash, line[++i]);
+				else
+					textState = CODE_TEXT;
+			}
+			continue;
+		}
+		// code text
+		if (ch == '/' && i + 1 < lineLength && line[i + 1] == '/')
+		{
+			isInLineComment = true;
+			addChar(commentHash, ch);
+			continue;
+		}
+		if (ch == '/' && i + 1 < lineLength && line[i + 1] == '*')
+		{
+			textState = COMMENT_TEXT;
+			addChar(commentHash, ch);
+			i++;
+			continue;
+		}
+		addChar(codeHash, ch);
+		if (ch == '"')
+		{
+			size_t rawOpener = isRawStringStart(line, i) ? line.find('(', i) : string::npos;
+			if (rawOpener != string::npos)
+			{
+				rawStringEnd = ")" + line.substr(i + 1, rawOpener - i - 1) + "\"";
+				textState = RAW_STRING_TEXT;
+			}
+			else if (i > 0 && line[i - 1] == '@')
+				textState = VERBATIM_TEXT;
+			else
+			{
+				quoteChar = ch;
+				textState = QUOTE_TEXT;
+			}
+		}
+		else if (ch == '\'' && !isDigitSeparator(line, i))
+		{
+			quoteChar = ch;
+			textState = QUOTE_TEXT;
+		}
+	}
+	// a quote ends at the line end unless it is continued
+	if (textState == QUOTE_TEXT && (lineLength == 0 || line[lineLength - 1] != '\\'))
+		textState = CODE_TEXT;
+}
+
+// compare the code and comment hashes
+bool ASVerifyHash::operator==(const ASVerifyHash& other) const
+{
+	return codeHash == other.codeHash && commentHash == other.commentHash;
+}
+
+// get a single value for the code and comment hashes
+uint64_t ASVerifyHash::getHash() const
+{
+	return codeHash ^ (commentHash * 0x9e3779b97f4a7c15ULL);
+}
+
+// add a character to an FNV-1a hash
+void ASVerifyHash::addChar(uint64_t& hash, char ch)
+{
+	if (ch == ' ' || ch == '\t')
+		return;
+	hash ^= (unsigned char) ch;
+	hash *= 0x100000001b3ULL;
+}
+
+// check if a quote at position i is a C++14 digit separator (1'000)
+// the number containing it must start with a digit
+bool ASVerifyHash::isDigitSeparator(const string& line, size_t i)
+{
+	assert(line[i] == '\'');
+	if (i == 0 || i + 1 >= line.length() || !isNameChar(line[i + 1]))
+		return false;
+	size_t numberStart = i;
+	while (numberStart > 0
+	        && (isNameChar(line[numberStart - 1]) || line[numberStart - 1] == '\''))
+		numberStart--;
+	return numberStart < i && isdigit((unsigned char) line[numberStart]);
+}
+
+// check if a quote at position i starts a C++11 raw string
+// the prefix may be R, LR, uR, UR, or u8R
+bool ASVerifyHash::isRawStringStart(const string& line, size_t i)
+{
+	assert(line[i] == '"');
+	if (i == 0 || line[i - 1] != 'R')
+		return false;
+	size_t prefixStart = i - 1;
+	if (prefixStart >= 2 && line.compare(prefixStart - 2, 2, "u8") == 0)
+		prefixStart -= 2;
+	else if (prefixStart >= 1
+	         && (line[prefixStart - 1] == 'L' || line[prefixStart - 1] == 'u' || line[prefixStart - 1] == 'U'))
+		prefixStart--;
+	return prefixStart == 0 || !isNameChar(line[prefixStart - 1]);
+}
+
+// check if a character can be part of a name or a number
+bool ASVerifyHash::isNameChar(char ch)
+{
+	return isalnum((unsigned char) ch) || ch == '_' || (unsigned char) ch >= 128;
+}
+
 }   // end namespace astyle
@@ -437,6 +437,7 @@ Bulgarian::Bulgarian()	// български
 	addPair("Did you intend to use --recursive", L"Знаете ли възнамерявате да използвате --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Не може да са UTF-32 кодиране");
 	addPair("Artistic Style has terminated\n", L"Artistic Style е прекратено\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s попадения в кеша   %s пропуска в кеша\n");
 }
 
 ChineseSimplified::ChineseSimplified()	// 中文（简体）
@@ -471,6 +472,7 @@ ChineseSimplified::ChineseSimplified()	// 中文（简体）
 	addPair("Did you intend to use --recursive", L"你打算使用 --recursive");
 	addPair("Cannot process UTF-32 encoding", L"不能处理UTF-32编码");
 	addPair("Artistic Style has terminated\n", L"Artistic Style 已经终止运行\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s 缓存命中   %s 缓存未命中\n");
 }
 
 ChineseTraditional::ChineseTraditional()	// 中文（繁體）
@@ -505,6 +507,7 @@ ChineseTraditional::ChineseTraditional()	// 中文（繁體）
 	addPair("Did you intend to use --recursive", L"你打算使用 --recursive");
 	addPair("Cannot process UTF-32 encoding", L"不能處理UTF-32編碼");
 	addPair("Artistic Style has terminated\n", L"Artistic Style 已經終止運行\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s 快取命中   %s 快取未命中\n");
 }
 
 Dutch::Dutch()	// Nederlandse
@@ -539,6 +542,7 @@ Dutch::Dutch()	// Nederlandse
 	addPair("Did you intend to use --recursive", L"Hebt u van plan bent te gebruiken --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Kan niet verwerken UTF-32 codering");
 	addPair("Artistic Style has terminated\n", L"Artistic Style heeft beëindigd\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s cachetreffers   %s cachemissers\n");
 }
 
 English::English()
@@ -577,6 +581,7 @@ Estonian::Estonian()	// Eesti
 	addPair("Did you intend to use --recursive", L"Kas te kavatsete kasutada --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Ei saa töödelda UTF-32 kodeeringus");
 	addPair("Artistic Style has terminated\n", L"Artistic Style on lõpetatud\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s vahemälu tabamust   %s vahemälu möödalasku\n");
 }
 
 Finnish::Finnish()	// Suomeksi
@@ -611,6 +616,7 @@ Finnish::Finnish()	// Suomeksi
 	addPair("Did you intend to use --recursive", L"Oliko aiot käyttää --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Ei voi käsitellä UTF-32 koodausta");
 	addPair("Artistic Style has terminated\n", L"Artistic Style on päättynyt\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s välimuistiosumaa   %s välimuistin ohitusta\n");
 }
 
 French::French()	// Française
@@ -645,6 +651,7 @@ French::French()	// Française
 	addPair("Did you intend to use --recursive", L"Avez-vous l'intention d'utiliser --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Impossible de traiter codage UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style a mis fin\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s succès du cache   %s échecs du cache\n");
 }
 
 German::German()	// Deutsch
@@ -679,6 +686,7 @@ German::German()	// Deutsch
 	addPair("Did you intend to use --recursive", L"Haben Sie verwenden möchten --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Nicht verarbeiten kann UTF-32 Codierung");
 	addPair("Artistic Style has terminated\n", L"Artistic Style ist beendet\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s Cache-Treffer   %s Cache-Fehlschläge\n");
 }
 
 Greek::Greek()	// ελληνικά
@@ -713,6 +721,7 @@ Greek::Greek()	// ελληνικά
 	addPair("Did you intend to use --recursive", L"Μήπως σκοπεύετε να χρησιμοποιήσετε --recursive");
 	addPair("Cannot process UTF-32 encoding", L"δεν μπορεί να επεξεργαστεί UTF-32 κωδικοποίηση");
 	addPair("Artistic Style has terminated\n", L"Artistic Style έχει λήξει\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s επιτυχίες κρυφής μνήμης   %s αστοχίες κρυφής μνήμης\n");
 }
 
 Hindi::Hindi()	// हिन्दी
@@ -749,6 +758,7 @@ Hindi::Hindi()	// हिन्दी
 	addPair("Did you intend to use --recursive", L"क्या आप उपयोग करना चाहते हैं --recursive");
 	addPair("Cannot process UTF-32 encoding", L"UTF-32 कूटबन्धन प्रक्रिया नहीं कर सकते");
 	addPair("Artistic Style has terminated\n", L"Artistic Style समाप्त किया है\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s कैश हिट   %s कैश मिस\n");
 }
 
 Hungarian::Hungarian()	// Magyar
@@ -783,6 +793,7 @@ Hungarian::Hungarian()	// Magyar
 	addPair("Did you intend to use --recursive", L"Esetleg a használni kívánt --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Nem tudja feldolgozni UTF-32 kódolással");
 	addPair("Artistic Style has terminated\n", L"Artistic Style megszűnt\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s gyorsítótár-találat   %s gyorsítótár-hiány\n");
 }
 
 Italian::Italian()	// Italiano
@@ -817,6 +828,7 @@ Italian::Italian()	// Italiano
 	addPair("Did you intend to use --recursive", L"Hai intenzione di utilizzare --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Non è possibile processo di codifica UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style ha terminato\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s riscontri nella cache   %s mancati riscontri nella cache\n");
 }
 
 Japanese::Japanese()	// 日本語
@@ -851,6 +863,7 @@ Japanese::Japanese()	// 日本語
 	addPair("Did you intend to use --recursive", L"あなたは--recursive使用するつもりでした");
 	addPair("Cannot process UTF-32 encoding", L"UTF - 32エンコーディングを処理できません");
 	addPair("Artistic Style has terminated\n", L"Artistic Style 終了しました\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s キャッシュヒット   %s キャッシュミス\n");
 }
 
 Korean::Korean()	// 한국의
@@ -885,6 +898,7 @@ Korean::Korean()	// 한국의
 	addPair("Did you intend to use --recursive", L"--recursive 를 사용하고자 하십니까");
 	addPair("Cannot process UTF-32 encoding", L"UTF-32 인코딩을 처리할 수 없습니다");
 	addPair("Artistic Style has terminated\n", L"Artistic Style를 종료합니다\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s 캐시 적중   %s 캐시 누락\n");
 }
 
 Norwegian::Norwegian()	// Norsk
@@ -919,6 +933,7 @@ Norwegian::Norwegian()	// Norsk
 	addPair("Did you intend to use --recursive", L"Har du tenkt å bruke --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Kan ikke behandle UTF-32 koding");
 	addPair("Artistic Style has terminated\n", L"Artistic Style har avsluttet\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s treff i hurtigbuffer   %s bom i hurtigbuffer\n");
 }
 
 Polish::Polish()	// Polski
@@ -953,6 +968,7 @@ Polish::Polish()	// Polski
 	addPair("Did you intend to use --recursive", L"Czy masz zamiar używać --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Nie można procesu kodowania UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style został zakończony\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s trafień w pamięci podręcznej   %s chybień w pamięci podręcznej\n");
 }
 
 Portuguese::Portuguese()	// Português
@@ -987,6 +1003,7 @@ Portuguese::Portuguese()	// Português
 	addPair("Did you intend to use --recursive", L"Será que você pretende usar --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Não pode processar a codificação UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style terminou\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s acertos no cache   %s falhas no cache\n");
 }
 
 Romanian::Romanian()	// Română
@@ -1021,6 +1038,7 @@ Romanian::Romanian()	// Română
 	addPair("Did you intend to use --recursive", L"V-ați intenționați să utilizați --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Nu se poate procesa codificarea UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style a terminat\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s accesări din cache   %s ratări din cache\n");
 }
 
 Russian::Russian()	// русский
@@ -1055,6 +1073,7 @@ Russian::Russian()	// русский
 	addPair("Did you intend to use --recursive", L"Неужели вы собираетесь использовать --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Не удается обработать UTF-32 кодировке");
 	addPair("Artistic Style has terminated\n", L"Artistic Style прекратил\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s попаданий в кэш   %s промахов кэша\n");
 }
 
 Spanish::Spanish()	// Español
@@ -1089,6 +1108,7 @@ Spanish::Spanish()	// Español
 	addPair("Did you intend to use --recursive", L"Se va a utilizar --recursive");
 	addPair("Cannot process UTF-32 encoding", L"No se puede procesar la codificación UTF-32");
 	addPair("Artistic Style has terminated\n", L"Artistic Style ha terminado\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s aciertos de caché   %s fallos de caché\n");
 }
 
 Swedish::Swedish()	// Svenska
@@ -1123,6 +1143,7 @@ Swedish::Swedish()	// Svenska
 	addPair("Did you intend to use --recursive", L"Har du för avsikt att använda --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Kan inte hantera UTF-32 kodning");
 	addPair("Artistic Style has terminated\n", L"Artistic Style har upphört\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s cacheträffar   %s cachemissar\n");
 }
 
 Ukrainian::Ukrainian()	// Український
@@ -1157,6 +1178,7 @@ Ukrainian::Ukrainian()	// Український
 	addPair("Did you intend to use --recursive", L"Невже ви збираєтеся використовувати --recursive");
 	addPair("Cannot process UTF-32 encoding", L"Не вдається обробити UTF-32 кодуванні");
 	addPair("Artistic Style has terminated\n", L"Artistic Style припинив\n");
+	addPair(" %s cache hits   %s cache misses\n", L" %s влучань у кеш   %s промахів кешу\n");
 }
 
 
@@ -10,6 +10,16 @@
 #include "astyle.h"
 #include <algorithm>
 
+#if !defined(ASTYLE_NO_SIMD) \
+        && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define ASTYLE_SSE2
+	#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
 //-----------------------------------------------------------------------------
 // astyle namespace
 //-----------------------------------------------------------------------------
@@ -187,12 +197,7 @@ bool sortOnName(const string* a, const string* b)
 void ASResource::buildAssignmentOperators(vector<const string*>* assignmentOperators)
 {
 	const size_t elements = 15;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		assignmentOperators->reserve(elements);
-		reserved = true;
-	}
+	assignmentOperators->reserve(elements);
 
 	assignmentOperators->emplace_back(&AS_ASSIGN);
 	assignmentOperators->emplace_back(&AS_PLUS_ASSIGN);
@@ -225,12 +230,7 @@ void ASResource::buildAssignmentOperators(vector<const string*>* assignmentOpera
 void ASResource::buildCastOperators(vector<const string*>* castOperators)
 {
 	const size_t elements = 5;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		castOperators->reserve(elements);
-		reserved = true;
-	}
+	castOperators->reserve(elements);
 
 	castOperators->emplace_back(&AS_CONST_CAST);
 	castOperators->emplace_back(&AS_DYNAMIC_CAST);
@@ -250,12 +250,7 @@ void ASResource::buildCastOperators(vector<const string*>* castOperators)
 void ASResource::buildHeaders(vector<const string*>* headers, int fileType, bool beautifier)
 {
 	const size_t elements = 25;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		headers->reserve(elements);
-		reserved = true;
-	}
+	headers->reserve(elements);
 
 	headers->emplace_back(&AS_IF);
 	headers->emplace_back(&AS_ELSE);
@@ -335,12 +330,7 @@ void ASResource::buildIndentableHeaders(vector<const string*>* indentableHeaders
 void ASResource::buildIndentableMacros(vector<const pair<const string, const string>* >* indentableMacros)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		indentableMacros->reserve(elements);
-		reserved = true;
-	}
+	indentableMacros->reserve(elements);
 
 	// the pairs must be retained in memory because of pair pointers
 	typedef pair<const string, const string> macro_pair;
@@ -372,12 +362,7 @@ void ASResource::buildIndentableMacros(vector<const pair<const string, const str
 void ASResource::buildNonAssignmentOperators(vector<const string*>* nonAssignmentOperators)
 {
 	const size_t elements = 15;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		nonAssignmentOperators->reserve(elements);
-		reserved = true;
-	}
+	nonAssignmentOperators->reserve(elements);
 
 	nonAssignmentOperators->emplace_back(&AS_EQUAL);
 	nonAssignmentOperators->emplace_back(&AS_PLUS_PLUS);
@@ -408,12 +393,7 @@ void ASResource::buildNonAssignmentOperators(vector<const string*>* nonAssignmen
 void ASResource::buildNonParenHeaders(vector<const string*>* nonParenHeaders, int fileType, bool beautifier)
 {
 	const size_t elements = 20;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		nonParenHeaders->reserve(elements);
-		reserved = true;
-	}
+	nonParenHeaders->reserve(elements);
 
 	nonParenHeaders->emplace_back(&AS_ELSE);
 	nonParenHeaders->emplace_back(&AS_DO);
@@ -468,12 +448,7 @@ void ASResource::buildNonParenHeaders(vector<const string*>* nonParenHeaders, in
 void ASResource::buildOperators(vector<const string*>* operators, int fileType)
 {
 	const size_t elements = 50;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		operators->reserve(elements);
-		reserved = true;
-	}
+	operators->reserve(elements);
 
 
 	operators->emplace_back(&AS_PLUS_ASSIGN);
@@ -539,12 +514,7 @@ void ASResource::buildOperators(vector<const string*>* operators, int fileType)
 void ASResource::buildPreBlockStatements(vector<const string*>* preBlockStatements, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		preBlockStatements->reserve(elements);
-		reserved = true;
-	}
+	preBlockStatements->reserve(elements);
 
 	preBlockStatements->emplace_back(&AS_CLASS);
 	if (fileType == C_TYPE)
@@ -584,12 +554,7 @@ void ASResource::buildPreBlockStatements(vector<const string*>* preBlockStatemen
 void ASResource::buildPreCommandHeaders(vector<const string*>* preCommandHeaders, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		preCommandHeaders->reserve(elements);
-		reserved = true;
-	}
+	preCommandHeaders->reserve(elements);
 
 	if (fileType == C_TYPE)
 	{
@@ -628,12 +593,7 @@ void ASResource::buildPreCommandHeaders(vector<const string*>* preCommandHeaders
 void ASResource::buildPreDefinitionHeaders(vector<const string*>* preDefinitionHeaders, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
-	if (!reserved)
-	{
-		preDefinitionHeaders->reserve(elements);
-		reserved = true;
-	}
+	preDefinitionHeaders->reserve(elements);
 
 	preDefinitionHeaders->emplace_back(&AS_CLASS);
 	if (fileType == C_TYPE)
@@ -659,45 +619,496 @@ void ASResource::buildPreDefinitionHeaders(vector<const string*>* preDefinitionH
 	sort(preDefinitionHeaders->begin(), preDefinitionHeaders->end(), sortOnName);
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                         ASLanguageVectors Functions
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/**
+ * Build the language vectors for a file type.
+ * Called only by getLanguageVectors().
+ *
+ * @param fileType      the file type (C_TYPE, JAVA_TYPE, SHARP_TYPE).
+ */
+ASLanguageVectors::ASLanguageVectors(int fileType)
+{
+	ASResource resource;
+	// ASBeautifier vectors
+	resource.buildHeaders(&beautifierHeaders, fileType, true);
+	resource.buildNonParenHeaders(&beautifierNonParenHeaders, fileType, true);
+	resource.buildPreBlockStatements(&preBlockStatements, fileType);
+	resource.buildIndentableHeaders(&indentableHeaders);
+	resource.buildNonAssignmentOperators(&nonAssignmentOperators);
+	// ASFormatter vectors
+	resource.buildHeaders(&formatterHeaders, fileType);
+	resource.buildNonParenHeaders(&formatterNonParenHeaders, fileType);
+	resource.buildPreDefinitionHeaders(&preDefinitionHeaders, fileType);
+	resource.buildOperators(&operators, fileType);
+	resource.buildCastOperators(&castOperators);
+	resource.buildIndentableMacros(&indentableMacros);
+	// shared vectors
+	resource.buildPreCommandHeaders(&preCommandHeaders, fileType);
+	resource.buildAssignmentOperators(&assignmentOperators);
+}
+
+/**
+ * Get the language vectors for a file type.
+ * The vectors for each file type are built on the first call
+ * and are shared by all objects until the end of the process.
+ *
+ * @param fileType      the file type (C_TYPE, JAVA_TYPE, SHARP_TYPE).
+ * @return              the language vectors for the file type.
+ */
+const ASLanguageVectors& ASLanguageVectors::getLanguageVectors(int fileType)
+{
+	if (fileType == JAVA_TYPE)
+	{
+		static const ASLanguageVectors javaVectors(JAVA_TYPE);
+		return javaVectors;
+	}
+	if (fileType == SHARP_TYPE)
+	{
+		static const ASLanguageVectors sharpVectors(SHARP_TYPE);
+		return sharpVectors;
+	}
+	assert(fileType == C_TYPE);
+	static const ASLanguageVectors cVectors(C_TYPE);
+	return cVectors;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                            ASScanner Functions
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// get the position of the lowest set bit in a block mask
+// the mask must not be zero
+int ASScanner::lowestBit(unsigned mask)
+{
+	assert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	int index = 0;
+	while ((mask & 1) == 0)
+	{
+		mask >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+// get the position of the highest set bit in a block mask
+// the mask must not be zero
+int ASScanner::highestBit(unsigned mask)
+{
+	assert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return 31 - __builtin_clz(mask);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return index;
+#else
+	int index = 31;
+	while ((mask & 0x80000000U) == 0)
+	{
+		mask <<= 1;
+		index--;
+	}
+	return index;
+#endif
+}
+
+/**
+ * Find the first character that is not a space or a tab.
+ *
+ * @param line          the line to search.
+ * @param start         the position to start the search.
+ * @return              the position of the character, or string::npos.
+ */
+size_t ASScanner::findNonBlank(const string& line, size_t start /*0*/)
+{
+	const char* lineData = line.data();
+	const size_t lineLength = line.length();
+	if (start >= lineLength)
+		return string::npos;
+	size_t i = start;
+#ifdef ASTYLE_SSE2
+	const __m128i spaces = _mm_set1_epi8(' ');
+	const __m128i tabs = _mm_set1_epi8('\t');
+	for (; lineLength - i >= 16; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineData + i));
+		__m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(block, spaces), _mm_cmpeq_epi8(block, tabs));
+		unsigned mask = ~_mm_movemask_epi8(blanks) & 0xFFFF;
+		if (mask != 0)
+			return i + lowestBit(mask);
+	}
+#endif
+	for (; i < lineLength; i++)
+	{
+		if (lineData[i] != ' ' && lineData[i] != '\t')
+			return i;
+	}
+	return string::npos;
+}
+
+/**
+ * Find the last character that is not a space or a tab.
+ *
+ * @param line          the line to search.
+ * @param end           the last position to check.
+ * @return              the position of the character, or string::npos.
+ */
+size_t ASScanner::findLastNonBlank(const string& line, size_t end /*string::npos*/)
+{
+	const char* lineData = line.data();
+	size_t i = line.length();		// one past the position to check
+	if (end < i)
+		i = end + 1;
+#ifdef ASTYLE_SSE2
+	const __m128i spaces = _mm_set1_epi8(' ');
+	const __m128i tabs = _mm_set1_epi8('\t');
+	for (; i >= 16; i -= 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineData + i - 16));
+		__m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(block, spaces), _mm_cmpeq_epi8(block, tabs));
+		unsigned mask = ~_mm_movemask_epi8(blanks) & 0xFFFF;
+		if (mask != 0)
+			return i - 16 + highestBit(mask);
+	}
+#endif
+	while (i > 0)
+	{
+		--i;
+		if (lineData[i] != ' ' && lineData[i] != '\t')
+			return i;
+	}
+	return string::npos;
+}
+
+/**
+ * Find the closer of a block comment.
+ *
+ * @param line          the line to search.
+ * @param start         the position to start the search.
+ * @return              the position of the comment closer, or string::npos.
+ */
+size_t ASScanner::findCommentEnd(const string& line, size_t start /*0*/)
+{
+	const char* lineData = line.data();
+	const size_t lineLength = line.length();
+	if (lineLength < 2 || start > lineLength - 2)
+		return string::npos;
+	size_t i = start;
+#ifdef ASTYLE_SSE2
+	// each block is compared with the block one character ahead
+	const __m128i stars = _mm_set1_epi8('*');
+	const __m128i slashes = _mm_set1_epi8('/');
+	for (; lineLength - i >= 17; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineData + i));
+		__m128i nextBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineData + i + 1));
+		__m128i ends = _mm_and_si128(_mm_cmpeq_epi8(block, stars), _mm_cmpeq_epi8(nextBlock, slashes));
+		unsigned mask = _mm_movemask_epi8(ends);
+		if (mask != 0)
+			return i + lowestBit(mask);
+	}
+#endif
+	for (; i + 1 < lineLength; i++)
+	{
+		if (lineData[i] == '*' && lineData[i + 1] == '/')
+			return i;
+	}
+	return string::npos;
+}
+
+/**
+ * Find the next quote, slash, semicolon, or brace.
+ * The characters between them can be bypassed by loops looking
+ * for quotes, comments, and statement or block ends.
+ *
+ * @param line          the line to search.
+ * @param start         the position to start the search.
+ * @return              the position of the character, or string::npos.
+ */
+size_t ASScanner::findSyntaxChar(const string& line, size_t start /*0*/)
+{
+	const char* lineData = line.data();
+	const size_t lineLength = line.length();
+	if (start >= lineLength)
+		return string::npos;
+	size_t i = start;
+#ifdef ASTYLE_SSE2
+	const __m128i doubleQuotes = _mm_set1_epi8('"');
+	const __m128i singleQuotes = _mm_set1_epi8('\'');
+	const __m128i slashes = _mm_set1_epi8('/');
+	const __m128i semicolons = _mm_set1_epi8(';');
+	const __m128i openBraces = _mm_set1_epi8('{');
+	const __m128i closeBraces = _mm_set1_epi8('}');
+	for (; lineLength - i >= 16; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineData + i));
+		__m128i quotes = _mm_or_si128(_mm_cmpeq_epi8(block, doubleQuotes),
+		                              _mm_cmpeq_epi8(block, singleQuotes));
+		__m128i others = _mm_or_si128(_mm_cmpeq_epi8(block, slashes),
+		                              _mm_cmpeq_epi8(block, semicolons));
+		__m128i braces = _mm_or_si128(_mm_cmpeq_epi8(block, openBraces),
+		                              _mm_cmpeq_epi8(block, closeBraces));
+		unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quotes, others), braces));
+		if (mask != 0)
+			return i + lowestBit(mask);
+	}
+#endif
+	for (; i < lineLength; i++)
+	{
+		char ch = lineData[i];
+		if (ch == '"' || ch == '\'' || ch == '/' || ch == ';' || ch == '{' || ch == '}')
+			return i;
+	}
+	return string::npos;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *                             ASBase Functions
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+/**
+ * Build the character class tables used by the character predicates.
+ * There is a table of 256 entries for each file type. The flags are
+ * computed once so the predicates are a single table load.
+ * NOTE: Visual C isdigit() gives assert error if char > 256.
+ *
+ * @return      the tables indexed by the file type.
+ */
+vector<vector<unsigned char> > ASBase::buildCharClassTables()
+{
+	vector<vector<unsigned char> > charClassTables(SHARP_TYPE + 1, vector<unsigned char>(256, 0));
+	for (int fileType = C_TYPE; fileType <= SHARP_TYPE; fileType++)
+	{
+		vector<unsigned char>& table = charClassTables[fileType];
+		table[' '] |= CHAR_WHITESPACE;
+		table['\t'] |= CHAR_WHITESPACE;
+		for (int ch = 0; ch < 128; ch++)
+		{
+			if (ch >= '0' && ch <= '9')
+				table[ch] |= CHAR_DIGIT;
+			if (isalnum(ch) || ch == '.' || ch == '_'
+			        || (fileType == JAVA_TYPE && ch == '$')
+			        || (fileType == SHARP_TYPE && ch == '@'))   // may be used as a prefix
+				table[ch] |= CHAR_LEGAL_NAME;
+			if (ispunct(ch)
+			        && ch != '{' && ch != '}'
+			        && ch != '(' && ch != ')'
+			        && ch != '[' && ch != ']'
+			        && ch != ';' && ch != ','
+			        && ch != '#' && ch != '\\'
+			        && ch != '\'' && ch != '\"')
+				table[ch] |= CHAR_POTENTIAL_OPERATOR;
+		}
+	}
+	return charClassTables;
+}
+
+/**
+ * Build an index of the entries in a vector.
+ * The entries are in buckets by the first character, sorted by length.
+ * They are the same pointers as in the vector.
+ *
+ * @param indexVector   the vector to be indexed.
+ * @param longestFirst  sort the buckets with the longest entries first.
+ * @return              the index with a bucket for each 7 bit character.
+ */
+vector<vector<const string*> > ASBase::buildFirstCharIndex(const vector<const string*>& indexVector,
+                                                           bool longestFirst)
+{
+	vector<vector<const string*> > index(128);
+	for (const string* entry : indexVector)
+	{
+		assert(!entry->empty() && (unsigned char) (*entry)[0] < 128);
+		index[(unsigned char) (*entry)[0]].emplace_back(entry);
+	}
+	for (vector<const string*>& bucket : index)
+	{
+		if (longestFirst)
+			stable_sort(bucket.begin(), bucket.end(),
+			            [](const string* a, const string* b) { return a->length() > b->length(); });
+		else
+			stable_sort(bucket.begin(), bucket.end(),
+			            [](const string* a, const string* b) { return a->length() < b->length(); });
+	}
+	return index;
+}
+
+/**
+ * Build the indexes of the header vectors used by findHeader().
+ * Each header vector of each file type has its own index, with the
+ * headers in buckets by the first character, shortest first.
+ * The indexes are sorted by the address of the vector.
+ */
+vector<ASBase::VectorIndex> ASBase::buildHeaderIndex()
+{
+	vector<VectorIndex> headerIndex;
+	for (int fileType = C_TYPE; fileType <= SHARP_TYPE; fileType++)
+	{
+		const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+		const vector<const string*>* headerVectors[] =
+		{
+			&languageVectors.beautifierHeaders,
+			&languageVectors.beautifierNonParenHeaders,
+			&languageVectors.preBlockStatements,
+			&languageVectors.indentableHeaders,
+			&languageVectors.formatterHeaders,
+			&languageVectors.formatterNonParenHeaders,
+			&languageVectors.preDefinitionHeaders,
+			&languageVectors.castOperators,
+			&languageVectors.preCommandHeaders,
+		};
+		for (const vector<const string*>* headerVector : headerVectors)
+		{
+			VectorIndex vectorIndex;
+			vectorIndex.indexVector = headerVector;
+			vectorIndex.buckets = buildFirstCharIndex(*headerVector, false);
+			headerIndex.emplace_back(vectorIndex);
+		}
+	}
+	sort(headerIndex.begin(), headerIndex.end(),
+	     [](const VectorIndex& a, const VectorIndex& b) { return a.indexVector < b.indexVector; });
+	return headerIndex;
+}
+
+/**
+ * Build the indexes of the operator vectors used by findOperator().
+ * Each operator vector of each file type has its own index, with the
+ * operators in buckets by the first character, longest first.
+ * The indexes are sorted by the address of the vector.
+ */
+vector<ASBase::VectorIndex> ASBase::buildOperatorIndex()
+{
+	vector<VectorIndex> operatorIndex;
+	for (int fileType = C_TYPE; fileType <= SHARP_TYPE; fileType++)
+	{
+		const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+		const vector<const string*>* operatorVectors[] =
+		{
+			&languageVectors.operators,
+			&languageVectors.assignmentOperators,
+			&languageVectors.nonAssignmentOperators,
+		};
+		for (const vector<const string*>* operatorVector : operatorVectors)
+		{
+			VectorIndex vectorIndex;
+			vectorIndex.indexVector = operatorVector;
+			vectorIndex.buckets = buildFirstCharIndex(*operatorVector, true);
+			operatorIndex.emplace_back(vectorIndex);
+		}
+	}
+	sort(operatorIndex.begin(), operatorIndex.end(),
+	     [](const VectorIndex& a, const VectorIndex& b) { return a.indexVector < b.indexVector; });
+	return operatorIndex;
+}
+
+/**
+ * Get the character class table for a file type.
+ * The tables are built on the first call and shared by all objects.
+ */
+const unsigned char* ASBase::getCharClassTable(int fileType)
+{
+	static const vector<vector<unsigned char> > charClassTables = buildCharClassTables();
+	assert(fileType >= C_TYPE && fileType <= SHARP_TYPE);
+	return charClassTables[fileType].data();
+}
+
+/**
+ * Find the index of a vector in a list of indexes sorted by address.
+ * Returns nullptr if the vector has not been indexed.
+ */
+const vector<vector<const string*> >* ASBase::findVectorIndex(const vector<VectorIndex>& indexes,
+                                                              const vector<const string*>* indexVector)
+{
+	vector<VectorIndex>::const_iterator vectorIndex =
+	    lower_bound(indexes.begin(), indexes.end(), indexVector,
+	                [](const VectorIndex& a, const vector<const string*>* b) { return a.indexVector < b; });
+	if (vectorIndex == indexes.end() || vectorIndex->indexVector != indexVector)
+		return nullptr;
+	return &vectorIndex->buckets;
+}
+
+/**
+ * Get the index of a header vector used by findHeader().
+ * The indexes are built on the first call and shared by all objects.
+ *
+ * @param headers       the header vector.
+ * @return              the headers in buckets by the first character,
+ *                      or nullptr if it is not a vector in ASLanguageVectors.
+ */
+const vector<vector<const string*> >* ASBase::getHeaderIndex(const vector<const string*>* headers)
+{
+	static const vector<VectorIndex> headerIndex = buildHeaderIndex();
+	return findVectorIndex(headerIndex, headers);
+}
+
+/**
+ * Get the index of an operator vector used by findOperator().
+ * The indexes are built on the first call and shared by all objects.
+ *
+ * @param operators     the operator vector.
+ * @return              the operators in buckets by the first character,
+ *                      or nullptr if it is not a vector in ASLanguageVectors.
+ */
+const vector<vector<const string*> >* ASBase::getOperatorIndex(const vector<const string*>* operators)
+{
+	static const vector<VectorIndex> operatorIndex = buildOperatorIndex();
+	return findVectorIndex(operatorIndex, operators);
+}
+
 // check if a specific line position contains a header.
+// only the headers in the vector with the same first character
+// are compared, instead of each entry in the vector.
+// a vector that is not in ASLanguageVectors is not indexed,
+// and each entry is compared.
 const string* ASBase::findHeader(const string& line, int i,
                                  const vector<const string*>* possibleHeaders) const
 {
 	assert(isCharPotentialHeader(line, i));
-	// check the word
-	size_t maxHeaders = possibleHeaders->size();
-	for (size_t p = 0; p < maxHeaders; p++)
+	const unsigned char firstChar = line[i];
+	if (firstChar >= 128)
+		return nullptr;
+	// check the word, the bucket is sorted by length
+	const vector<vector<const string*> >* headerIndex = getHeaderIndex(possibleHeaders);
+	const vector<const string*>& bucket = headerIndex != nullptr ? (*headerIndex)[firstChar] : *possibleHeaders;
+	for (const string* header : bucket)
 	{
-		const string* header = (*possibleHeaders)[p];
 		const size_t wordEnd = i + header->length();
 		if (wordEnd > line.length())
+		{
+			if (headerIndex != nullptr)
+				break;
 			continue;
-		int result = (line.compare(i, header->length(), *header));
-		if (result > 0)
+		}
+		if (memcmp(line.data() + i, header->data(), header->length()) != 0)
 			continue;
-		if (result < 0)
-			break;
 		// check that this is not part of a longer word
+		if (wordEnd < line.length() && isLegalNameChar(line[wordEnd]))
+			continue;
 		if (wordEnd == line.length())
 			return header;
-		if (isLegalNameChar(line[wordEnd]))
-			continue;
 		const char peekChar = peekNextChar(line, wordEnd - 1);
 		// is not a header if part of a definition
 		if (peekChar == ',' || peekChar == ')')
-			break;
+			return nullptr;
 		// the following accessor definitions are NOT headers
 		// goto default; is NOT a header
 		// default(int) keyword in C# is NOT a header
-		else if ((header == &AS_GET
-		          || header == &AS_SET
-		          || header == &AS_DEFAULT)
-		         && (peekChar == ';' || peekChar == '(' || peekChar == '='))
-			break;
+		if ((header == &AS_GET
+		        || header == &AS_SET
+		        || header == &AS_DEFAULT)
+		        && (peekChar == ';' || peekChar == '(' || peekChar == '='))
+			return nullptr;
 		return header;
 	}
 	return nullptr;
@@ -727,21 +1138,27 @@ bool ASBase::findKeyword(const string& line, int i, const string& keyword) const
 }
 
 // check if a specific line position contains an operator.
+// only the operators in the vector with the same first character
+// are compared, instead of each entry in the vector.
+// a vector that is not in ASLanguageVectors is not indexed,
+// and each entry is compared. the vector must be sorted longest first.
 const string* ASBase::findOperator(const string& line, int i,
                                    const vector<const string*>* possibleOperators) const
 {
 	assert(isCharPotentialOperator(line[i]));
-	// find the operator in the vector
-	// the vector contains the LONGEST operators first
-	// must loop thru the entire vector
-	size_t maxOperators = possibleOperators->size();
-	for (size_t p = 0; p < maxOperators; p++)
+	const unsigned char firstChar = line[i];
+	if (firstChar >= 128)
+		return nullptr;
+	// find the LONGEST operator that is in the vector
+	// the bucket contains the longest operators first
+	const vector<vector<const string*> >* operatorIndex = getOperatorIndex(possibleOperators);
+	const vector<const string*>& bucket = operatorIndex != nullptr ? (*operatorIndex)[firstChar] : *possibleOperators;
+	for (const string* newOperator : bucket)
 	{
-		const size_t wordEnd = i + (*(*possibleOperators)[p]).length();
-		if (wordEnd > line.length())
+		if (i + newOperator->length() > line.length())
 			continue;
-		if (line.compare(i, (*(*possibleOperators)[p]).length(), *(*possibleOperators)[p]) == 0)
-			return (*possibleOperators)[p];
+		if (memcmp(line.data() + i, newOperator->data(), newOperator->length()) == 0)
+			return newOperator;
 	}
 	return nullptr;
 }
@@ -751,27 +1168,19 @@ const string* ASBase::findOperator(const string& line, int i,
 string ASBase::getCurrentWord(const string& line, size_t index) const
 {
 	assert(isCharPotentialHeader(line, index));
-	size_t lineLength = line.length();
-	size_t i;
-	for (i = index; i < lineLength; i++)
-	{
-		if (!isLegalNameChar(line[i]))
-			break;
-	}
-	return line.substr(index, i - index);
+	return line.substr(index, findWordEnd(line, index) - index);
 }
 
-// check if a specific character can be used in a legal variable/method/class name
-bool ASBase::isLegalNameChar(char ch) const
+// find the end of the legal name characters beginning at index
+// returns the position of the first character that is not part of the name
+size_t ASBase::findWordEnd(const string& line, size_t index) const
 {
-	if (isWhiteSpace(ch))
-		return false;
-	if ((unsigned char) ch > 127)
-		return false;
-	return (isalnum((unsigned char) ch)
-	        || ch == '.' || ch == '_'
-	        || (isJavaStyle() && ch == '$')
-	        || (isSharpStyle() && ch == '@'));  // may be used as a prefix
+	const char* lineData = line.data();
+	const size_t lineLength = line.length();
+	size_t i = index;
+	while (i < lineLength && (charClass[(unsigned char) lineData[i]] & CHAR_LEGAL_NAME))
+		i++;
+	return i;
 }
 
 // check if a specific character can be part of a header
@@ -788,28 +1197,6 @@ bool ASBase::isCharPotentialHeader(const string& line, size_t i) const
 	return false;
 }
 
-// check if a specific character can be part of an operator
-bool ASBase::isCharPotentialOperator(char ch) const
-{
-	assert(!isWhiteSpace(ch));
-	if ((unsigned) ch > 127)
-		return false;
-	return (ispunct((unsigned char) ch)
-	        && ch != '{' && ch != '}'
-	        && ch != '(' && ch != ')'
-	        && ch != '[' && ch != ']'
-	        && ch != ';' && ch != ','
-	        && ch != '#' && ch != '\\'
-	        && ch != '\'' && ch != '\"');
-}
-
-// check if a specific character is a digit
-// NOTE: Visual C isdigit() gives assert error if char > 256
-bool ASBase::isDigit(char ch) const
-{
-	return (ch >= '0' && ch <= '9');
-}
-
 // check if a specific character is a digit separator
 bool ASBase::isDigitSeparator(const string& line, int i) const
 {
@@ -827,7 +1214,7 @@ bool ASBase::isDigitSeparator(const string& line, int i) const
 char ASBase::peekNextChar(const string& line, int i) const
 {
 	char ch = ' ';
-	size_t peekNum = line.find_first_not_of(" \t", i + 1);
+	size_t peekNum = ASScanner::findNonBlank(line, i + 1);
 	if (peekNum == string::npos)
 		return ch;
 	ch = line[peekNum];
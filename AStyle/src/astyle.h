@@ -18,6 +18,7 @@
 #endif
 
 #include <cctype>
+#include <cstdint>
 #include <iostream>		// for cout
 #include <memory>
 #include <string>
@@ -180,6 +181,8 @@ enum LineEndFormat
 // ASStreamIterator. This allows programs using AStyle as a plug-in to define
 // their own ASStreamIterator. The ASStreamIterator class must inherit
 // this class.
+// getStreamLength returns a streamoff, it was an int in version 3.1,
+// a plug-in iterator must change the return type of its override.
 //-----------------------------------------------------------------------------
 
 class ASSourceIterator
@@ -188,7 +191,7 @@ public:
 	ASSourceIterator() {}
 	virtual ~ASSourceIterator() {}
 	virtual streamoff getPeekStart() const = 0;
-	virtual int getStreamLength() const = 0;
+	virtual streamoff getStreamLength() const = 0;
 	virtual bool hasMoreLines() const = 0;
 	virtual string nextLine(bool emptyLineWasDeleted = false) = 0;
 	virtual string peekNextLine() = 0;
@@ -223,6 +226,148 @@ public:
 	{ needReset = true; return sourceIterator->peekNextLine(); }
 };
 
+//-----------------------------------------------------------------------------
+// Class ASCopyPtr
+// An object owned by a pointer that is copied with the owner.
+// The copy constructor of the owner can then be the default member-wise
+// copy, and the two objects can be used and destroyed independently.
+//-----------------------------------------------------------------------------
+
+template<typename T>
+class ASCopyPtr
+{
+private:
+	T* object;
+
+public:
+	ASCopyPtr() : object(new T) {}
+	ASCopyPtr(const ASCopyPtr& other) : object(new T(*other.object)) {}
+	~ASCopyPtr() { delete object; }
+
+	T& operator*() const
+	{ return *object; }
+
+	T* operator->() const
+	{ return object; }
+
+private:
+	ASCopyPtr& operator=(const ASCopyPtr&);     // not to be implemented
+};
+
+//-----------------------------------------------------------------------------
+// Class ASSharedStack
+// A copy-on-write stack used for the ASBeautifier state.
+// A copy of the stack shares the elements with the original. The elements
+// are copied only when a shared stack is changed by write(). This allows
+// the ASBeautifier clones for preprocessor conditionals to be created
+// without copying the stacks, and only the changed stacks are copied.
+//-----------------------------------------------------------------------------
+
+template<typename T>
+class ASSharedStack
+{
+private:
+	shared_ptr<vector<T> > stack;
+
+public:
+	ASSharedStack() : stack(make_shared<vector<T> >()) {}
+
+	const vector<T>& operator*() const
+	{ return *stack; }
+
+	const vector<T>* operator->() const
+	{ return stack.get(); }
+
+	// remove the elements without changing the copies
+	void clear()
+	{
+		if (isShared())
+			stack = make_shared<vector<T> >();
+		else
+			stack->clear();
+	}
+
+	// check if the elements are shared with a copy
+	bool isShared() const
+	{ return stack.use_count() > 1; }
+
+	// get the stack to be changed, copying the elements if they are shared
+	vector<T>& write()
+	{
+		if (isShared())
+			stack = make_shared<vector<T> >(*stack);
+		return *stack;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Class ASTempStacks
+// The temporary header stacks used by ASBeautifier, one for each open brace.
+// The headers of all the stacks are in one contiguous vector, and a frame
+// vector has the position of the first header of each stack. The last
+// stack is at the end of the headers. The header functions use the last
+// stack. Both vectors are an ASSharedStack so they are shared with the
+// ASBeautifier clones until they are changed.
+//-----------------------------------------------------------------------------
+
+class ASTempStacks
+{
+private:
+	ASSharedStack<const string*> headers;	// the headers of all the stacks
+	ASSharedStack<size_t> frames;			// the position of each stack in headers
+
+	size_t lastFrame() const
+	{ return frames->empty() ? 0 : frames->back(); }
+
+public:
+	// remove all the stacks
+	void clear()
+	{ headers.clear(); frames.clear(); }
+
+	// check if there are no stacks
+	bool empty() const
+	{ return frames->empty(); }
+
+	// add a new empty last stack
+	void pushStack()
+	{ frames.write().push_back(headers->size()); }
+
+	// remove the last stack and its headers
+	void popStack()
+	{ headers.write().resize(lastFrame()); frames.write().pop_back(); }
+
+	// remove the headers from the last stack
+	void clearHeaders()
+	{ if (headers->size() > lastFrame()) headers.write().resize(lastFrame()); }
+
+	// number of headers in the last stack
+	size_t headerCount() const
+	{ return headers->size() - lastFrame(); }
+
+	// header i of the last stack
+	const string* getHeader(size_t i) const
+	{ return (*headers)[lastFrame() + i]; }
+
+	// index of a header in the last stack, -1 if it is not found
+	int indexOfHeader(const string* header) const
+	{
+		for (size_t i = lastFrame(); i < headers->size(); i++)
+			if ((*headers)[i] == header)
+				return static_cast<int>(i - lastFrame());
+		return -1;
+	}
+
+	// the last header of the last stack
+	const string* lastHeader() const
+	{ return headers->back(); }
+
+	void popHeader()
+	{ headers.write().pop_back(); }
+
+	void pushHeader(const string* header)
+	{ headers.write().push_back(header); }
+};
+
 
 //-----------------------------------------------------------------------------
 // Class ASResource
@@ -287,6 +432,69 @@ public:
 	static const string AS_NS_DURING, AS_NS_HANDLER;
 };  // Class ASResource
 
+//-----------------------------------------------------------------------------
+// Class ASLanguageVectors
+// The language vectors for a file type are built once per process
+// and are shared read-only by all ASBeautifier and ASFormatter objects.
+// Functions definitions are in ASResource.cpp.
+//-----------------------------------------------------------------------------
+
+class ASLanguageVectors
+{
+public:  // functions
+	static const ASLanguageVectors& getLanguageVectors(int fileType);
+
+public:  // variables
+	// ASBeautifier vectors
+	vector<const string*> beautifierHeaders;
+	vector<const string*> beautifierNonParenHeaders;
+	vector<const string*> preBlockStatements;
+	vector<const string*> indentableHeaders;
+	vector<const string*> nonAssignmentOperators;
+	// ASFormatter vectors
+	vector<const string*> formatterHeaders;
+	vector<const string*> formatterNonParenHeaders;
+	vector<const string*> preDefinitionHeaders;
+	vector<const string*> operators;
+	vector<const string*> castOperators;
+	vector<const pair<const string, const string>* > indentableMacros;	// for ASEnhancer
+	// shared vectors
+	vector<const string*> preCommandHeaders;
+	vector<const string*> assignmentOperators;
+
+private:  // functions
+	explicit ASLanguageVectors(int fileType);
+	ASLanguageVectors(const ASLanguageVectors&) = delete;
+	ASLanguageVectors& operator=(const ASLanguageVectors&) = delete;
+};  // Class ASLanguageVectors
+
+//-----------------------------------------------------------------------------
+// Class ASScanner
+// Scanners for the characters searched in the formatting loops.
+// Each function returns the same value as the std::string search in its
+// comment. A block of 16 characters is checked at once with SSE2, and
+// the remainder is checked one character at a time. Compile with
+// ASTYLE_NO_SIMD to use only the scalar code.
+// Functions definitions are in ASResource.cpp.
+//-----------------------------------------------------------------------------
+
+class ASScanner
+{
+public:
+	// line.find_first_not_of(" \t", start)
+	static size_t findNonBlank(const string& line, size_t start = 0);
+	// line.find_last_not_of(" \t", end)
+	static size_t findLastNonBlank(const string& line, size_t end = string::npos);
+	// line.find("*/", start)
+	static size_t findCommentEnd(const string& line, size_t start = 0);
+	// line.find_first_of("\"'/;{}", start)
+	static size_t findSyntaxChar(const string& line, size_t start = 0);
+
+private:
+	static int lowestBit(unsigned mask);
+	static int highestBit(unsigned mask);
+};
+
 //-----------------------------------------------------------------------------
 // Class ASBase
 // Functions definitions are at the end of ASResource.cpp.
@@ -295,18 +503,38 @@ public:
 class ASBase : protected ASResource
 {
 private:
+	// character class flags in the character class tables
+	enum CharClass
+	{
+		CHAR_WHITESPACE = 0x01,         // space or tab
+		CHAR_LEGAL_NAME = 0x02,         // may be used in a variable/method/class name
+		CHAR_POTENTIAL_OPERATOR = 0x04, // may be part of an operator
+		CHAR_DIGIT = 0x08               // decimal digit
+	};
+
 	// all variables should be set by the "init" function
-	int baseFileType;      // a value from enum FileType
+	int baseFileType;               // a value from enum FileType
+	const unsigned char* charClass; // character class table for the file type
 
 protected:
-	ASBase() : baseFileType(C_TYPE) { }
+	ASBase() : baseFileType(C_TYPE), charClass(getCharClassTable(C_TYPE)) { }
 
 protected:  // inline functions
-	void init(int fileTypeArg) { baseFileType = fileTypeArg; }
+	void init(int fileTypeArg) { baseFileType = fileTypeArg; charClass = getCharClassTable(fileTypeArg); }
 	bool isCStyle() const { return (baseFileType == C_TYPE); }
 	bool isJavaStyle() const { return (baseFileType == JAVA_TYPE); }
 	bool isSharpStyle() const { return (baseFileType == SHARP_TYPE); }
-	bool isWhiteSpace(char ch) const { return (ch == ' ' || ch == '\t'); }
+	bool isWhiteSpace(char ch) const { return (charClass[(unsigned char) ch] & CHAR_WHITESPACE) != 0; }
+	// check if a specific character is a digit
+	bool isDigit(char ch) const { return (charClass[(unsigned char) ch] & CHAR_DIGIT) != 0; }
+	// check if a specific character can be used in a legal variable/method/class name
+	bool isLegalNameChar(char ch) const { return (charClass[(unsigned char) ch] & CHAR_LEGAL_NAME) != 0; }
+	// check if a specific character can be part of an operator
+	bool isCharPotentialOperator(char ch) const
+	{
+		assert(!isWhiteSpace(ch));
+		return (charClass[(unsigned char) ch] & CHAR_POTENTIAL_OPERATOR) != 0;
+	}
 
 protected:  // functions definitions are at the end of ASResource.cpp
 	const string* findHeader(const string& line, int i,
@@ -314,14 +542,31 @@ protected:  // functions definitions are at the end of ASResource.cpp
 	bool findKeyword(const string& line, int i, const string& keyword) const;
 	const string* findOperator(const string& line, int i,
 	                           const vector<const string*>* possibleOperators) const;
+	size_t findWordEnd(const string& line, size_t index) const;
 	string getCurrentWord(const string& line, size_t index) const;
-	bool isDigit(char ch) const;
-	bool isLegalNameChar(char ch) const;
 	bool isCharPotentialHeader(const string& line, size_t i) const;
-	bool isCharPotentialOperator(char ch) const;
 	bool isDigitSeparator(const string& line, int i) const;
 	char peekNextChar(const string& line, int i) const;
 
+private:  // index of the entries in a language vector
+	struct VectorIndex
+	{
+		const vector<const string*>* indexVector;   // the indexed vector
+		vector<vector<const string*> > buckets;     // the entries by first character
+	};
+
+private:  // functions definitions are at the end of ASResource.cpp
+	static vector<vector<unsigned char> > buildCharClassTables();
+	static vector<vector<const string*> > buildFirstCharIndex(const vector<const string*>& indexVector,
+	                                                          bool longestFirst);
+	static vector<VectorIndex> buildHeaderIndex();
+	static vector<VectorIndex> buildOperatorIndex();
+	static const unsigned char* getCharClassTable(int fileType);
+	static const vector<vector<const string*> >* findVectorIndex(const vector<VectorIndex>& indexes,
+	                                                             const vector<const string*>* indexVector);
+	static const vector<vector<const string*> >* getHeaderIndex(const vector<const string*>* headers);
+	static const vector<vector<const string*> >* getOperatorIndex(const vector<const string*>* operators);
+
 };  // Class ASBase
 
 //-----------------------------------------------------------------------------
@@ -379,7 +624,8 @@ public:
 	bool getSwitchIndent() const;
 
 protected:
-	void deleteBeautifierVectors();
+	ASBeautifier(const ASBeautifier& other);
+	void copyBeautifierStacks(const ASBeautifier& other);
 	int  getNextProgramCharDistance(const string& line, int i) const;
 	int  indexOf(const vector<const string*>& container, const string* element) const;
 	void setBlockIndent(bool state);
@@ -388,6 +634,7 @@ protected:
 	string extractPreprocessorStatement(const string& line) const;
 	string trim(const string& str) const;
 	string rtrim(const string& str) const;
+	size_t findTrimBounds(const string& str, size_t& start) const;
 
 	// variables set by ASFormatter - must be updated in activeBeautifierStack
 	int  inLineNumber;
@@ -406,7 +653,6 @@ protected:
 	bool isInIndentablePreproc;
 
 private:  // functions
-	ASBeautifier(const ASBeautifier& other);     // inline functions
 	ASBeautifier& operator=(ASBeautifier&);      // not to be implemented
 
 	void adjustObjCMethodDefinitionIndentation(const string& line_);
@@ -420,11 +666,9 @@ private:  // functions
 	                                int tabIncrementIn, int minIndent, bool updateParenStack);
 	void registerContinuationIndentColon(const string& line, int i, int tabIncrementIn);
 	void initVectors();
-	void initTempStacksContainer(vector<vector<const string*>*>*& container,
-	                             vector<vector<const string*>*>* value);
 	void clearObjCMethodDefinitionAlignment();
 	void deleteBeautifierContainer(vector<ASBeautifier*>*& container);
-	void deleteTempStacksContainer(vector<vector<const string*>*>*& container);
+	void initBeautifierContainer(vector<ASBeautifier*>*& container);
 	int  adjustIndentCountForBreakElseIfComments() const;
 	int  computeObjCColonAlignment(const string& line, int colonAlignPosition) const;
 	int  convertTabToSpaces(int i, int tabIncrementIn) const;
@@ -440,36 +684,38 @@ private:  // functions
 	bool statementEndsWithComma(const string& line, int index) const;
 	const string& getIndentedLineReturn(const string& newLine, const string& originalLine) const;
 	string getIndentedSpaceEquivalent(const string& line_) const;
-	string preLineWS(int lineIndentCount, int lineSpaceIndentCount) const;
+	string preLineWS(int lineIndentCount, int lineSpaceIndentCount, size_t textLength = 0) const;
 	template<typename T> void deleteContainer(T& container);
-	template<typename T> void initContainer(T& container, T value);
-	vector<vector<const string*>*>* copyTempStacks(const ASBeautifier& other) const;
+	template<typename T> void initContainer(vector<T>*& container);
+	vector<ASBeautifier*>* copyBeautifierContainer(const vector<ASBeautifier*>* container) const;
 	pair<int, int> computePreprocessorIndent();
 
 private:  // variables
 	int beautifierFileType;
-	vector<const string*>* headers;
-	vector<const string*>* nonParenHeaders;
-	vector<const string*>* preBlockStatements;
-	vector<const string*>* preCommandHeaders;
-	vector<const string*>* assignmentOperators;
-	vector<const string*>* nonAssignmentOperators;
-	vector<const string*>* indentableHeaders;
+	const vector<const string*>* headers;
+	const vector<const string*>* nonParenHeaders;
+	const vector<const string*>* preBlockStatements;
+	const vector<const string*>* preCommandHeaders;
+	const vector<const string*>* assignmentOperators;
+	const vector<const string*>* nonAssignmentOperators;
+	const vector<const string*>* indentableHeaders;
 
 	vector<ASBeautifier*>* waitingBeautifierStack;
 	vector<ASBeautifier*>* activeBeautifierStack;
 	vector<int>* waitingBeautifierStackLengthStack;
 	vector<int>* activeBeautifierStackLengthStack;
-	vector<const string*>* headerStack;
-	vector<vector<const string*>* >* tempStacks;
-	vector<int>* parenDepthStack;
-	vector<bool>* blockStatementStack;
-	vector<bool>* parenStatementStack;
-	vector<bool>* braceBlockStateStack;
-	vector<int>* continuationIndentStack;
-	vector<int>* continuationIndentStackSizeStack;
-	vector<int>* parenIndentStack;
-	vector<pair<int, int> >* preprocIndentStack;
+	// the stacks are shared with the copies until they are changed
+	ASSharedStack<const string*> headerStack;
+	ASTempStacks tempStacks;
+	ASSharedStack<int> parenDepthStack;
+	ASSharedStack<bool> blockStatementStack;
+	ASSharedStack<bool> parenStatementStack;
+	ASSharedStack<bool> braceBlockStateStack;
+	ASSharedStack<int> continuationIndentStack;
+	ASSharedStack<int> continuationIndentStackSizeStack;
+	ASSharedStack<int> parenIndentStack;
+	ASSharedStack<pair<int, int> > preprocIndentStack;
+	int* preprocessorCppExternCBrace;	// shared with the copies for preprocessor conditionals
 
 	ASSourceIterator* sourceIterator;
 	const string* currentHeader;
@@ -548,6 +794,8 @@ private:  // variables
 	int  spaceIndentObjCMethodAlignment;
 	int  bracePosObjCMethodAlignment;
 	int  colonIndentObjCMethodAlignment;
+	int  keywordIndentObjCMethodAlignment;
+	int  cppExternCBraceState;		// the value pointed to by preprocessorCppExternCBrace
 	int  lineOpeningBlocksNum;
 	int  lineClosingBlocksNum;
 	int  fileType;
@@ -583,7 +831,7 @@ public:  // functions
 	ASEnhancer();
 	virtual ~ASEnhancer();
 	void init(int, int, int, bool, bool, bool, bool, bool, bool, bool,
-	          vector<const pair<const string, const string>* >*);
+	          const vector<const pair<const string, const string>* >*);
 	void enhance(string& line, bool isInNamespace, bool isInPreprocessor, bool isInSQL);
 
 private:  // functions
@@ -640,7 +888,7 @@ private:
 	// event table variables
 	bool nextLineIsEventIndent;             // begin event table indent is reached
 	bool isInEventTable;                    // need to indent an event table
-	vector<const pair<const string, const string>* >* indentableMacros;
+	const vector<const pair<const string, const string>* >* indentableMacros;
 
 	// SQL variables
 	bool nextLineIsDeclareIndent;           // begin declare section indent is reached
@@ -648,6 +896,47 @@ private:
 
 };  // Class ASEnhancer
 
+//-----------------------------------------------------------------------------
+// Class ASVerifyHash
+// An order dependent hash of the non-whitespace characters of a source,
+// used by the ASFormatter verify option. The code and the comments are
+// hashed as two separate sequences, because the formatter may move a
+// comment past the code on a line. The lines are added one at a time.
+// Functions definitions are at the end of ASFormatter.cpp.
+//-----------------------------------------------------------------------------
+
+class ASVerifyHash
+{
+public:
+	ASVerifyHash();
+	void addLine(const string& line);
+	bool operator==(const ASVerifyHash& other) const;
+	bool operator!=(const ASVerifyHash& other) const { return !(*this == other); }
+	uint64_t getHash() const;
+
+private:
+	// the kind of text that continues to the next line
+	enum TextState
+	{
+		CODE_TEXT,
+		COMMENT_TEXT,       // block comment
+		QUOTE_TEXT,         // quote ended by quoteChar, may continue with a '\'
+		RAW_STRING_TEXT,    // C++ raw string ended by rawStringEnd
+		VERBATIM_TEXT       // C# verbatim string
+	};
+
+	static void addChar(uint64_t& hash, char ch);
+	static bool isDigitSeparator(const string& line, size_t i);
+	static bool isRawStringStart(const string& line, size_t i);
+	static bool isNameChar(char ch);
+
+	uint64_t codeHash;
+	uint64_t commentHash;
+	TextState textState;
+	char quoteChar;
+	string rawStringEnd;
+};  // Class ASVerifyHash
+
 //-----------------------------------------------------------------------------
 // Class ASFormatter
 //-----------------------------------------------------------------------------
@@ -661,6 +950,8 @@ public:	// functions
 	virtual bool hasMoreLines() const;
 	virtual string nextLine();
 	LineEndFormat getLineEndFormat() const;
+	bool getBracesAreBalanced() const;
+	bool getFoundUnmatchedBrace() const;
 	bool getIsLineReady() const;
 	void setFormattingStyle(FormatStyle style);
 	void setAddBracesMode(bool state);
@@ -708,9 +999,13 @@ public:	// functions
 	void setReferenceAlignment(ReferenceAlign alignment);
 	void setStripCommentPrefix(bool state);
 	void setTabSpaceConversionMode(bool state);
+	void setVerifyMode(bool state);
 	size_t getChecksumIn() const;
 	size_t getChecksumOut() const;
 	int  getChecksumDiff() const;
+	bool getVerifyFailed() const;
+	bool getVerifyMode() const;
+	static uint64_t computeVerifyHash(const string& text);
 	int  getFormatterFileType() const;
 	// retained for compatibility with release 2.06
 	// "Brackets" have been changed to "Braces" in 3.0
@@ -722,15 +1017,15 @@ public:	// functions
 
 
 private:  // functions
-	ASFormatter(const ASFormatter& copy);       // not to be implemented
+	ASFormatter(const ASFormatter& other) = default;	// used by ASCheckpoint
 	ASFormatter& operator=(ASFormatter&);       // not to be implemented
-	template<typename T> void deleteContainer(T& container);
-	template<typename T> void initContainer(T& container, T value);
 	char peekNextChar() const;
 	BraceType getBraceType();
 	bool adjustChecksumIn(int adjustment);
 	bool computeChecksumIn(const string& currentLine_);
 	bool computeChecksumOut(const string& beautifiedLine);
+	void addVerifyHashIn(const string& text);
+	void addVerifyHashOut(const string& text);
 	bool addBracesToStatement();
 	bool removeBracesFromStatement();
 	bool commentAndHeaderFollows();
@@ -779,8 +1074,10 @@ private:  // functions
 	void appendChar(char ch, bool canBreakLine);
 	void appendCharInsideComments();
 	void appendClosingHeader();
+	void appendCommentText(size_t textEnd);
 	void appendOperator(const string& sequence, bool canBreakLine = true);
 	void appendSequence(const string& sequence, bool canBreakLine = true);
+	void appendSequence(const string& line, size_t start, size_t length);
 	void appendSpacePad();
 	void appendSpaceAfter();
 	void breakLine(bool isSplitLine = false);
@@ -790,7 +1087,6 @@ private:  // functions
 	void checkIfTemplateOpener();
 	void clearFormattedLineSplitPoints();
 	void convertTabToSpaces();
-	void deleteContainer(vector<BraceType>*& container);
 	void findReturnTypeSplitPoint(const string& firstLine);
 	void formatArrayRunIn();
 	void formatRunIn();
@@ -812,7 +1108,6 @@ private:  // functions
 	void fixOptionVariableConflicts();
 	void goForward(int i);
 	void isLineBreakBeforeClosingHeader();
-	void initContainer(vector<BraceType>*& container, vector<BraceType>* value);
 	void initNewLine();
 	void padObjCMethodColon();
 	void padObjCMethodPrefix();
@@ -833,28 +1128,30 @@ private:  // functions
 	const string* getFollowingOperator() const;
 	string getPreviousWord(const string& line, int currPos) const;
 	string peekNextText(const string& firstLine,
+	                    size_t firstLineStart = 0,
 	                    bool endOnEmptyLine = false,
 	                    shared_ptr<ASPeekStream> streamArg = nullptr) const;
+	char peekNextTextChar(const string& firstLine, size_t firstLineStart) const;
 
 private:  // variables
 	int formatterFileType;
-	vector<const string*>* headers;
-	vector<const string*>* nonParenHeaders;
-	vector<const string*>* preDefinitionHeaders;
-	vector<const string*>* preCommandHeaders;
-	vector<const string*>* operators;
-	vector<const string*>* assignmentOperators;
-	vector<const string*>* castOperators;
-	vector<const pair<const string, const string>* >* indentableMacros;	// for ASEnhancer
+	const vector<const string*>* headers;
+	const vector<const string*>* nonParenHeaders;
+	const vector<const string*>* preDefinitionHeaders;
+	const vector<const string*>* preCommandHeaders;
+	const vector<const string*>* operators;
+	const vector<const string*>* assignmentOperators;
+	const vector<const string*>* castOperators;
+	const vector<const pair<const string, const string>* >* indentableMacros;	// for ASEnhancer
 
 	ASSourceIterator* sourceIterator;
-	ASEnhancer* enhancer;
+	ASCopyPtr<ASEnhancer> enhancer;
 
-	vector<const string*>* preBraceHeaderStack;
-	vector<BraceType>* braceTypeStack;
-	vector<int>* parenStack;
-	vector<bool>* structStack;
-	vector<bool>* questionMarkStack;
+	ASCopyPtr<vector<const string*> > preBraceHeaderStack;
+	ASCopyPtr<vector<BraceType> > braceTypeStack;
+	ASCopyPtr<vector<int> > parenStack;
+	ASCopyPtr<vector<bool> > structStack;
+	ASCopyPtr<vector<bool> > questionMarkStack;
 
 	string currentLine;
 	string formattedLine;
@@ -878,6 +1175,8 @@ private:  // variables
 	int  squareBracketCount;
 	size_t checksumIn;
 	size_t checksumOut;
+	ASVerifyHash verifyHashIn;
+	ASVerifyHash verifyHashOut;
 	size_t currentLineFirstBraceNum;	// first brace location on currentLine
 	size_t formattedLineCommentNum;     // comment location on formattedLine
 	size_t leadingSpaces;
@@ -916,6 +1215,7 @@ private:  // variables
 	bool shouldPadParensInside;
 	bool shouldPadHeader;
 	bool shouldStripCommentPrefix;
+	bool shouldVerify;
 	bool shouldUnPadParens;
 	bool shouldConvertTabs;
 	bool shouldIndentCol1Comments;
@@ -961,6 +1261,7 @@ private:  // variables
 	bool isInLineBreak;
 	bool endOfAsmReached;
 	bool endOfCodeReached;
+	bool isVerifyLinePending;         // currentLine has not been added to verifyHashIn
 	bool lineCommentNoIndent;
 	bool isFormattingModeOff;
 	bool isInEnum;
@@ -972,6 +1273,7 @@ private:  // variables
 	bool elseHeaderFollowsComments;
 	bool caseHeaderFollowsComments;
 	bool isPreviousBraceBlockRelated;
+	bool foundUnmatchedBrace;
 	bool isInPotentialCalculation;
 	bool isCharImmediatelyPostComment;
 	bool isPreviousCharPostComment;
@@ -1051,6 +1353,8 @@ private:  // variables
 	bool processedFirstConditional;
 	bool isJavaStaticConstructor;
 
+	friend class ASCheckpoint;
+
 private:  // inline functions
 	// append the CURRENT character (curentChar) to the current formatted line.
 	void appendCurrentChar(bool canBreakLine = true)
@@ -1069,6 +1373,34 @@ private:  // inline functions
 	{ return ASBase::findOperator(currentLine, charNum, operators_); }
 };  // Class ASFormatter
 
+//-----------------------------------------------------------------------------
+// Class ASCheckpoint
+// A snapshot of the ASFormatter parse state taken between two output lines.
+// Formatting is resumed by a copy of the saved formatter that reads from
+// a new source iterator positioned at the saved stream position.
+//-----------------------------------------------------------------------------
+
+class ASCheckpoint
+{
+public:
+	ASCheckpoint(const ASFormatter& formatter_, int lineNumber_);
+	~ASCheckpoint();
+	ASFormatter* resumeFormatter(ASSourceIterator* si) const;
+
+private:
+	ASCheckpoint(const ASCheckpoint& copy);       // not to be implemented
+	ASCheckpoint& operator=(ASCheckpoint&);       // not to be implemented
+	static ASFormatter* copyFormatter(const ASFormatter& formatter_);
+
+	ASFormatter* formatter;         // copy of the formatter at the checkpoint
+	streamoff streamPosition;       // source iterator position, -1 at end of input
+	int lineNumber;                 // number of lines output before the checkpoint
+
+public:	// inline functions
+	int getLineNumber() const { return lineNumber; }
+	streamoff getStreamPosition() const { return streamPosition; }
+};  // Class ASCheckpoint
+
 //-----------------------------------------------------------------------------
 // astyle namespace global declarations
 //-----------------------------------------------------------------------------
@@ -36,11 +36,21 @@
 #include "astyle_main.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <clocale>		// needed by some compilers
 #include <cstdlib>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <thread>
+
+// SSE2 is used for the ASCII blocks in ASEncoding, the same as ASResource.cpp
+#if !defined(ASTYLE_NO_SIMD) \
+        && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define ASTYLE_SSE2
+	#include <emmintrin.h>
+#endif
 
 // includes for recursive getFileNames() function
 #ifdef _WIN32
@@ -48,7 +58,9 @@
 	#include <windows.h>
 #else
 	#include <dirent.h>
+	#include <fcntl.h>
 	#include <unistd.h>
+	#include <sys/mman.h>
 	#include <sys/stat.h>
 	#ifdef __VMS
 		#include <unixlib.h>
@@ -128,12 +140,12 @@ ASStreamIterator<T>::~ASStreamIterator()
 * get the length of the input stream.
 * streamLength variable is set by the constructor.
 *
-* @return     length of the input file stream, converted to an int.
+* @return     length of the input file stream.
 */
 template<typename T>
-int ASStreamIterator<T>::getStreamLength() const
+streamoff ASStreamIterator<T>::getStreamLength() const
 {
-	return static_cast<int>(streamLength);
+	return streamLength;
 }
 
 /**
@@ -325,6 +337,456 @@ bool ASStreamIterator<T>::getLineEndChange(int lineEndFormat) const
 	return lineEndChange;
 }
 
+// the stringstream iterator is not used by AStyle
+// it must be available to the test programs
+template class ASStreamIterator<stringstream>;
+
+//-----------------------------------------------------------------------------
+// ASBufferIterator class
+// the input is a contiguous buffer that must remain valid until
+// the formatting is complete
+// or it is a stream that is read in blocks as the lines are needed,
+// the data before the current line or peek start is then discarded
+// the stream state (eof, tellg) is the same as an ASStreamIterator
+// would have for the same input
+//-----------------------------------------------------------------------------
+
+ASBufferIterator::ASBufferIterator(const char* data, size_t dataLength)
+{
+	inData = data;
+	inLength = dataLength;
+	inStream = nullptr;
+	inBlockSize = 0;
+	inStreamEnd = true;
+	inWindowStart = 0;
+	inReadEnd = 0;
+	inPos = 0;
+	inEof = false;
+	lfSearchStart = string::npos;
+	lfFound = 0;
+	crSearchStart = string::npos;
+	crFound = 0;
+	lineCacheNext = 0;
+	peekIndex = 0;
+	bytesSplit = 0;
+	bytesPeeked = 0;
+	buffer.reserve(200);
+	lineNumber = 0;
+	prevLineNumber = 0;
+	eolWindows = 0;
+	eolLinux = 0;
+	eolMacOld = 0;
+	peekStart = 0;
+	prevLineDeleted = false;
+	checkForEmptyLine = false;
+}
+
+/**
+ * read the lines from a stream that may not support tellg and seekg.
+ * the stream is read only when a line is needed, so the output can be
+ *     written before all of the input has been read.
+ * each read is at most 'blockSize' bytes, see readStream().
+ * the data kept is bounded by the lines peeked ahead by the formatter.
+ */
+ASBufferIterator::ASBufferIterator(istream* in, size_t blockSize)
+	: ASBufferIterator(static_cast<const char*>(nullptr), 0)
+{
+	assert(in != nullptr && blockSize > 0);
+	inStream = in;
+	inBlockSize = blockSize;
+	inStreamEnd = false;
+}
+
+ASBufferIterator::~ASBufferIterator()
+{
+}
+
+/**
+* get the length of the input buffer.
+*
+* @return     length of the input buffer.
+*/
+streamoff ASBufferIterator::getStreamLength() const
+{
+	return static_cast<streamoff>(inLength);
+}
+
+/**
+ * find the end of the line beginning at 'start'.
+ *
+ * @return        position of the next '\n' or '\r', or the buffer length.
+ */
+size_t ASBufferIterator::findLineEnd(size_t start)
+{
+	if (inStream != nullptr)
+		return findStreamLineEnd(start);
+	size_t lfPos = findNextChar('\n', start, lfSearchStart, lfFound);
+	size_t crPos = findNextChar('\r', start, crSearchStart, crFound);
+	return min(lfPos, crPos);
+}
+
+/**
+ * find the next 'ch' at or after 'start' using memchr.
+ * the previous search is reused if 'start' is within the searched range,
+ *     so a file with only one kind of line end is searched once for the other.
+ *
+ * @param searchStart   start of the previous search, updated for a new search.
+ * @param found         result of the previous search, updated for a new search.
+ * @return              position of the next 'ch', or the buffer length.
+ */
+size_t ASBufferIterator::findNextChar(char ch, size_t start, size_t& searchStart, size_t& found) const
+{
+	if (searchStart <= start && start <= found)
+		return found;
+	searchStart = start;
+	const void* chPtr = memchr(inData + start, ch, inLength - start);
+	if (chPtr == nullptr)
+		found = inLength;
+	else
+		found = static_cast<size_t>(static_cast<const char*>(chPtr) - inData);
+	return found;
+}
+
+/**
+ * find the end of the line beginning at 'start' in a stream.
+ * the search for a '\r' stops at the next '\n', so the stream is
+ *     read only as far as the end of the line.
+ *
+ * @return        position of the next '\n' or '\r', or the stream length.
+ */
+size_t ASBufferIterator::findStreamLineEnd(size_t start)
+{
+	size_t searchStart = start;
+	while (true)
+	{
+		if (searchStart < inLength)
+		{
+			const char* searchData = charAt(searchStart);
+			size_t searchLength = inLength - searchStart;
+			const void* lfPtr = memchr(searchData, '\n', searchLength);
+			if (lfPtr != nullptr)
+				searchLength = static_cast<size_t>(static_cast<const char*>(lfPtr) - searchData);
+			const void* crPtr = memchr(searchData, '\r', searchLength);
+			if (crPtr != nullptr)
+				return searchStart + static_cast<size_t>(static_cast<const char*>(crPtr) - searchData);
+			if (lfPtr != nullptr)
+				return searchStart + searchLength;
+			searchStart = inLength;
+		}
+		if (!readStream())
+			return inLength;
+	}
+}
+
+/**
+ * check for input at position 'pos', reading the stream if needed.
+ *
+ * @return        true if 'pos' is before the end of the input.
+ */
+bool ASBufferIterator::hasData(size_t pos)
+{
+	inReadEnd = max(inReadEnd, pos + 1);
+	while (pos >= inLength)
+	{
+		if (!readStream())
+			return false;
+	}
+	return true;
+}
+
+/**
+ * read the next block from the stream into the window.
+ * the block is the data that is available without waiting, or the next
+ *     line if none is, so a slow pipe is formatted as its lines arrive.
+ * the data before the current line, or the peek start, is no longer
+ *     needed and is discarded when it is at least half of the window.
+ *
+ * @return        true if any data was read.
+ */
+bool ASBufferIterator::readStream()
+{
+	if (inStreamEnd)
+		return false;
+	// a peek starts at the first line in lineCache that has not been returned
+	size_t keepPos = inPos;
+	if (lineCacheNext < lineCache.size())
+		keepPos = min(keepPos, lineCache[lineCacheNext].start);
+	if (keepPos > inWindowStart && keepPos - inWindowStart >= inWindow.length() / 2)
+	{
+		inWindow.erase(0, keepPos - inWindowStart);
+		inWindowStart = keepPos;
+	}
+	size_t windowLength = inWindow.length();
+	inWindow.resize(windowLength + inBlockSize);
+	char* readData = &inWindow[windowLength];
+	size_t bytesRead = static_cast<size_t>(inStream->readsome(readData, static_cast<streamsize>(inBlockSize)));
+	if (bytesRead == 0 && *inStream)
+		bytesRead = readStreamLine(readData);
+	inWindow.resize(windowLength + bytesRead);
+	if (bytesRead == 0)
+		inStreamEnd = true;
+	inData = inWindow.data();
+	inLength = inWindowStart + inWindow.length();
+	return (bytesRead > 0);
+}
+
+/**
+ * read the stream to the end of the next line, waiting for the data.
+ * the line end is a '\n' or a '\r', the read stops after 'inBlockSize'
+ *     bytes if there is no line end.
+ *
+ * @param readData    the window position to read into.
+ * @return            number of bytes read, 0 at the end of the stream.
+ */
+size_t ASBufferIterator::readStreamLine(char* readData)
+{
+	streambuf* inBuffer = inStream->rdbuf();
+	size_t bytesRead = 0;
+	while (bytesRead < inBlockSize)
+	{
+		int ch = inBuffer->sbumpc();
+		if (ch == char_traits<char>::eof())
+			break;
+		readData[bytesRead++] = static_cast<char>(ch);
+		if (ch == '\n' || ch == '\r')
+			break;
+	}
+	return bytesRead;
+}
+
+/**
+ * split the line beginning at 'start' from the buffer.
+ * the end of line characters removed are the same as ASStreamIterator.
+ *
+ * @return        the position and length of the line.
+ */
+ASBufferIterator::LineSpan ASBufferIterator::splitLine(size_t start)
+{
+	LineSpan line;
+	size_t lineEnd = findLineEnd(start);
+	inReadEnd = max(inReadEnd, lineEnd + 1);
+	line.start = start;
+	line.length = lineEnd - start;
+	line.eolLength = 0;
+	if (lineEnd < inLength)
+	{
+		// CR+LF or LF+CR is one line end
+		line.eolLength = 1;
+		if (hasData(lineEnd + 1))
+		{
+			char ch = *charAt(lineEnd);
+			char peekCh = *charAt(lineEnd + 1);
+			if ((peekCh == '\n' || peekCh == '\r') && peekCh != ch)
+				line.eolLength = 2;
+		}
+	}
+	bytesSplit += line.length + line.eolLength;
+	return line;
+}
+
+/**
+ * get the next line from the buffer, delete any end of line characters,
+ *     and build a string that contains the input line.
+ *
+ * @return        string containing the next input line minus any end of line characters
+ */
+string ASBufferIterator::nextLine(bool emptyLineWasDeleted)
+{
+	// verify that the current position is correct
+	assert(peekStart == 0);
+
+	// a deleted line may be replaced if break-blocks is requested
+	// this sets up the compare to check for a replaced empty line
+	if (prevLineDeleted)
+	{
+		prevLineDeleted = false;
+		checkForEmptyLine = true;
+	}
+	if (!emptyLineWasDeleted)
+	{
+		prevBuffer = buffer;
+		prevLineNumber = lineNumber;
+	}
+	else
+		prevLineDeleted = true;
+
+	// get the next record, it may have been split by peekNextLine
+	LineSpan line;
+	if (lineCacheNext < lineCache.size() && lineCache[lineCacheNext].start == inPos)
+	{
+		line = lineCache[lineCacheNext++];
+		if (lineCacheNext == lineCache.size())
+		{
+			lineCache.clear();
+			lineCacheNext = 0;
+		}
+	}
+	else
+	{
+		lineCache.clear();
+		lineCacheNext = 0;
+		line = splitLine(inPos);
+	}
+	buffer.assign(charAt(line.start), line.length);
+	lineNumber++;
+	inPos = line.start + line.length + line.eolLength;
+
+	if (line.eolLength == 0)
+	{
+		inEof = true;
+		return buffer;
+	}
+
+	// find input end-of-line characters
+	// an end of buffer after a single end of line character is not counted
+	if (line.eolLength == 2)            // CR+LF is windows, allow for improbable LF/CR
+		eolWindows++;
+	else if (hasData(inPos))
+	{
+		if (*charAt(line.start + line.length) == '\r')
+			eolMacOld++;                // CR alone is Mac OS 9
+		else
+			eolLinux++;                 // LF alone is Linux
+	}
+
+	// has not detected an input end of line
+	if (!eolWindows && !eolLinux && !eolMacOld)
+	{
+#ifdef _WIN32
+		eolWindows++;
+#else
+		eolLinux++;
+#endif
+	}
+
+	// set output end of line characters
+	if (eolWindows >= eolLinux)
+	{
+		if (eolWindows >= eolMacOld)
+			outputEOL = "\r\n";     // Windows (CR+LF)
+		else
+			outputEOL = "\r";       // MacOld (CR)
+	}
+	else if (eolLinux >= eolMacOld)
+		outputEOL = "\n";           // Linux (LF)
+	else
+		outputEOL = "\r";           // MacOld (CR)
+
+	return buffer;
+}
+
+// save the current position and get the next line
+// this can be called for multiple reads
+// when finished peeking you MUST call peekReset()
+// call this function from ASFormatter ONLY
+// the lines are split once and saved in lineCache,
+// so peeking the same lines again does not search the buffer
+string ASBufferIterator::peekNextLine()
+{
+	assert(hasMoreLines());
+
+	if (peekStart == 0)
+	{
+		peekStart = static_cast<streamoff>(inPos);
+		peekIndex = lineCacheNext;
+	}
+
+	// get the next record
+	LineSpan line;
+	if (peekIndex < lineCache.size() && lineCache[peekIndex].start == inPos)
+		line = lineCache[peekIndex];
+	else
+	{
+		lineCache.erase(lineCache.begin() + peekIndex, lineCache.end());
+		line = splitLine(inPos);
+		lineCache.emplace_back(line);
+	}
+	peekIndex++;
+	bytesPeeked += line.length + line.eolLength;
+	inPos = line.start + line.length + line.eolLength;
+
+	// a stream peek at the end of the input sets eof
+	if (line.eolLength == 0 || (line.eolLength == 1 && !hasData(inPos)))
+		inEof = true;
+
+	return string(charAt(line.start), line.length);
+}
+
+// reset current position and EOF for peekNextLine()
+void ASBufferIterator::peekReset()
+{
+	assert(peekStart != 0);
+	inEof = false;
+	inPos = static_cast<size_t>(peekStart);
+	peekStart = 0;
+}
+
+// save the last input line after input has reached EOF
+void ASBufferIterator::saveLastInputLine()
+{
+	assert(inEof);
+	prevBuffer = buffer;
+	prevLineNumber = lineNumber;
+}
+
+// return position of the get pointer
+// a stream returns -1 after it has reached EOF
+streamoff ASBufferIterator::tellg()
+{
+	if (inEof)
+		return -1;
+	return static_cast<streamoff>(inPos);
+}
+
+// set the position of the get pointer to resume from an ASCheckpoint
+// a position of -1 is the end of the input, the same as tellg
+// a stream is then read to the end, waiting for a pipe to be closed,
+// and the rest of the input is kept in the window
+// the line end counts and the line numbers are not restored
+// a stream cannot be positioned before the data that has been discarded
+void ASBufferIterator::seekg(streamoff pos)
+{
+	assert(peekStart == 0);
+	assert(inStream == nullptr || pos >= static_cast<streamoff>(inWindowStart));
+	if (pos < 0)
+	{
+		while (readStream())
+			continue;
+	}
+	assert(pos <= static_cast<streamoff>(inLength));
+	lineCache.clear();
+	lineCacheNext = 0;
+	inEof = (pos < 0);
+	inPos = inEof ? inLength : static_cast<size_t>(pos);
+}
+
+// check for a change in line ends
+bool ASBufferIterator::getLineEndChange(int lineEndFormat) const
+{
+	assert(lineEndFormat == LINEEND_DEFAULT
+	       || lineEndFormat == LINEEND_WINDOWS
+	       || lineEndFormat == LINEEND_LINUX
+	       || lineEndFormat == LINEEND_MACOLD);
+
+	bool lineEndChange = false;
+	if (lineEndFormat == LINEEND_WINDOWS)
+		lineEndChange = (eolLinux + eolMacOld != 0);
+	else if (lineEndFormat == LINEEND_LINUX)
+		lineEndChange = (eolWindows + eolMacOld != 0);
+	else if (lineEndFormat == LINEEND_MACOLD)
+		lineEndChange = (eolWindows + eolLinux != 0);
+	else
+	{
+		if (eolWindows > 0)
+			lineEndChange = (eolLinux + eolMacOld != 0);
+		else if (eolLinux > 0)
+			lineEndChange = (eolWindows + eolMacOld != 0);
+		else if (eolMacOld > 0)
+			lineEndChange = (eolWindows + eolLinux != 0);
+	}
+	return lineEndChange;
+}
+
 //-----------------------------------------------------------------------------
 // ASConsole class
 // main function will be included only in the console build
@@ -338,6 +800,7 @@ ASConsole::ASConsole(ASFormatter& formatterArg) : formatter(formatterArg)
 	// command line options
 	isRecursive = false;
 	isDryRun = false;
+	isCheck = false;
 	noBackup = false;
 	preserveDate = false;
 	isVerbose = false;
@@ -346,6 +809,7 @@ ASConsole::ASConsole(ASFormatter& formatterArg) : formatter(formatterArg)
 	ignoreExcludeErrors = false;
 	ignoreExcludeErrorsDisplay = false;
 	useAscii = false;
+	numJobs = 1;
 	// other variables
 	bypassBrowserOpen = false;
 	hasWildcard = false;
@@ -355,97 +819,102 @@ ASConsole::ASConsole(ASFormatter& formatterArg) : formatter(formatterArg)
 	mainDirectoryLength = 0;
 	filesFormatted = 0;
 	filesUnchanged = 0;
+	filesVerifyFailed = 0;
 	linesOut = 0;
+	changedLine = 0;
+	verifyFailed = false;
+	isWorker = false;
+	cacheHits = 0;
+	cacheMisses = 0;
 }
 
 ASConsole::~ASConsole()
 {}
 
-// rewrite a stringstream converting the line ends
-void ASConsole::convertLineEnds(ostringstream& out, int lineEnd)
+// compute a hash of the options used to format the files
+// the program version is included since it may change the formatting
+// options that do not change the formatted text are not included
+uint64_t ASConsole::computeOptionsHash()
+{
+	ASOptions options(formatter, *this);
+	string optionsText = g_version;
+	const vector<string>* vectors[] = { &fileOptionsVector, &projectOptionsVector, &optionsVector };
+	for (const vector<string>* optionVector : vectors)
+	{
+		optionsText.append("\n");
+		optionsText.append(options.getFormattingOptions(*optionVector));
+	}
+	return ASFileCache::computeHash(optionsText.data(), optionsText.length());
+}
+
+// convert the line ends of the output in place
+// a CR+LF is one line end
+void ASConsole::convertLineEnds(string& out, int lineEnd)
 {
 	assert(lineEnd == LINEEND_WINDOWS || lineEnd == LINEEND_LINUX || lineEnd == LINEEND_MACOLD);
-	const string& inStr = out.str();	// avoids strange looking syntax
-	string outStr;						// the converted output
-	int inLength = (int) inStr.length();
-	for (int pos = 0; pos < inLength; pos++)
+	size_t outLength = out.length();
+	if (lineEnd == LINEEND_CRLF)
 	{
-		if (inStr[pos] == '\r')
+		// count the single CR and LF line ends, each needs another char
+		size_t added = 0;
+		for (size_t pos = 0; pos < outLength; pos++)
 		{
-			if (inStr[pos + 1] == '\n')
+			if (out[pos] == '\r')
 			{
-				// CRLF
-				if (lineEnd == LINEEND_CR)
-				{
-					outStr += inStr[pos];		// Delete the LF
-					pos++;
-					continue;
-				}
-				else if (lineEnd == LINEEND_LF)
-				{
-					outStr += inStr[pos + 1];		// Delete the CR
-					pos++;
-					continue;
-				}
-				else
-				{
-					outStr += inStr[pos];		// Do not change
-					outStr += inStr[pos + 1];
+				if (pos + 1 < outLength && out[pos + 1] == '\n')
 					pos++;
-					continue;
-				}
-			}
-			else
-			{
-				// CR
-				if (lineEnd == LINEEND_CRLF)
-				{
-					outStr += inStr[pos];		// Insert the CR
-					outStr += '\n';				// Insert the LF
-					continue;
-				}
-				else if (lineEnd == LINEEND_LF)
-				{
-					outStr += '\n';				// Insert the LF
-					continue;
-				}
 				else
-				{
-					outStr += inStr[pos];		// Do not change
-					continue;
-				}
+					added++;
 			}
+			else if (out[pos] == '\n')
+				added++;
 		}
-		else if (inStr[pos] == '\n')
+		if (added == 0)
+			return;
+		// expand from the end so each char is moved once
+		out.resize(outLength + added);
+		size_t dest = out.length();
+		size_t pos = outLength;
+		while (pos > 0)
 		{
-			// LF
-			if (lineEnd == LINEEND_CRLF)
+			char ch = out[--pos];
+			if (ch == '\n')
 			{
-				outStr += '\r';				// Insert the CR
-				outStr += inStr[pos];		// Insert the LF
-				continue;
+				if (pos > 0 && out[pos - 1] == '\r')
+					--pos;                  // Do not change
+				out[--dest] = '\n';
+				out[--dest] = '\r';         // Insert the CR
 			}
-			else if (lineEnd == LINEEND_CR)
+			else if (ch == '\r')
 			{
-				outStr += '\r';				// Insert the CR
-				continue;
+				out[--dest] = '\n';         // Insert the LF
+				out[--dest] = '\r';
 			}
 			else
-			{
-				outStr += inStr[pos];		// Do not change
-				continue;
-			}
+				out[--dest] = ch;
 		}
-		else
+		assert(dest == 0);
+		return;
+	}
+	// the converted output is not longer than the input
+	char eolChar = (lineEnd == LINEEND_LF) ? '\n' : '\r';
+	size_t dest = 0;
+	for (size_t pos = 0; pos < outLength; pos++)
+	{
+		char ch = out[pos];
+		if (ch == '\r' || ch == '\n')
 		{
-			outStr += inStr[pos];		// Write the current char
+			if (ch == '\r' && pos + 1 < outLength && out[pos + 1] == '\n')
+				pos++;                      // Delete the CR or LF
+			out[dest++] = eolChar;
 		}
+		else
+			out[dest++] = ch;
 	}
-	// replace the stream
-	out.str(outStr);
+	out.resize(dest);
 }
 
-void ASConsole::correctMixedLineEnds(ostringstream& out)
+void ASConsole::correctMixedLineEnds(string& out)
 {
 	LineEndFormat lineEndFormat = LINEEND_DEFAULT;
 	if (outputEOL == "\r\n")
@@ -492,6 +961,17 @@ void ASConsole::error(const char* why, const char* what) const
 	error();
 }
 
+// error for a file being formatted
+// a worker console cannot exit, so the first message is saved in
+// fileErrorMessage and the main console reports it after the threads end
+void ASConsole::fileError(const char* why, const char* what)
+{
+	if (!isWorker)
+		error(why, what);
+	if (fileErrorMessage.empty())
+		fileErrorMessage = string(why) + ' ' + what;
+}
+
 /**
  * If no files have been given, use cin for input and cout for output.
  *
@@ -516,18 +996,13 @@ void ASConsole::formatCinToCout()
 	// The Windows problem occurs when the input is not Windows line-ends.
 	// The tellg() will be out of sequence with the get() statements.
 	// The Linux cin.tellg() will return -1 (invalid).
-	// Copying the input sequentially to a stringstream before
-	// formatting solves the problem for both.
-	istream* inStream = &cin;
-	stringstream outStream;
-	char ch;
-	inStream->get(ch);
-	while (!inStream->eof() && !inStream->fail())
-	{
-		outStream.put(ch);
-		inStream->get(ch);
-	}
-	ASStreamIterator<stringstream> streamIterator(&outStream);
+	// Reading the input sequentially in blocks solves the problem for both.
+	// The blocks are read as the lines are needed, and a read does not
+	// wait for more than one line, so the output is written while the
+	// input is read. A read of cin flushes cout.
+	// With the verify option the output is held until all of the lines
+	// have been formatted, and is not written if the verify fails.
+	ASBufferIterator streamIterator(&cin);
 	// Windows pipe or redirection always outputs Windows line-ends.
 	// Linux pipe or redirection will output any line end.
 #ifdef _WIN32
@@ -538,13 +1013,21 @@ void ASConsole::formatCinToCout()
 	initializeOutputEOL(lineEndFormat);
 	formatter.init(&streamIterator);
 
+	if (isCheck)
+	{
+		checkCinFormatting(streamIterator, lineEndFormat);
+		return;
+	}
+
+	ostringstream verifyBuffer;
+	ostream& out = formatter.getVerifyMode() ? verifyBuffer : cout;
 	while (formatter.hasMoreLines())
 	{
-		cout << formatter.nextLine();
+		out << formatter.nextLine();
 		if (formatter.hasMoreLines())
 		{
 			setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-			cout << outputEOL;
+			out << outputEOL;
 		}
 		else
 		{
@@ -552,14 +1035,96 @@ void ASConsole::formatCinToCout()
 			if (formatter.getIsLineReady())
 			{
 				setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-				cout << outputEOL;
-				cout << formatter.nextLine();
+				out << outputEOL;
+				out << formatter.nextLine();
 			}
 		}
 	}
+	if (formatter.getVerifyFailed())
+		error(_("Verify failed for"), "standard input");
+	if (formatter.getVerifyMode())
+		cout << verifyBuffer.str();
 	cout.flush();
 }
 
+/**
+ * Check the formatting of cin for the check option.
+ * The formatted text is not written to cout. Formatting stops at the
+ * first changed line and the result is reported the same as a file,
+ * so the exit code shows if the input would be changed.
+ *
+ * @param streamIterator    The iterator for cin.
+ * @param lineEndFormat     The line end format for the output.
+ */
+void ASConsole::checkCinFormatting(ASBufferIterator& streamIterator, LineEndFormat lineEndFormat)
+{
+	string nextLine;				// next output line
+	filesAreIdentical = true;		// input and output are identical
+	changedLine = 0;
+	int unchangedLine = 0;			// last unchanged input line
+	while (formatter.hasMoreLines())
+	{
+		nextLine = formatter.nextLine();
+		if (formatter.hasMoreLines())
+			setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
+		else
+		{
+			streamIterator.saveLastInputLine();     // to compare the last input line
+			// this can happen if the file if missing a closing brace and break-blocks is requested
+			if (formatter.getIsLineReady())
+			{
+				setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
+				nextLine = formatter.nextLine();
+				streamIterator.saveLastInputLine();
+			}
+		}
+		compareFormattedLine(streamIterator, nextLine, unchangedLine);
+
+		// the remaining lines are not needed to check the input
+		if (!filesAreIdentical)
+			break;
+	}
+	bool isFormatted = (!filesAreIdentical || streamIterator.getLineEndChange(lineEndFormat));
+	reportFileResult("standard input", isFormatted, changedLine);
+	// the verify is valid only if all of the lines were formatted
+	if (filesAreIdentical && formatter.getVerifyFailed())
+		reportVerifyFailure("standard input");
+}
+
+/**
+ * Compare a formatted line to the input line it replaces.
+ * Used by formatAndWriteFile() and checkCinFormatting().
+ * At the first changed line filesAreIdentical is cleared, and with the
+ * check option the input line number is saved in changedLine.
+ * The formatter may read ahead of the output line, so the changed line is
+ * the line after the last unchanged line if that is before the compared line.
+ *
+ * @param streamIterator    The iterator for the input.
+ * @param nextLine          The formatted line.
+ * @param unchangedLine     The last input line found unchanged, updated.
+ */
+void ASConsole::compareFormattedLine(ASBufferIterator& streamIterator, const string& nextLine,
+                                     int& unchangedLine)
+{
+	if (!filesAreIdentical)
+		return;
+	if (streamIterator.checkForEmptyLine)
+	{
+		// a deleted empty line was replaced
+		if (nextLine.find_first_not_of(" \t") != string::npos)
+			filesAreIdentical = false;
+		else
+			unchangedLine++;
+	}
+	else if (!streamIterator.compareToInputBuffer(nextLine))
+		filesAreIdentical = false;
+	else
+		unchangedLine = streamIterator.getCompareLineNumber();
+	streamIterator.checkForEmptyLine = false;
+	if (!filesAreIdentical && isCheck)
+		changedLine = min(unchangedLine + 1, streamIterator.getCompareLineNumber());
+}
+
 /**
  * Open input file, format it, and close the output.
  *
@@ -567,9 +1132,45 @@ void ASConsole::formatCinToCout()
  */
 void ASConsole::formatFile(const string& fileName_)
 {
-	stringstream in;
-	ostringstream out;
+	if (isFileCached(fileName_))
+	{
+		reportFileResult(fileName_, false, 0);
+		return;
+	}
+	bool isFormatted = formatAndWriteFile(fileName_);
+	if (verifyFailed)
+	{
+		reportVerifyFailure(fileName_);
+		return;
+	}
+	updateFileCache(fileName_, isFormatted);
+	reportFileResult(fileName_, isFormatted, changedLine);
+}
+
+/**
+ * Format a file and write it if it has changed.
+ * Nothing is displayed. This is called by the worker threads
+ * so it must use only the variables of this ASConsole object.
+ * A worker that cannot read or write the file saves the error
+ * in fileErrorMessage and returns false.
+ * With the check option formatting stops at the first changed line,
+ * the input line number is saved in changedLine.
+ * With the verify option a file that fails the verify is not written,
+ * and verifyFailed is set.
+ *
+ * @param fileName_     The path and name of the file to be processed.
+ * @return              true if the file was formatted (changed).
+ */
+bool ASConsole::formatAndWriteFile(const string& fileName_)
+{
+	ASMappedFile in;
+	string out;						// the formatted file
+	fileErrorMessage.clear();
 	FileEncoding encoding = readFile(fileName_, in);
+	if (!fileErrorMessage.empty())
+		return false;
+	// allow for added indentation and line ends
+	out.reserve(in.getSize() + in.getSize() / 16);
 
 	// Unless a specific language mode has been set, set the language mode
 	// according to the file's suffix.
@@ -586,22 +1187,25 @@ void ASConsole::formatFile(const string& fileName_)
 	// set line end format
 	string nextLine;				// next output line
 	filesAreIdentical = true;		// input and output files are identical
+	changedLine = 0;
+	int unchangedLine = 0;			// last unchanged input line
+	verifyFailed = false;
 	LineEndFormat lineEndFormat = formatter.getLineEndFormat();
 	initializeOutputEOL(lineEndFormat);
 	// do this AFTER setting the file mode
-	ASStreamIterator<stringstream> streamIterator(&in);
+	ASBufferIterator streamIterator(in.getData(), in.getSize());
 	formatter.init(&streamIterator);
 
 	// format the file
 	while (formatter.hasMoreLines())
 	{
 		nextLine = formatter.nextLine();
-		out << nextLine;
+		out.append(nextLine);
 		linesOut++;
 		if (formatter.hasMoreLines())
 		{
 			setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-			out << outputEOL;
+			out.append(outputEOL);
 		}
 		else
 		{
@@ -610,26 +1214,29 @@ void ASConsole::formatFile(const string& fileName_)
 			if (formatter.getIsLineReady())
 			{
 				setOutputEOL(lineEndFormat, streamIterator.getOutputEOL());
-				out << outputEOL;
+				out.append(outputEOL);
 				nextLine = formatter.nextLine();
-				out << nextLine;
+				out.append(nextLine);
 				linesOut++;
 				streamIterator.saveLastInputLine();
 			}
 		}
+		compareFormattedLine(streamIterator, nextLine, unchangedLine);
 
-		if (filesAreIdentical)
-		{
-			if (streamIterator.checkForEmptyLine)
-			{
-				if (nextLine.find_first_not_of(" \t") != string::npos)
-					filesAreIdentical = false;
-			}
-			else if (!streamIterator.compareToInputBuffer(nextLine))
-				filesAreIdentical = false;
-			streamIterator.checkForEmptyLine = false;
-		}
+		// the remaining lines are not needed to check the file
+		if (isCheck && !filesAreIdentical)
+			return true;
+	}
+	// the input must be released before the file is replaced
+	in.close();
+
+	// the formatted file does not have the same text as the input
+	if (formatter.getVerifyFailed())
+	{
+		verifyFailed = true;
+		return false;
 	}
+
 	// correct for mixed line ends
 	if (lineEndsMixed)
 	{
@@ -637,29 +1244,105 @@ void ASConsole::formatFile(const string& fileName_)
 		filesAreIdentical = false;
 	}
 
-	// remove targetDirectory from filename if required by print
-	string displayName;
-	if (hasWildcard)
-		displayName = fileName_.substr(targetDirectory.length() + 1);
-	else
-		displayName = fileName_;
-
 	// if file has changed, write the new file
-	if (!filesAreIdentical || streamIterator.getLineEndChange(lineEndFormat))
+	bool isFormatted = (!filesAreIdentical || streamIterator.getLineEndChange(lineEndFormat));
+	if (isFormatted && !isDryRun)
+		writeFile(fileName_, encoding, out);
+
+	assert(formatter.getChecksumDiff() == 0);
+	return isFormatted;
+}
+
+/**
+ * Format the files in the fileName vector concurrently.
+ * Each worker has its own ASFormatter and ASConsole, and formats the
+ * files from an ASBufferIterator the same as formatFile().
+ * The results are saved for each file. After the threads have ended they
+ * are copied to this ASConsole and reported in fileName order, so the
+ * report does not depend on the thread timing. A file that could not be
+ * read or written is reported with the others, then the program exits.
+ *
+ * @param workers       The worker consoles, one for each thread.
+ */
+void ASConsole::formatFilesConcurrently(vector<unique_ptr<ASConsole> >& workers)
+{
+	// the variables set by formatAndWriteFile() for a file
+	struct FileResult
+	{
+		bool isCached;
+		bool isFormatted;
+		bool filesAreIdentical;
+		bool lineEndsMixed;
+		bool verifyFailed;
+		int  changedLine;
+		string errorMessage;
+		FileResult() : isCached(false), isFormatted(false), filesAreIdentical(true),
+		    lineEndsMixed(false), verifyFailed(false), changedLine(0) {}
+	};
+	// each element is written by only one thread
+	vector<FileResult> result(fileName.size());
+	// the cache is checked before the threads are started
+	for (size_t j = 0; j < fileName.size(); j++)
+		result[j].isCached = isFileCached(fileName[j]);
+	atomic<size_t> nextFile(0);
+	vector<thread> threads;
+	size_t numThreads = min(workers.size(), fileName.size());
+	for (size_t i = 0; i < numThreads; i++)
+	{
+		ASConsole* worker = workers[i].get();
+		threads.emplace_back([this, worker, &result, &nextFile]()
+		{
+			for (size_t j = nextFile++; j < fileName.size(); j = nextFile++)
+			{
+				if (result[j].isCached)
+					continue;
+				result[j].isFormatted = worker->formatAndWriteFile(fileName[j]);
+				result[j].filesAreIdentical = worker->filesAreIdentical;
+				result[j].lineEndsMixed = worker->lineEndsMixed;
+				result[j].verifyFailed = worker->verifyFailed;
+				result[j].changedLine = worker->changedLine;
+				result[j].errorMessage = worker->fileErrorMessage;
+			}
+		});
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	// merge the statistics
+	for (size_t i = 0; i < numThreads; i++)
 	{
-		if (!isDryRun)
-			writeFile(fileName_, encoding, out);
-		printMsg(_("Formatted  %s\n"), displayName);
-		filesFormatted++;
+		linesOut += workers[i]->linesOut;
+		workers[i]->linesOut = 0;
 	}
-	else
+	// the variables are left as formatFile() would leave them
+	bool hasFileError = false;
+	for (size_t j = 0; j < fileName.size(); j++)
 	{
-		if (!isFormattedOnly)
-			printMsg(_("Unchanged  %s\n"), displayName);
-		filesUnchanged++;
+		if (result[j].isCached)
+		{
+			reportFileResult(fileName[j], false, 0);
+			continue;
+		}
+		filesAreIdentical = result[j].filesAreIdentical;
+		lineEndsMixed = result[j].lineEndsMixed;
+		verifyFailed = result[j].verifyFailed;
+		changedLine = result[j].changedLine;
+		if (!result[j].errorMessage.empty())
+		{
+			(*errorStream) << result[j].errorMessage << endl;
+			hasFileError = true;
+			continue;
+		}
+		if (verifyFailed)
+		{
+			reportVerifyFailure(fileName[j]);
+			continue;
+		}
+		updateFileCache(fileName[j], result[j].isFormatted);
+		reportFileResult(fileName[j], result[j].isFormatted, changedLine);
 	}
-
-	assert(formatter.getChecksumDiff() == 0);
+	if (hasFileError)
+		error();
 }
 
 /**
@@ -733,6 +1416,10 @@ bool ASConsole::getFilesAreIdentical() const
 int ASConsole::getFilesFormatted() const
 { return filesFormatted; }
 
+// for unit testing
+int ASConsole::getFilesVerifyFailed() const
+{ return filesVerifyFailed; }
+
 // for unit testing
 bool ASConsole::getIgnoreExcludeErrors() const
 { return ignoreExcludeErrors; }
@@ -741,6 +1428,9 @@ bool ASConsole::getIgnoreExcludeErrors() const
 bool ASConsole::getIgnoreExcludeErrorsDisplay() const
 { return ignoreExcludeErrorsDisplay; }
 
+bool ASConsole::getIsCheck() const
+{ return isCheck; }
+
 // for unit testing
 bool ASConsole::getIsDryRun() const
 { return isDryRun; }
@@ -773,6 +1463,10 @@ bool ASConsole::getLineEndsMixed() const
 bool ASConsole::getNoBackup() const
 { return noBackup; }
 
+// for unit testing
+int ASConsole::getNumJobs() const
+{ return numJobs; }
+
 // for unit testing
 string ASConsole::getOptionFileName() const
 { return optionFileName; }
@@ -816,6 +1510,22 @@ string ASConsole::getStdPathOut() const
 void ASConsole::setBypassBrowserOpen(bool state)
 { bypassBrowserOpen = state; }
 
+// for unit testing
+int ASConsole::getCacheHits() const
+{ return cacheHits; }
+
+// for unit testing
+int ASConsole::getCacheMisses() const
+{ return cacheMisses; }
+
+// for unit testing
+string ASConsole::getCacheFileName() const
+{ return cacheFileName; }
+
+// for unit testing
+int ASConsole::getChangedLine() const
+{ return changedLine; }
+
 // for unit testing
 ostream* ASConsole::getErrorStream() const
 {
@@ -897,6 +1607,30 @@ void ASConsole::initializeOutputEOL(LineEndFormat lineEndFormat)
 		outputEOL.clear();
 }
 
+// initialize a worker console used by formatFilesConcurrently()
+// the worker formatter gets the options from the same vectors as this formatter
+void ASConsole::initializeWorker(ASConsole& worker) const
+{
+	ASOptions options(worker.formatter, worker);
+	vector<string> workerFileOptions(fileOptionsVector);
+	vector<string> workerProjectOptions(projectOptionsVector);
+	vector<string> workerOptions(optionsVector);
+	// the options have been verified by processOptions()
+	options.parseOptions(workerFileOptions, string());
+	options.parseOptions(workerProjectOptions, string());
+	options.parseOptions(workerOptions, string());
+	// console variables that may have been set directly
+	worker.errorStream = errorStream;
+	worker.isWorker = true;
+	worker.isDryRun = isDryRun;
+	worker.isCheck = isCheck;
+	worker.noBackup = noBackup;
+	worker.preserveDate = preserveDate;
+	worker.origSuffix = origSuffix;
+	if (useAscii)
+		worker.localizer.setLanguageFromName("en");
+}
+
 // read a file into the stringstream 'in'
 FileEncoding ASConsole::readFile(const string& fileName_, stringstream& in) const
 {
@@ -916,6 +1650,7 @@ FileEncoding ASConsole::readFile(const string& fileName_, stringstream& in) cons
 		error(_("Cannot process UTF-32 encoding"), fileName_.c_str());
 	bool firstBlock = true;
 	bool isBigEndian = (encoding == UTF_16BE);
+	ASEncoding::eState utf16State = ASEncoding::eStart;
 	while (dataSize != 0)
 	{
 		if (encoding == UTF_16LE || encoding == UTF_16BE)
@@ -925,7 +1660,8 @@ FileEncoding ASConsole::readFile(const string& fileName_, stringstream& in) cons
 			char* utf8Out = new (nothrow) char[utf8Size];
 			if (utf8Out == nullptr)
 				error("Cannot allocate memory for utf-8 conversion", fileName_.c_str());
-			size_t utf8Len = encode.utf16ToUtf8(data, dataSize, isBigEndian, firstBlock, utf8Out);
+			size_t utf8Len = encode.utf16ToUtf8(data, dataSize, isBigEndian, firstBlock, utf8Out,
+			                                    &utf16State);
 			assert(utf8Len <= utf8Size);
 			in << string(utf8Out, utf8Len);
 			delete[] utf8Out;
@@ -943,6 +1679,39 @@ FileEncoding ASConsole::readFile(const string& fileName_, stringstream& in) cons
 	return encoding;
 }
 
+// map a file into the ASMappedFile 'in'
+// a utf-16 file is converted to utf-8
+FileEncoding ASConsole::readFile(const string& fileName_, ASMappedFile& in)
+{
+	if (!in.open(fileName_))
+	{
+		fileError("Cannot open file", fileName_.c_str());
+		return ENCODING_8BIT;
+	}
+	FileEncoding encoding = detectEncoding(in.getData(), in.getSize());
+	if (encoding == UTF_32BE || encoding == UTF_32LE)
+	{
+		fileError(_("Cannot process UTF-32 encoding"), fileName_.c_str());
+		return encoding;
+	}
+	if (encoding == UTF_16LE || encoding == UTF_16BE)
+	{
+		// convert utf-16 to utf-8
+		bool isBigEndian = (encoding == UTF_16BE);
+		char* data = const_cast<char*>(in.getData());
+		size_t utf8Size = encode.utf8LengthFromUtf16(data, in.getSize(), isBigEndian);
+		string utf8Out(utf8Size, '\0');
+		size_t utf8Len = encode.utf16ToUtf8(data, in.getSize(), isBigEndian, true, &utf8Out[0]);
+		assert(utf8Len <= utf8Size);
+		utf8Out.resize(utf8Len);
+		in.replaceData(utf8Out);
+	}
+	return encoding;
+}
+
+void ASConsole::setCacheFileName(const string& name)
+{ cacheFileName = name; }
+
 void ASConsole::setIgnoreExcludeErrors(bool state)
 { ignoreExcludeErrors = state; }
 
@@ -958,6 +1727,9 @@ void ASConsole::setIsQuiet(bool state)
 void ASConsole::setIsRecursive(bool state)
 { isRecursive = state; }
 
+void ASConsole::setIsCheck(bool state)
+{ isCheck = state; }
+
 void ASConsole::setIsDryRun(bool state)
 { isDryRun = state; }
 
@@ -967,6 +1739,9 @@ void ASConsole::setIsVerbose(bool state)
 void ASConsole::setNoBackup(bool state)
 { noBackup = state; }
 
+void ASConsole::setNumJobs(int jobs)
+{ numJobs = jobs; }
+
 void ASConsole::setOptionFileName(const string& name)
 { optionFileName = name; }
 
@@ -1715,6 +2490,27 @@ bool ASConsole::fileNameVectorIsEmpty() const
 	return fileNameVector.empty();
 }
 
+// the cache= file is not used with the verify option,
+// a file must be formatted to be verified
+bool ASConsole::isCacheUsed() const
+{
+	return !cacheFileName.empty() && !formatter.getVerifyMode();
+}
+
+// check the cache= file for a file that is already formatted
+bool ASConsole::isFileCached(const string& fileName_)
+{
+	if (!isCacheUsed())
+		return false;
+	if (fileCache.isFileCached(fileName_))
+	{
+		cacheHits++;
+		return true;
+	}
+	cacheMisses++;
+	return false;
+}
+
 bool ASConsole::isOption(const string& arg, const char* op)
 {
 	return arg.compare(op) == 0;
@@ -2193,6 +2989,28 @@ void ASConsole::printHelp() const
 	cout << "    --dry-run\n";
 	cout << "    Perform a trial run with no changes made to check for formatting.\n";
 	cout << endl;
+	cout << "    --check\n";
+	cout << "    Perform a dry run that stops checking a file at the first changed\n";
+	cout << "    line. The line number is displayed with the file name. The exit\n";
+	cout << "    code is 1 if a file would be formatted, 0 if not. Standard input\n";
+	cout << "    is checked the same way and is not written to standard output.\n";
+	cout << endl;
+	cout << "    --verify\n";
+	cout << "    Check that formatting did not change any characters except white\n";
+	cout << "    space. A file that fails is not written and an error is displayed.\n";
+	cout << "    The exit code is 1 if a file fails. Standard input that fails is\n";
+	cout << "    not written to standard output.\n";
+	cout << endl;
+	cout << "    --jobs=#\n";
+	cout << "    Format # files at the same time. The valid values are 0 thru 256.\n";
+	cout << "    The value 0 uses the number of processors on the machine.\n";
+	cout << "    The default value is 1, one file at a time.\n";
+	cout << endl;
+	cout << "    --cache=####\n";
+	cout << "    Keep a cache of the formatted files in the file ####. A file that\n";
+	cout << "    has not changed since it was formatted with the same options is\n";
+	cout << "    skipped and reported as unchanged.\n";
+	cout << endl;
 	cout << "    --exclude=####\n";
 	cout << "    Specify a file or directory #### to be excluded from processing.\n";
 	cout << endl;
@@ -2284,16 +3102,50 @@ void ASConsole::processFiles()
 
 	clock_t startTime = clock();     // start time of file formatting
 
+	if (isCacheUsed())
+	{
+		fileCache.setOptionsHash(computeOptionsHash());
+		if (!fileCache.load(cacheFileName))
+			(*errorStream) << "Cannot read cache file " << cacheFileName << endl;
+	}
+
+	// worker consoles for the jobs= option, created when first needed
+	// the formatters must be declared first so they are deleted last
+	vector<unique_ptr<ASFormatter> > workerFormatters;
+	vector<unique_ptr<ASConsole> > workers;
+
 	// loop thru input fileNameVector and process the files
 	for (size_t i = 0; i < fileNameVector.size(); i++)
 	{
 		getFilePaths(fileNameVector[i]);
 
+		if (numJobs > 1 && fileName.size() > 1)
+		{
+			if (workers.empty())
+			{
+				// the ASLocalizer constructor resets the locale
+				string locale = setlocale(LC_ALL, nullptr);
+				for (int j = 0; j < numJobs; j++)
+				{
+					workerFormatters.emplace_back(new ASFormatter);
+					workers.emplace_back(new ASConsole(*workerFormatters.back()));
+					initializeWorker(*workers.back());
+				}
+				setlocale(LC_ALL, locale.c_str());
+			}
+			formatFilesConcurrently(workers);
+			continue;
+		}
+
 		// loop thru fileName vector formatting the files
 		for (size_t j = 0; j < fileName.size(); j++)
 			formatFile(fileName[j]);
 	}
 
+	// a cache that cannot be saved is not an error
+	if (isCacheUsed() && !fileCache.save(cacheFileName))
+		(*errorStream) << "Cannot write cache file " << cacheFileName << endl;
+
 	// files are processed, display stats
 	if (isVerbose)
 		printVerboseStats(startTime);
@@ -2541,7 +3393,7 @@ void ASConsole::processOptions(const vector<string>& argvOptions)
 }
 
 // remove a file and check for an error
-void ASConsole::removeFile(const char* fileName_, const char* errMsg) const
+void ASConsole::removeFile(const char* fileName_, const char* errMsg)
 {
 	if (remove(fileName_) != 0)
 	{
@@ -2550,13 +3402,13 @@ void ASConsole::removeFile(const char* fileName_, const char* errMsg) const
 		if (errno)
 		{
 			perror("errno message");
-			error(errMsg, fileName_);
+			fileError(errMsg, fileName_);
 		}
 	}
 }
 
 // rename a file and check for an error
-void ASConsole::renameFile(const char* oldFileName, const char* newFileName, const char* errMsg) const
+void ASConsole::renameFile(const char* oldFileName, const char* newFileName, const char* errMsg)
 {
 	int result = rename(oldFileName, newFileName);
 	if (result != 0)
@@ -2571,7 +3423,7 @@ void ASConsole::renameFile(const char* oldFileName, const char* newFileName, con
 		if (result != 0)
 		{
 			perror("errno message");
-			error(errMsg, oldFileName);
+			fileError(errMsg, oldFileName);
 		}
 	}
 }
@@ -2724,9 +3576,66 @@ void ASConsole::printVerboseStats(clock_t startTime) const
 
 	string lines = getNumberFormat(linesOut);
 	printf(_("%s lines\n"), lines.c_str());
+	if (isCacheUsed())
+	{
+		string hits = getNumberFormat(cacheHits);
+		string misses = getNumberFormat(cacheMisses);
+		printf(_(" %s cache hits   %s cache misses\n"), hits.c_str(), misses.c_str());
+	}
 	printf("\n");
 }
 
+// display the Formatted or Unchanged message for a file and update the counts
+// a lineNumber from the check option is appended to the file name
+void ASConsole::reportFileResult(const string& fileName_, bool isFormatted, int lineNumber)
+{
+	string displayName = getDisplayName(fileName_);
+
+	if (isFormatted)
+	{
+		if (lineNumber > 0)
+			displayName += ":" + to_string(lineNumber);
+		printMsg(_("Formatted  %s\n"), displayName);
+		filesFormatted++;
+	}
+	else
+	{
+		if (!isFormattedOnly)
+			printMsg(_("Unchanged  %s\n"), displayName);
+		filesUnchanged++;
+	}
+}
+
+// display the verify error for a file that was not written and update the count
+// the error is displayed even with the quiet option
+void ASConsole::reportVerifyFailure(const string& fileName_)
+{
+	(*errorStream) << _("Verify failed, the file was not written") << ' '
+	               << getDisplayName(fileName_) << endl;
+	filesVerifyFailed++;
+}
+
+// get the file name to display
+// remove targetDirectory from filename if required by print
+string ASConsole::getDisplayName(const string& fileName_) const
+{
+	if (hasWildcard)
+		return fileName_.substr(targetDirectory.length() + 1);
+	return fileName_;
+}
+
+// update the cache= entry of a file after it is formatted
+// a file that has not been written by a dry run is not formatted
+void ASConsole::updateFileCache(const string& fileName_, bool isFormatted)
+{
+	if (!isCacheUsed())
+		return;
+	if (isFormatted && isDryRun)
+		fileCache.removeFile(fileName_);
+	else
+		fileCache.updateFile(fileName_);
+}
+
 void ASConsole::sleep(int seconds) const
 {
 	clock_t endwait;
@@ -2836,7 +3745,7 @@ int ASConsole::wildcmp(const char* wild, const char* data) const
 	return !*wild;
 }
 
-void ASConsole::writeFile(const string& fileName_, FileEncoding encoding, ostringstream& out) const
+void ASConsole::writeFile(const string& fileName_, FileEncoding encoding, const string& out)
 {
 	// save date accessed and date modified of original file
 	struct stat stBuf;
@@ -2849,27 +3758,36 @@ void ASConsole::writeFile(const string& fileName_, FileEncoding encoding, ostrin
 	{
 		string origFileName = fileName_ + origSuffix;
 		removeFile(origFileName.c_str(), "Cannot remove pre-existing backup file");
-		renameFile(fileName_.c_str(), origFileName.c_str(), "Cannot create backup file");
+		if (fileErrorMessage.empty())
+			renameFile(fileName_.c_str(), origFileName.c_str(), "Cannot create backup file");
+		// the file is not written without a backup
+		if (!fileErrorMessage.empty())
+			return;
 	}
 
 	// write the output file
 	ofstream fout(fileName_.c_str(), ios::binary | ios::trunc);
 	if (!fout)
-		error("Cannot open output file", fileName_.c_str());
+	{
+		fileError("Cannot open output file", fileName_.c_str());
+		return;
+	}
 	if (encoding == UTF_16LE || encoding == UTF_16BE)
 	{
 		// convert utf-8 to utf-16
+		// a utf-8 byte is converted to at most 2 bytes so the length is not
+		// computed first, this is the exact length for ASCII text
 		bool isBigEndian = (encoding == UTF_16BE);
-		size_t utf16Size = encode.utf16LengthFromUtf8(out.str().c_str(), out.str().length());
+		size_t utf16Size = out.length() * 2;
 		char* utf16Out = new char[utf16Size];
-		size_t utf16Len = encode.utf8ToUtf16(const_cast<char*>(out.str().c_str()),
-		                                     out.str().length(), isBigEndian, utf16Out);
+		size_t utf16Len = encode.utf8ToUtf16(const_cast<char*>(out.c_str()),
+		                                     out.length(), isBigEndian, utf16Out);
 		assert(utf16Len <= utf16Size);
-		fout << string(utf16Out, utf16Len);
+		fout.write(utf16Out, utf16Len);
 		delete[] utf16Out;
 	}
 	else
-		fout << out.str();
+		fout.write(out.c_str(), out.length());
 
 	fout.close();
 
@@ -2895,69 +3813,343 @@ void ASConsole::writeFile(const string& fileName_, FileEncoding encoding, ostrin
 	}
 }
 
-#else	// ASTYLE_LIB
-
 //-----------------------------------------------------------------------------
-// ASLibrary class
-// used by shared object (DLL) calls
+// ASMappedFile class
+// used by the console build to read the input files
 //-----------------------------------------------------------------------------
 
-char16_t* ASLibrary::formatUtf16(const char16_t* pSourceIn,		// the source to be formatted
-                                 const char16_t* pOptions,		// AStyle options
-                                 fpError fpErrorHandler,		// error handler function
-                                 fpAlloc fpMemoryAlloc) const	// memory allocation function)
+ASMappedFile::ASMappedFile()
 {
-	const char* utf8In = convertUtf16ToUtf8(pSourceIn);
-	if (utf8In == nullptr)
-	{
-		fpErrorHandler(121, "Cannot convert input utf-16 to utf-8.");
-		return nullptr;
-	}
-	const char* utf8Options = convertUtf16ToUtf8(pOptions);
-	if (utf8Options == nullptr)
-	{
-		delete[] utf8In;
-		fpErrorHandler(122, "Cannot convert options utf-16 to utf-8.");
-		return nullptr;
-	}
-	// call the Artistic Style formatting function
-	// cannot use the callers memory allocation here
-	char* utf8Out = AStyleMain(utf8In,
-	                           utf8Options,
-	                           fpErrorHandler,
-	                           ASLibrary::tempMemoryAllocation);
-	// finished with these
-	delete[] utf8In;
-	delete[] utf8Options;
-	utf8In = nullptr;
-	utf8Options = nullptr;
-	// AStyle error has already been sent
-	if (utf8Out == nullptr)
-		return nullptr;
-	// convert text to wide char and return it
-	char16_t* utf16Out = convertUtf8ToUtf16(utf8Out, fpMemoryAlloc);
-	delete[] utf8Out;
-	utf8Out = nullptr;
-	if (utf16Out == nullptr)
-	{
-		fpErrorHandler(123, "Cannot convert output utf-8 to utf-16.");
-		return nullptr;
-	}
-	return utf16Out;
+	data = nullptr;
+	dataSize = 0;
+	isMapped = false;
 }
 
-// STATIC method to allocate temporary memory for AStyle formatting.
-// The data will be converted before being returned to the calling program.
-char* STDCALL ASLibrary::tempMemoryAllocation(unsigned long memoryNeeded)
+ASMappedFile::~ASMappedFile()
 {
-	char* buffer = new (nothrow) char[memoryNeeded];
-	return buffer;
+	close();
 }
 
-/**
- * Convert utf-8 strings to utf16 strings.
- * Memory is allocated by the calling program memory allocation function.
- * The calling function must check for errors.
+// release the file data
+// a mapped file must be closed before it is replaced
+void ASMappedFile::close()
+{
+	if (isMapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<char*>(data), dataSize);
+#endif
+	}
+	isMapped = false;
+	data = nullptr;
+	dataSize = 0;
+	string().swap(fileData);
+}
+
+// map the file into memory, or read it if it cannot be mapped
+// return false if the file cannot be opened
+bool ASMappedFile::open(const string& fileName_)
+{
+	close();
+	if (mapFile(fileName_))
+		return true;
+	// empty files, pipes, devices, and changing files are read instead
+	ifstream fin(fileName_.c_str(), ios::binary);
+	if (!fin)
+		return false;
+	fileData.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+	if (fin.bad())
+		return false;
+	data = fileData.data();
+	dataSize = fileData.size();
+	return true;
+}
+
+// map a regular file into memory
+// return false if the file cannot be mapped, or if it changed while it was mapped
+bool ASMappedFile::mapFile(const string& fileName_)
+{
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFile(fileName_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize)
+	        || fileSize.QuadPart == 0
+	        || static_cast<unsigned long long>(fileSize.QuadPart) > static_cast<size_t>(-1))
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+	// the view remains valid after the handles are closed
+	HANDLE mapHandle = CreateFileMapping(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapHandle == nullptr)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+	void* view = MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapHandle);
+	// a file that changed size before it was mapped is read instead
+	LARGE_INTEGER mappedSize;
+	bool isChanged = (!GetFileSizeEx(fileHandle, &mappedSize)
+	                  || mappedSize.QuadPart != fileSize.QuadPart);
+	CloseHandle(fileHandle);
+	if (view == nullptr)
+		return false;
+	if (isChanged)
+	{
+		UnmapViewOfFile(view);
+		return false;
+	}
+	dataSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fileDescriptor = ::open(fileName_.c_str(), O_RDONLY);
+	if (fileDescriptor == -1)
+		return false;
+	struct stat stBuf;
+	if (fstat(fileDescriptor, &stBuf) == -1
+	        || !S_ISREG(stBuf.st_mode)
+	        || stBuf.st_size == 0
+	        || static_cast<unsigned long long>(stBuf.st_size) > static_cast<size_t>(-1))
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+	// the mapping remains valid after the file is closed
+	void* view = mmap(nullptr, static_cast<size_t>(stBuf.st_size), PROT_READ, MAP_PRIVATE,
+	                  fileDescriptor, 0);
+	// a file that changed before it was mapped is read instead
+	// a truncation after this check raises SIGBUS, see the class comment
+	struct stat mappedBuf;
+	bool isChanged = (fstat(fileDescriptor, &mappedBuf) == -1
+	                  || mappedBuf.st_size != stBuf.st_size
+	                  || mappedBuf.st_mtime != stBuf.st_mtime);
+	::close(fileDescriptor);
+	if (view == MAP_FAILED)
+		return false;
+	if (isChanged)
+	{
+		munmap(view, static_cast<size_t>(stBuf.st_size));
+		return false;
+	}
+	dataSize = static_cast<size_t>(stBuf.st_size);
+#endif
+	data = static_cast<const char*>(view);
+	isMapped = true;
+	return true;
+}
+
+// replace the file data, used for a converted file
+// the contents of newData are moved, newData is emptied
+void ASMappedFile::replaceData(string& newData)
+{
+	close();
+	fileData.swap(newData);
+	data = fileData.data();
+	dataSize = fileData.size();
+}
+
+//-----------------------------------------------------------------------------
+// ASFileCache class
+// used by the console build for the cache= option
+//-----------------------------------------------------------------------------
+
+// the first line of a cache file
+// the cache is rebuilt if the format is changed
+static const char* const CACHE_HEADER = "# astyle cache 1";
+
+ASFileCache::ASFileCache()
+{
+	optionsHash = 0;
+	isModified = false;
+}
+
+// compute a 64 bit FNV-1a hash
+uint64_t ASFileCache::computeHash(const char* data, size_t dataSize)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < dataSize; i++)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+// get the size and date modified of a file
+// a file modified in the last two seconds gets a modified date of zero, it may
+// be changed again in the same second, and must have its contents checked
+bool ASFileCache::getFileState(const string& fileName_, CacheEntry& entry) const
+{
+	struct stat stBuf;
+	if (stat(fileName_.c_str(), &stBuf) == -1)
+		return false;
+	entry.fileSize = stBuf.st_size;
+	entry.modified = stBuf.st_mtime;
+	if (entry.modified >= time(nullptr) - 1)
+		entry.modified = 0;
+	return true;
+}
+
+// return true if the file has not changed since it was formatted
+// with the current options
+bool ASFileCache::isFileCached(const string& fileName_)
+{
+	auto entryIter = entries.find(fileName_);
+	if (entryIter == entries.end())
+		return false;
+	CacheEntry& entry = entryIter->second;
+	CacheEntry current;
+	if (entry.optionsHash != optionsHash
+	        || !getFileState(fileName_, current)
+	        || entry.fileSize != current.fileSize)
+		return false;
+	if (entry.modified != 0 && entry.modified == current.modified)
+		return true;
+	// the date has changed, check the contents
+	ASMappedFile in;
+	if (!in.open(fileName_)
+	        || computeHash(in.getData(), in.getSize()) != entry.contentHash)
+		return false;
+	if (entry.modified != current.modified)
+	{
+		entry.modified = current.modified;
+		isModified = true;
+	}
+	return true;
+}
+
+// load the entries from a cache file
+// a missing file is an empty cache, an unrecognized file is ignored
+bool ASFileCache::load(const string& cacheFileName)
+{
+	entries.clear();
+	isModified = false;
+	ifstream fin(cacheFileName.c_str());
+	if (!fin)
+		return true;
+	string line;
+	if (!getline(fin, line) || line != CACHE_HEADER)
+		return true;
+	// each line is: options-hash content-hash size modified path
+	while (getline(fin, line))
+	{
+		istringstream lineStream(line);
+		CacheEntry entry;
+		string path;
+		lineStream >> hex >> entry.optionsHash >> entry.contentHash
+		           >> dec >> entry.fileSize >> entry.modified;
+		if (!lineStream || lineStream.get() != ' ' || !getline(lineStream, path) || path.empty())
+			continue;
+		entries[path] = entry;
+	}
+	return !fin.bad();
+}
+
+void ASFileCache::removeFile(const string& fileName_)
+{
+	if (entries.erase(fileName_) > 0)
+		isModified = true;
+}
+
+// save the entries to a cache file if they have changed
+bool ASFileCache::save(const string& cacheFileName) const
+{
+	if (!isModified)
+		return true;
+	ofstream fout(cacheFileName.c_str(), ios::trunc);
+	if (!fout)
+		return false;
+	fout << CACHE_HEADER << '\n';
+	for (const auto& entryPair : entries)
+	{
+		const CacheEntry& entry = entryPair.second;
+		fout << hex << entry.optionsHash << ' ' << entry.contentHash << ' '
+		     << dec << entry.fileSize << ' ' << entry.modified << ' '
+		     << entryPair.first << '\n';
+	}
+	fout.close();
+	return !fout.fail();
+}
+
+void ASFileCache::setOptionsHash(uint64_t hash)
+{ optionsHash = hash; }
+
+// add or replace the entry for a formatted file
+// the contents are read from the file as it was written
+void ASFileCache::updateFile(const string& fileName_)
+{
+	CacheEntry entry;
+	ASMappedFile in;
+	if (!getFileState(fileName_, entry) || !in.open(fileName_))
+	{
+		removeFile(fileName_);
+		return;
+	}
+	entry.optionsHash = optionsHash;
+	entry.contentHash = computeHash(in.getData(), in.getSize());
+	entry.fileSize = static_cast<long long>(in.getSize());
+	entries[fileName_] = entry;
+	isModified = true;
+}
+
+#else	// ASTYLE_LIB
+
+//-----------------------------------------------------------------------------
+// ASLibrary class
+// used by shared object (DLL) calls
+//-----------------------------------------------------------------------------
+
+char16_t* ASLibrary::formatUtf16(const char16_t* pSourceIn,		// the source to be formatted
+                                 const char16_t* pOptions,		// AStyle options
+                                 fpError fpErrorHandler,		// error handler function
+                                 fpAlloc fpMemoryAlloc) const	// memory allocation function)
+{
+	const char* utf8In = convertUtf16ToUtf8(pSourceIn);
+	if (utf8In == nullptr)
+	{
+		fpErrorHandler(121, "Cannot convert input utf-16 to utf-8.");
+		return nullptr;
+	}
+	const char* utf8Options = convertUtf16ToUtf8(pOptions);
+	if (utf8Options == nullptr)
+	{
+		delete[] utf8In;
+		fpErrorHandler(122, "Cannot convert options utf-16 to utf-8.");
+		return nullptr;
+	}
+	// format the utf-8 text with a handle, the same as AStyleMain
+	// the output is converted from the handle's buffer to the caller's memory,
+	// so it is not copied to a temporary allocation first
+	ASFormatterHandle handle(fpErrorHandler, fpMemoryAlloc);
+	handle.setOptions(utf8Options);
+	const string* utf8Out = handle.format(utf8In, strlen(utf8In));
+	// finished with these
+	delete[] utf8In;
+	delete[] utf8Options;
+	utf8In = nullptr;
+	utf8Options = nullptr;
+	// AStyle error has already been sent
+	if (utf8Out == nullptr)
+		return nullptr;
+	// convert text to wide char and return it
+	char16_t* utf16Out = convertUtf8ToUtf16(utf8Out->c_str(), fpMemoryAlloc);
+	if (utf16Out == nullptr)
+	{
+		fpErrorHandler(123, "Cannot convert output utf-8 to utf-16.");
+		return nullptr;
+	}
+	return utf16Out;
+}
+
+/**
+ * Convert utf-8 strings to utf16 strings.
+ * Memory is allocated by the calling program memory allocation function.
+ * The calling function must check for errors.
  */
 char16_t* ASLibrary::convertUtf8ToUtf16(const char* utf8In, fpAlloc fpMemoryAlloc) const
 {
@@ -2988,24 +4180,568 @@ char16_t* ASLibrary::convertUtf8ToUtf16(const char* utf8In, fpAlloc fpMemoryAllo
  */
 char* ASLibrary::convertUtf16ToUtf8(const char16_t* utf16In) const
 {
-	if (utf16In == nullptr)
+	if (utf16In == nullptr)
+		return nullptr;
+	char* data = reinterpret_cast<char*>(const_cast<char16_t*>(utf16In));
+	// size must be in chars
+	size_t dataSize = encode.utf16len(utf16In) * sizeof(char16_t);
+	bool isBigEndian = encode.getBigEndian();
+	size_t utf8Size = encode.utf8LengthFromUtf16(data, dataSize, isBigEndian) + 1;
+	char* utf8Out = new (nothrow) char[utf8Size];
+	if (utf8Out == nullptr)
+		return nullptr;
+#ifdef NDEBUG
+	encode.utf16ToUtf8(data, dataSize + 1, isBigEndian, true, utf8Out);
+#else
+	size_t utf8Len = encode.utf16ToUtf8(data, dataSize + 1, isBigEndian, true, utf8Out);
+	assert(utf8Len == utf8Size);
+#endif
+	assert(utf8Size == strlen(utf8Out) + 1);
+	return utf8Out;
+}
+
+//-----------------------------------------------------------------------------
+// ASFormatterHandle class
+// used by the AStyleCreate, AStyleFormat, and AStyleMain library calls
+//-----------------------------------------------------------------------------
+
+ASFormatterHandle::ASFormatterHandle(fpError fpErrorHandlerArg, fpAlloc fpMemoryAllocArg)
+	: fpErrorHandler(fpErrorHandlerArg), fpMemoryAlloc(fpMemoryAllocArg)
+{
+	// each checkpoint is a copy of the formatter, taken at least 500 input lines apart
+	checkpointInterval = 500;
+}
+
+/**
+ * Parse the options for the formatter.
+ * Errors are sent to the error handler. The valid options are still used.
+ *
+ * @return              true if all of the options are valid.
+ */
+bool ASFormatterHandle::setOptions(const char* pOptions)
+{
+	ASOptions options(formatter);
+
+	vector<string> optionsVector;
+	stringstream opt(pOptions);
+
+	options.importOptions(opt, optionsVector);
+
+	bool ok = options.parseOptions(optionsVector, "Invalid Artistic Style options:");
+	if (!ok)
+		fpErrorHandler(130, options.getOptionErrors().c_str());
+	return ok;
+}
+
+/**
+ * Format a source with the options that have been set.
+ * The formatter and the output buffer are reused by the following calls,
+ * the returned text is valid until the next call.
+ *
+ * @return              The formatted text, or nullptr if an error occurred.
+ */
+const string* ASFormatterHandle::format(const char* pSourceIn, size_t sourceLength)
+{
+	out.clear();
+	// allow for added indentation and line ends
+	out.reserve(sourceLength + sourceLength / 16);
+	bool ok = formatLines(pSourceIn, sourceLength,
+	                      [this](const string& text) { out.append(text); });
+	if (!ok)
+		return nullptr;
+	return &out;
+}
+
+/**
+ * Format a source and send the output to the caller's output function,
+ * one line and one end of line at a time. The output is not copied before
+ * it is sent, and the source may contain NUL characters.
+ * If the verify option fails the output has already been sent,
+ * and must be discarded by the caller.
+ *
+ * @return              true if the source was formatted without errors.
+ */
+bool ASFormatterHandle::formatToWrite(const char* pSourceIn, size_t sourceLength,
+                                      fpWrite fpWriteOutput, void* pWriteData)
+{
+	if (fpWriteOutput == nullptr)
+	{
+		fpErrorHandler(106, "No pointer to output function.");
+		return false;
+	}
+	return formatLines(pSourceIn, sourceLength,
+	                   [fpWriteOutput, pWriteData](const string& text)
+	{
+		if (!text.empty())
+			fpWriteOutput(text.data(), text.length(), pWriteData);
+	});
+}
+
+/**
+ * Format the lines of a source and send the formatted lines and line ends
+ * to the write function.
+ *
+ * @return              true if the source was formatted without errors.
+ */
+template<typename Write>
+bool ASFormatterHandle::formatLines(const char* pSourceIn, size_t sourceLength, Write write)
+{
+	if (pSourceIn == nullptr)
+	{
+		fpErrorHandler(101, "No pointer to source input.");
+		return false;
+	}
+
+	ASBufferIterator streamIterator(pSourceIn, sourceLength);
+	formatter.init(&streamIterator);
+
+	while (formatter.hasMoreLines())
+	{
+		write(formatter.nextLine());
+		if (formatter.hasMoreLines())
+			write(streamIterator.getOutputEOL());
+		else
+		{
+			// this can happen if the file if missing a closing brace and break-blocks is requested
+			if (formatter.getIsLineReady())
+			{
+				write(streamIterator.getOutputEOL());
+				write(formatter.nextLine());
+			}
+		}
+	}
+
+	// the verify option does not return a file with changed text
+	if (formatter.getVerifyFailed())
+	{
+		fpErrorHandler(221,
+		               "Verify failed.\n"
+		               "The formatted text does not have the same characters as the source.");
+		return false;
+	}
+#ifndef NDEBUG
+	// The checksum is an assert in the console build and ASFormatter.
+	// This error returns the incorrectly formatted file to the editor.
+	// This is done to allow the file to be saved for debugging purposes.
+	if (formatter.getChecksumDiff() != 0)
+		fpErrorHandler(220,
+		               "Checksum error.\n"
+		               "The incorrectly formatted file will be returned for debugging.");
+#endif
+	return true;
+}
+
+/**
+ * Format a source and return it in memory from the memory allocation function.
+ *
+ * @return              The formatted text, or nullptr if an error occurred.
+ */
+char* ASFormatterHandle::formatToAlloc(const char* pSourceIn, size_t sourceLength)
+{
+	const string* formatted = format(pSourceIn, sourceLength);
+	if (formatted == nullptr)
+		return nullptr;
+
+	size_t textSizeOut = formatted->length();
+	char* pTextOut = fpMemoryAlloc((long) textSizeOut + 1);     // call memory allocation function
+	if (pTextOut == nullptr)
+	{
+		fpErrorHandler(120, "Allocation failure on output.");
+		return nullptr;
+	}
+
+	memcpy(pTextOut, formatted->c_str(), textSizeOut + 1);
+	return pTextOut;
+}
+
+/**
+ * Check if a quote is a C++14 digit separator (1'000).
+ * The number containing it must start with a digit, the same as ASVerifyHash.
+ */
+static bool isSourceDigitSeparator(const char* source, size_t sourceLength, size_t i)
+{
+	auto isNameChar = [](char ch)
+	{ return isalnum((unsigned char) ch) || ch == '_' || (unsigned char) ch >= 128; };
+	if (i == 0 || i + 1 >= sourceLength || !isNameChar(source[i + 1]))
+		return false;
+	size_t numberStart = i;
+	while (numberStart > 0
+	        && (isNameChar(source[numberStart - 1]) || source[numberStart - 1] == '\''))
+		numberStart--;
+	return numberStart < i && isdigit((unsigned char) source[numberStart]);
+}
+
+/**
+ * Check if a quote starts a C++11 raw string.
+ * The prefix may be R, LR, uR, UR, or u8R, the same as ASVerifyHash.
+ */
+static bool isSourceRawStringStart(const char* source, size_t i)
+{
+	if (i == 0 || source[i - 1] != 'R')
+		return false;
+	size_t prefixStart = i - 1;
+	if (prefixStart >= 2 && source[prefixStart - 2] == 'u' && source[prefixStart - 1] == '8')
+		prefixStart -= 2;
+	else if (prefixStart >= 1
+	         && (source[prefixStart - 1] == 'L' || source[prefixStart - 1] == 'u' || source[prefixStart - 1] == 'U'))
+		prefixStart--;
+	if (prefixStart == 0)
+		return true;
+	char prevCh = source[prefixStart - 1];
+	return !(isalnum((unsigned char) prevCh) || prevCh == '_' || (unsigned char) prevCh >= 128);
+}
+
+/**
+ * Check that the braces and parens in the source are balanced, ignoring the
+ * ones in comments, quotes, and preprocessor statements. This is much faster
+ * than formatting, and finds the sources where the formatting state at a
+ * closing brace in the first column cannot be known without formatting from
+ * the start.
+ * The same scan saves the positions of the closing braces in the first column
+ * that close the last open brace. A line beginning with a brace in a comment
+ * or a raw string is not saved.
+ * A source with *INDENT-OFF* is not balanced, a brace may be in a block
+ * that is not formatted. Neither is a raw string with an invalid delimiter.
+ * The source is then formatted from the start.
+ *
+ * @param braceStarts   the top level closing braces in the first column.
+ * @return              true if every opening brace and paren is closed.
+ */
+static bool isSourceBraceBalanced(const char* source, size_t sourceLength, vector<size_t>& braceStarts)
+{
+	braceStarts.clear();
+	if (strstr(source, "*INDENT-OFF*") != nullptr)
+		return false;
+	int braceDepth = 0;
+	int parenDepth = 0;
+	bool isLineStart = true;        // only whitespace since the last line end
+	for (size_t i = 0; i < sourceLength; i++)
+	{
+		char ch = source[i];
+		if (ch == '\n' || ch == '\r')
+		{
+			isLineStart = true;
+			continue;
+		}
+		if (ch == ' ' || ch == '\t')
+			continue;
+		if (isLineStart && ch == '#')
+		{
+			// skip the preprocessor statement and its continuation lines
+			for (; i < sourceLength && source[i] != '\n' && source[i] != '\r'; i++)
+			{
+				if (source[i] == '\\' && i + 1 < sourceLength)
+				{
+					i++;
+					if (source[i] == '\r' && i + 1 < sourceLength && source[i + 1] == '\n')
+						i++;
+				}
+			}
+			i--;
+			continue;
+		}
+		isLineStart = false;
+		if (ch == '/' && i + 1 < sourceLength && source[i + 1] == '/')
+		{
+			while (i + 1 < sourceLength && source[i + 1] != '\n' && source[i + 1] != '\r')
+				i++;
+		}
+		else if (ch == '/' && i + 1 < sourceLength && source[i + 1] == '*')
+		{
+			const char* commentEnd = strstr(source + i + 2, "*/");
+			if (commentEnd == nullptr)
+				return false;
+			i = static_cast<size_t>(commentEnd - source) + 1;
+		}
+		else if (ch == '"' && isSourceRawStringStart(source, i))
+		{
+			// C++ raw string, R"delimiter(...)delimiter"
+			// the delimiter is at most 16 characters
+			const char* parenStart = source + i + 1;
+			while (*parenStart != '(')
+			{
+				if (parenStart - source > static_cast<ptrdiff_t>(i) + 16
+				        || *parenStart == '\0' || strchr(" )\\\t\r\n\"", *parenStart) != nullptr)
+					return false;
+				parenStart++;
+			}
+			string rawEnd = ")" + string(source + i + 1, parenStart) + "\"";
+			const char* stringEnd = strstr(parenStart, rawEnd.c_str());
+			if (stringEnd == nullptr)
+				return false;
+			i = static_cast<size_t>(stringEnd - source) + rawEnd.length() - 1;
+		}
+		else if (ch == '"' && i > 0 && source[i - 1] == '@')
+		{
+			// C# verbatim string, a quote is escaped by another quote
+			for (i++; i < sourceLength; i++)
+			{
+				if (source[i] == '"')
+				{
+					if (i + 1 < sourceLength && source[i + 1] == '"')
+						i++;
+					else
+						break;
+				}
+			}
+		}
+		else if (ch == '\'' && isSourceDigitSeparator(source, sourceLength, i))
+			continue;
+		else if (ch == '"' || ch == '\'')
+		{
+			// an unterminated quote ends at the line end
+			for (i++; i < sourceLength && source[i] != ch; i++)
+			{
+				if (source[i] == '\n' || source[i] == '\r')
+				{
+					isLineStart = true;
+					break;
+				}
+				if (source[i] == '\\')
+					i++;
+			}
+		}
+		else if (ch == '{')
+			braceDepth++;
+		else if (ch == '}')
+		{
+			if (--braceDepth < 0)
+				return false;
+			bool isFirstColumn = (i == 0 || source[i - 1] == '\n' || source[i - 1] == '\r');
+			if (braceDepth == 0 && parenDepth == 0 && isFirstColumn)
+				braceStarts.emplace_back(i);
+		}
+		else if (ch == '(')
+			parenDepth++;
+		else if (ch == ')' && --parenDepth < 0)
+			return false;
+	}
+	return braceDepth == 0 && parenDepth == 0;
+}
+
+/**
+ * Format a range of lines in the source.
+ * Formatting starts at the later of a checkpoint and a top level closing
+ * brace in the first column before the range. A checkpoint is used only if
+ * the source it has read is the same as the source of the previous call.
+ * The formatter state does not depend on the previous lines at either one.
+ * It ends after the range at the first unchanged line following an unchanged
+ * closing brace that closes the last open brace, where the remaining lines
+ * will not be changed. The line numbers are zero based.
+ * A checkpoint is taken every checkpointInterval input lines, at an unchanged
+ * line following an unchanged line, and is kept for the following calls.
+ * Only the lines that replace the expanded range are returned, so the time
+ * used depends on the size of the range instead of the size of the source.
+ *
+ * @param firstLine     The first line of the range. It is changed to the first
+ *                      line replaced by the returned text.
+ * @param lastLine      The last line of the range. It is changed to the last
+ *                      line replaced by the returned text, including the end
+ *                      of line if it is not the end of the source.
+ * @return              The formatted lines.
+ */
+const string* ASFormatterHandle::formatRange(const char* pSourceIn, int& firstLine, int& lastLine)
+{
+	// get the start of each line using the same line ends as the formatter
+	size_t textSizeIn = strlen(pSourceIn);
+	vector<size_t> lineStart;
+	ASBufferIterator lineIterator(pSourceIn, textSizeIn);
+	while (lineIterator.hasMoreLines())
+	{
+		lineStart.emplace_back(static_cast<size_t>(lineIterator.tellg()));
+		lineIterator.nextLine(false);
+	}
+	int numLines = static_cast<int>(lineStart.size());
+	firstLine = min(firstLine, numLines - 1);
+	lastLine = min(lastLine, numLines - 1);
+
+	// compare a formatted line to an input line
+	auto isLineUnchanged = [&](const string& formattedLine, int inputLine) -> bool
+	{
+		size_t start = lineStart[inputLine];
+		size_t end = (inputLine + 1 < numLines) ? lineStart[inputLine + 1] : textSizeIn;
+		while (end > start && (pSourceIn[end - 1] == '\n' || pSourceIn[end - 1] == '\r'))
+			end--;
+		return formattedLine.compare(0, string::npos, pSourceIn + start, end - start) == 0;
+	};
+
+	// start after a top level closing brace in the first column
+	// if the source is not balanced the state at the brace is not known,
+	// and the edit may have changed the state of all of the following lines
+	int startLine = firstLine;
+	vector<size_t> braceStarts;
+	bool isBalanced = isSourceBraceBalanced(pSourceIn, textSizeIn, braceStarts);
+	if (!isBalanced)
+		startLine = 0;
+	while (startLine > 0
+	        && !binary_search(braceStarts.begin(), braceStarts.end(), lineStart[startLine - 1]))
+		startLine--;
+
+	// remove the checkpoints that have read a changed part of the source
+	// the end of the source is counted as one more character
+	size_t checkpointLength = checkpointSource.length();
+	const char* compareEnd = pSourceIn + min(checkpointLength, textSizeIn);
+	size_t sameLength = static_cast<size_t>(mismatch(pSourceIn, compareEnd, checkpointSource.begin()).first
+	                                        - pSourceIn);
+	if (sameLength == checkpointLength && sameLength == textSizeIn)
+		sameLength++;
+	checkpoints.erase(remove_if(checkpoints.begin(), checkpoints.end(),
+	                            [sameLength](const RangeCheckpoint& checkpoint)
+	{ return checkpoint.sourceRead > sameLength; }),
+	checkpoints.end());
+	checkpointSource.assign(pSourceIn, textSizeIn);
+
+	// resume from the last checkpoint before the range, if it is after the brace
+	const RangeCheckpoint* resumeCheckpoint = nullptr;
+	for (const RangeCheckpoint& checkpoint : checkpoints)
+	{
+		if (checkpoint.inputLine > startLine && checkpoint.inputLine <= firstLine)
+			resumeCheckpoint = &checkpoint;
+	}
+
+	// a closing brace without an opening brace means the start line was not
+	// at the top level, the source is then formatted from the first line
+	int endLine = numLines - 1;     // last input line replaced
+	vector<RangeCheckpoint> newCheckpoints;
+	bool isRestartNeeded = true;
+	while (isRestartNeeded)
+	{
+		isRestartNeeded = false;
+		out.clear();
+		newCheckpoints.clear();
+		endLine = numLines - 1;
+		size_t basePos;             // source position of the iterator start
+		unique_ptr<ASFormatter> resumedFormatter;
+		ASFormatter* activeFormatter = &formatter;
+		if (resumeCheckpoint != nullptr)
+			basePos = resumeCheckpoint->basePos;
+		else
+			basePos = lineStart[startLine];
+		ASBufferIterator streamIterator(pSourceIn + basePos, textSizeIn - basePos);
+		if (resumeCheckpoint != nullptr)
+		{
+			startLine = resumeCheckpoint->inputLine;
+			streamIterator.seekg(resumeCheckpoint->checkpoint->getStreamPosition());
+			resumedFormatter.reset(resumeCheckpoint->checkpoint->resumeFormatter(&streamIterator));
+			activeFormatter = resumedFormatter.get();
+		}
+		else
+			formatter.init(&streamIterator);
+		// the state at a checkpoint or the first line is known, it is not a restart
+		bool isStateKnown = (resumeCheckpoint != nullptr || startLine == 0);
+
+		int braceLine = -1;             // last unchanged top level closing brace
+		int unchangedLine = -1;         // last unchanged input line
+		int checkpointLine = startLine; // input line of the last checkpoint
+		int linesOut = 0;
+		while (activeFormatter->hasMoreLines())
+		{
+			string nextLine = activeFormatter->nextLine();
+			linesOut++;
+			if (!isStateKnown && activeFormatter->getFoundUnmatchedBrace())
+			{
+				startLine = 0;
+				isRestartNeeded = true;
+				break;
+			}
+			out.append(nextLine);
+			// the formatter has read the line after the formatted line
+			streamoff nextPos = streamIterator.tellg();
+			if (nextPos != -1)
+			{
+				size_t readPos = basePos + static_cast<size_t>(nextPos);
+				int inputLine = static_cast<int>(lower_bound(lineStart.begin(), lineStart.end(), readPos)
+				                                 - lineStart.begin()) - 2;
+				if (inputLine >= startLine && isLineUnchanged(nextLine, inputLine))
+				{
+					if (isBalanced && braceLine == inputLine - 1 && inputLine > lastLine)
+					{
+						endLine = inputLine;
+						out.append(streamIterator.getOutputEOL());
+						break;
+					}
+					if (!nextLine.empty() && nextLine[0] == '}' && activeFormatter->getBracesAreBalanced())
+						braceLine = inputLine;
+					// the output is aligned with the input after two unchanged lines
+					if (unchangedLine == inputLine - 1
+					        && inputLine + 1 - checkpointLine >= checkpointInterval)
+					{
+						RangeCheckpoint checkpoint;
+						checkpoint.checkpoint.reset(new ASCheckpoint(*activeFormatter, linesOut));
+						checkpoint.basePos = basePos;
+						checkpoint.sourceRead = basePos + streamIterator.getReadEnd();
+						checkpoint.inputLine = inputLine + 1;
+						newCheckpoints.emplace_back(move(checkpoint));
+						checkpointLine = inputLine + 1;
+					}
+					unchangedLine = inputLine;
+				}
+			}
+			if (activeFormatter->hasMoreLines())
+				out.append(streamIterator.getOutputEOL());
+			else
+			{
+				// this can happen if the file if missing a closing brace and break-blocks is requested
+				if (activeFormatter->getIsLineReady())
+				{
+					out.append(streamIterator.getOutputEOL());
+					out.append(activeFormatter->nextLine());
+				}
+			}
+		}
+	}
+
+	// keep the checkpoints before and after the formatted lines
+	checkpoints.erase(remove_if(checkpoints.begin(), checkpoints.end(),
+	                            [startLine, endLine](const RangeCheckpoint& checkpoint)
+	{ return checkpoint.inputLine >= startLine && checkpoint.inputLine <= endLine; }),
+	checkpoints.end());
+	for (RangeCheckpoint& checkpoint : newCheckpoints)
+		checkpoints.emplace_back(move(checkpoint));
+	sort(checkpoints.begin(), checkpoints.end(),
+	     [](const RangeCheckpoint& a, const RangeCheckpoint& b) { return a.inputLine < b.inputLine; });
+
+	firstLine = startLine;
+	lastLine = endLine;
+	return &out;
+}
+
+/**
+ * Format a range of lines in the source and return it in memory from the
+ * memory allocation function.
+ *
+ * @return              The formatted lines, or nullptr if an error occurred.
+ */
+char* ASFormatterHandle::formatRangeToAlloc(const char* pSourceIn, int* pFirstLine, int* pLastLine)
+{
+	if (pSourceIn == nullptr)
+	{
+		fpErrorHandler(101, "No pointer to source input.");
 		return nullptr;
-	char* data = reinterpret_cast<char*>(const_cast<char16_t*>(utf16In));
-	// size must be in chars
-	size_t dataSize = encode.utf16len(utf16In) * sizeof(char16_t);
-	bool isBigEndian = encode.getBigEndian();
-	size_t utf8Size = encode.utf8LengthFromUtf16(data, dataSize, isBigEndian) + 1;
-	char* utf8Out = new (nothrow) char[utf8Size];
-	if (utf8Out == nullptr)
+	}
+	if (pFirstLine == nullptr || pLastLine == nullptr
+	        || *pFirstLine < 0 || *pLastLine < *pFirstLine)
+	{
+		fpErrorHandler(104, "Invalid line range.");
 		return nullptr;
-#ifdef NDEBUG
-	encode.utf16ToUtf8(data, dataSize + 1, isBigEndian, true, utf8Out);
-#else
-	size_t utf8Len = encode.utf16ToUtf8(data, dataSize + 1, isBigEndian, true, utf8Out);
-	assert(utf8Len == utf8Size);
-#endif
-	assert(utf8Size == strlen(utf8Out) + 1);
-	return utf8Out;
+	}
+
+	int firstLine = *pFirstLine;
+	int lastLine = *pLastLine;
+	const string* formatted = formatRange(pSourceIn, firstLine, lastLine);
+
+	size_t textSizeOut = formatted->length();
+	char* pTextOut = fpMemoryAlloc((long) textSizeOut + 1);     // call memory allocation function
+	if (pTextOut == nullptr)
+	{
+		fpErrorHandler(120, "Allocation failure on output.");
+		return nullptr;
+	}
+
+	memcpy(pTextOut, formatted->c_str(), textSizeOut + 1);
+	*pFirstLine = firstLine;
+	*pLastLine = lastLine;
+	return pTextOut;
 }
 
 #endif	// ASTYLE_LIB
@@ -3036,41 +4772,14 @@ ASOptions::ASOptions(ASFormatter& formatterArg, ASConsole& consoleArg)
 bool ASOptions::parseOptions(vector<string>& optionsVector, const string& errorInfo)
 {
 	vector<string>::iterator option;
-	string arg, subArg;
 	optionErrors.clear();
 
+	vector<string> subArgs;
 	for (option = optionsVector.begin(); option != optionsVector.end(); ++option)
 	{
-		arg = *option;
-
-		if (arg.compare(0, 2, "--") == 0)
-			parseOption(arg.substr(2), errorInfo);
-		else if (arg[0] == '-')
-		{
-			size_t i;
-
-			for (i = 1; i < arg.length(); ++i)
-			{
-				if (i > 1
-				        && isalpha((unsigned char) arg[i])
-				        && arg[i - 1] != 'x')
-				{
-					// parse the previous option in subArg
-					parseOption(subArg, errorInfo);
-					subArg = "";
-				}
-				// append the current option to subArg
-				subArg.append(1, arg[i]);
-			}
-			// parse the last option
+		splitOption(*option, subArgs);
+		for (const string& subArg : subArgs)
 			parseOption(subArg, errorInfo);
-			subArg = "";
-		}
-		else
-		{
-			parseOption(arg, errorInfo);
-			subArg = "";
-		}
 	}
 	if (optionErrors.str().length() > 0)
 		return false;
@@ -3567,6 +5276,11 @@ void ASOptions::parseOption(const string& arg, const string& errorInfo)
 	{
 		formatter.setObjCColonPaddingMode(COLON_PAD_BEFORE);
 	}
+	// verify option
+	else if (isOption(arg, "verify"))
+	{
+		formatter.setVerifyMode(true);
+	}
 	// NOTE: depreciated options - remove when appropriate
 	// depreciated options ////////////////////////////////////////////////////////////////////////
 	else if (isOption(arg, "indent-preprocessor"))		// depreciated release 2.04
@@ -3640,6 +5354,35 @@ void ASOptions::parseOption(const string& arg, const string& errorInfo)
 	{
 		console.setIsDryRun(true);
 	}
+	else if (isOption(arg, "check"))
+	{
+		// a check is a dry run that stops at the first change
+		console.setIsCheck(true);
+		console.setIsDryRun(true);
+	}
+	else if (isParamOption(arg, "jobs="))
+	{
+		// the parameter must be one to three digits, 0 is all cores
+		int jobs = -1;
+		string jobsParam = getParam(arg, "jobs=");
+		if (jobsParam.length() > 0 && jobsParam.length() <= 3
+		        && jobsParam.find_first_not_of("0123456789") == string::npos)
+			jobs = atoi(jobsParam.c_str());
+		if (jobs < 0 || jobs > 256)
+			isOptionError(arg, errorInfo);
+		else if (jobs == 0)
+			console.setNumJobs(max(1, static_cast<int>(thread::hardware_concurrency())));
+		else
+			console.setNumJobs(jobs);
+	}
+	else if (isParamOption(arg, "cache="))
+	{
+		string cacheParam = getParam(arg, "cache=");
+		if (cacheParam.empty())
+			isOptionError(arg, errorInfo);
+		else
+			console.setCacheFileName(cacheParam);
+	}
 	else if (isOption(arg, "Z", "preserve-date"))
 	{
 		console.setPreserveDate(true);
@@ -3749,6 +5492,77 @@ void ASOptions::importOptions(stringstream& in, vector<string>& optionsVector)
 	}
 }
 
+/**
+ * split an option into the options it contains without the leading dashes.
+ * a short option may contain several options, such as "-A1vQ".
+ */
+void ASOptions::splitOption(const string& arg, vector<string>& subArgs) const
+{
+	subArgs.clear();
+	if (arg.compare(0, 2, "--") == 0)
+		subArgs.emplace_back(arg.substr(2));
+	else if (arg[0] == '-')
+	{
+		string subArg;
+		for (size_t i = 1; i < arg.length(); ++i)
+		{
+			if (i > 1
+			        && isalpha((unsigned char) arg[i])
+			        && arg[i - 1] != 'x')
+			{
+				// save the previous option in subArg
+				subArgs.emplace_back(subArg);
+				subArg = "";
+			}
+			// append the current option to subArg
+			subArg.append(1, arg[i]);
+		}
+		// save the last option
+		subArgs.emplace_back(subArg);
+	}
+	else
+		subArgs.emplace_back(arg);
+}
+
+#ifndef ASTYLE_LIB
+/**
+ * get the options that affect the formatted text, one per line.
+ * the console options for reporting and file selection are omitted,
+ *     so changing them does not invalidate the file cache.
+ */
+string ASOptions::getFormattingOptions(const vector<string>& optionsVector)
+{
+	string options;
+	vector<string> subArgs;
+	for (const string& option : optionsVector)
+	{
+		splitOption(option, subArgs);
+		for (const string& subArg : subArgs)
+		{
+			if (isOption(subArg, "n", "suffix=none")
+			        || isParamOption(subArg, "suffix=")
+			        || isParamOption(subArg, "exclude=")
+			        || isOption(subArg, "r", "R")
+			        || isOption(subArg, "recursive")
+			        || isOption(subArg, "dry-run")
+			        || isOption(subArg, "check")
+			        || isParamOption(subArg, "jobs=")
+			        || isParamOption(subArg, "cache=")
+			        || isOption(subArg, "Z", "preserve-date")
+			        || isOption(subArg, "v", "verbose")
+			        || isOption(subArg, "Q", "formatted")
+			        || isOption(subArg, "q", "quiet")
+			        || isOption(subArg, "i", "ignore-exclude-errors")
+			        || isOption(subArg, "xi", "ignore-exclude-errors-x")
+			        || isOption(subArg, "X", "errors-to-stdout"))
+				continue;
+			options.append(subArg).append("\n");
+		}
+	}
+	return options;
+}
+#endif
+
 string ASOptions::getOptionErrors() const
 {
 	return optionErrors.str();
@@ -3824,6 +5638,140 @@ size_t ASEncoding::utf16len(const utf16* utf16In) const
 	return length;
 }
 
+// The ASCII block functions convert or count the ASCII characters at the
+// start of a buffer, 16 bytes at a time with SSE2 or 8 bytes in a 64-bit
+// word without it. They stop at the first block with a non-ASCII character,
+// or with less than a full block, which are done by the callers one
+// character at a time. The utf-16 byte order is the same as the conversion
+// functions, isBigEndian swaps the bytes of a little endian word.
+
+// Return the number of utf-8 bytes in the ASCII blocks at the start of utf8In.
+size_t ASEncoding::asciiLengthUtf8(const ubyte* utf8In, size_t inLen)
+{
+	size_t i = 0;
+#ifdef ASTYLE_SSE2
+	for (; i + 16 <= inLen; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8In + i));
+		if (_mm_movemask_epi8(block) != 0)
+			break;
+	}
+#else
+	for (; i + 8 <= inLen; i += 8)
+	{
+		uint64_t block;
+		memcpy(&block, utf8In + i, sizeof(block));
+		if ((block & 0x8080808080808080ULL) != 0)
+			break;
+	}
+#endif
+	return i;
+}
+
+// Return the number of utf-16 characters in the ASCII blocks at the start of utf16In.
+// The number of characters in utf16In is 'units'.
+size_t ASEncoding::asciiLengthUtf16(const ubyte* utf16In, size_t units, bool isBigEndian)
+{
+	size_t i = 0;
+#ifdef ASTYLE_SSE2
+	// an ASCII character has the high byte zero and the low byte less than 0x80
+	const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(isBigEndian ? 0x80FF : 0xFF80));
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= units; i += 8)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16In + i * 2));
+		__m128i isAscii = _mm_cmpeq_epi16(_mm_and_si128(block, nonAscii), zero);
+		if (_mm_movemask_epi8(isAscii) != 0xFFFF)
+			break;
+	}
+#else
+	// the mask is built from bytes so it does not depend on the computer byte order
+	const ubyte maskBytes[2][8] = { { 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF },
+		{ 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80 }
+	};
+	uint64_t nonAscii;
+	memcpy(&nonAscii, maskBytes[isBigEndian ? 1 : 0], sizeof(nonAscii));
+	for (; i + 4 <= units; i += 4)
+	{
+		uint64_t block;
+		memcpy(&block, utf16In + i * 2, sizeof(block));
+		if ((block & nonAscii) != 0)
+			break;
+	}
+#endif
+	return i;
+}
+
+// Convert the ASCII blocks at the start of utf8In to utf-16.
+// Return the number of characters converted.
+size_t ASEncoding::asciiUtf8ToUtf16(const ubyte* utf8In, size_t inLen, bool isBigEndian, utf16* utf16Out)
+{
+	size_t i = 0;
+#ifdef ASTYLE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= inLen; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8In + i));
+		if (_mm_movemask_epi8(block) != 0)
+			break;
+		// interleave the bytes with zero bytes to get the utf-16 words
+		__m128i low = isBigEndian ? _mm_unpacklo_epi8(zero, block) : _mm_unpacklo_epi8(block, zero);
+		__m128i high = isBigEndian ? _mm_unpackhi_epi8(zero, block) : _mm_unpackhi_epi8(block, zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(utf16Out + i), low);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(utf16Out + i + 8), high);
+	}
+#else
+	for (; i + 8 <= inLen; i += 8)
+	{
+		uint64_t block;
+		memcpy(&block, utf8In + i, sizeof(block));
+		if ((block & 0x8080808080808080ULL) != 0)
+			break;
+		for (size_t j = i; j < i + 8; j++)
+			utf16Out[j] = static_cast<utf16>(isBigEndian ? utf8In[j] << 8 : utf8In[j]);
+	}
+#endif
+	return i;
+}
+
+// Convert the ASCII blocks at the start of utf16In to utf-8.
+// The number of characters in utf16In is 'units'.
+// Return the number of characters converted.
+size_t ASEncoding::asciiUtf16ToUtf8(const ubyte* utf16In, size_t units, bool isBigEndian, ubyte* utf8Out)
+{
+	size_t i = 0;
+#ifdef ASTYLE_SSE2
+	const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(isBigEndian ? 0x80FF : 0xFF80));
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= units; i += 16)
+	{
+		__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16In + i * 2));
+		__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16In + i * 2 + 16));
+		__m128i isAscii = _mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(low, high), nonAscii), zero);
+		if (_mm_movemask_epi8(isAscii) != 0xFFFF)
+			break;
+		// the characters are less than 0x80 so the pack does not saturate
+		if (isBigEndian)
+		{
+			low = _mm_srli_epi16(low, 8);
+			high = _mm_srli_epi16(high, 8);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(utf8Out + i), _mm_packus_epi16(low, high));
+	}
+#else
+	size_t lowByte = isBigEndian ? 1 : 0;
+	while (i < units)
+	{
+		size_t blockEnd = i + asciiLengthUtf16(utf16In + i * 2, min(units - i, size_t(4)), isBigEndian);
+		if (blockEnd == i)
+			break;
+		for (; i < blockEnd; i++)
+			utf8Out[i] = utf16In[i * 2 + lowByte];
+	}
+#endif
+	return i;
+}
+
 // Adapted from SciTE UniConversion.cxx.
 // Copyright 1998-2001 by Neil Hodgson <neilh@scintilla.org>
 // Modified for Artistic Style by Jim Pattee.
@@ -3834,11 +5782,21 @@ size_t ASEncoding::utf8LengthFromUtf16(const char* utf16In, size_t inLen, bool i
 	size_t len = 0;
 	size_t wcharLen = (inLen / 2) + (inLen % 2);
 	const char16_t* uptr = reinterpret_cast<const char16_t*>(utf16In);
+	const ubyte* bytes = reinterpret_cast<const ubyte*>(utf16In);
 	for (size_t i = 0; i < wcharLen;)
 	{
 		size_t uch = isBigEndian ? swap16bit(uptr[i]) : uptr[i];
 		if (uch < 0x80)
+		{
+			// count the ASCII blocks that follow at once
+			if (i + 1 < inLen / 2)
+			{
+				size_t asciiLen = asciiLengthUtf16(bytes + (i + 1) * 2, (inLen / 2) - (i + 1), isBigEndian);
+				len += asciiLen;
+				i += asciiLen;
+			}
 			len++;
+		}
 		else if (uch < 0x800)
 			len += 2;
 		else if ((uch >= SURROGATE_LEAD_FIRST) && (uch <= SURROGATE_LEAD_LAST))
@@ -3869,6 +5827,39 @@ size_t ASEncoding::utf8ToUtf16(char* utf8In, size_t inLen, bool isBigEndian, cha
 	// the BOM will automatically be converted to utf-16
 	while (pRead < pEnd)
 	{
+		if (state == eStart)
+		{
+			if (*pRead < 0x80)
+			{
+				// convert the ASCII blocks at once
+				size_t asciiLen = asciiUtf8ToUtf16(pRead, pEnd - pRead, isBigEndian, pCur);
+				pRead += asciiLen;
+				pCur += asciiLen;
+				if (pRead >= pEnd)
+					break;
+			}
+			else if (pEnd - pRead >= 3
+			         && (0xF0 & *pRead) == 0xE0
+			         && (0xC0 & pRead[1]) == 0x80
+			         && (0xC0 & pRead[2]) == 0x80)
+			{
+				// a valid 3 byte sequence is converted at once, an invalid
+				// sequence is converted by the state machine the same as before
+				int codePoint = ((0x0F & pRead[0]) << 12) | ((0x3F & pRead[1]) << 6) | (0x3F & pRead[2]);
+				*pCur++ = static_cast<utf16>(isBigEndian ? swap16bit(codePoint) : codePoint);
+				pRead += 3;
+				continue;
+			}
+			else if (pEnd - pRead >= 2
+			         && (0xE0 & *pRead) == 0xC0
+			         && (0xC0 & pRead[1]) == 0x80)
+			{
+				int codePoint = ((0x1F & pRead[0]) << 6) | (0x3F & pRead[1]);
+				*pCur++ = static_cast<utf16>(isBigEndian ? swap16bit(codePoint) : codePoint);
+				pRead += 2;
+				continue;
+			}
+		}
 		switch (state)
 		{
 			case eStart:
@@ -3937,9 +5928,20 @@ size_t ASEncoding::utf16LengthFromUtf8(const char* utf8In, size_t len) const
 {
 	size_t ulen = 0;
 	size_t charLen;
+	const ubyte* bytes = reinterpret_cast<const ubyte*>(utf8In);
 	for (size_t i = 0; i < len;)
 	{
 		unsigned char ch = static_cast<unsigned char>(utf8In[i]);
+		if (ch < 0x80)
+		{
+			// count the ASCII blocks at once
+			size_t asciiLen = asciiLengthUtf8(bytes + i, len - i);
+			ulen += asciiLen;
+			i += asciiLen;
+			if (i >= len)
+				break;
+			ch = bytes[i];
+		}
 		if (ch < 0x80)
 			charLen = 1;
 		else if (ch < 0x80 + 0x40 + 0x20)
@@ -3962,8 +5964,10 @@ size_t ASEncoding::utf16LengthFromUtf8(const char* utf8In, size_t len) const
 // Copyright (C) 2002 Scott Kirkwood.
 // Modified for Artistic Style by Jim Pattee.
 // Convert a utf-16 file to utf-8.
+// A file read in blocks must pass the same blockState for each block.
+// Without a blockState the input must be a single block.
 size_t ASEncoding::utf16ToUtf8(char* utf16In, size_t inLen, bool isBigEndian,
-                               bool firstBlock, char* utf8Out) const
+                               bool firstBlock, char* utf8Out, eState* blockState /*nullptr*/) const
 {
 	int nCur16 = 0;
 	int nCur = 0;
@@ -3971,13 +5975,27 @@ size_t ASEncoding::utf16ToUtf8(char* utf16In, size_t inLen, bool isBigEndian,
 	ubyte* pCur = reinterpret_cast<ubyte*>(utf8Out);
 	const ubyte* pEnd = pRead + inLen;
 	const ubyte* pCurStart = pCur;
-	static eState state = eStart;	// state is retained for subsequent blocks
+	assert(firstBlock || blockState != nullptr);
+	eState localState = eStart;
+	eState& state = (blockState != nullptr) ? *blockState : localState;	// retained for subsequent blocks
 	if (firstBlock)
 		state = eStart;
 
 	// the BOM will automatically be converted to utf-8
 	while (pRead < pEnd)
 	{
+		if (state == eStart
+		        && pEnd - pRead >= 2
+		        && pRead[isBigEndian ? 0 : 1] == 0
+		        && pRead[isBigEndian ? 1 : 0] < 0x80)
+		{
+			// convert the ASCII blocks at once
+			size_t asciiLen = asciiUtf16ToUtf8(pRead, static_cast<size_t>(pEnd - pRead) / 2, isBigEndian, pCur);
+			pRead += asciiLen * 2;
+			pCur += asciiLen;
+			if (pRead >= pEnd)
+				break;
+		}
 		switch (state)
 		{
 			case eStart:
@@ -4222,58 +6240,172 @@ extern "C" EXPORT char* STDCALL AStyleMain(const char* pSourceIn,		// the source
 		return nullptr;
 	}
 
-	ASFormatter formatter;
-	ASOptions options(formatter);
+	ASFormatterHandle handle(fpErrorHandler, fpMemoryAlloc);
+	handle.setOptions(pOptions);
+	return handle.formatToAlloc(pSourceIn, strlen(pSourceIn));
+}
 
-	vector<string> optionsVector;
-	stringstream opt(pOptions);
+/**
+ * Format a range of lines in the source.
+ * The lines that are formatted are described by ASFormatterHandle::formatRange.
+ * A handle from AStyleCreate should be used by an editor that formats the
+ * same source repeatedly, its checkpoints are kept between calls.
+ *
+ * @param pFirstLine    The first line of the range. It is changed to the first
+ *                      line replaced by the returned text.
+ * @param pLastLine     The last line of the range. It is changed to the last
+ *                      line replaced by the returned text, including the end
+ *                      of line if it is not the end of the source.
+ * @return              The formatted lines, or nullptr if an error occurred.
+ */
+extern "C" EXPORT char* STDCALL AStyleMainRange(const char* pSourceIn,	// the source to be formatted
+                                                const char* pOptions,	// AStyle options
+                                                int* pFirstLine,		// first line of the range
+                                                int* pLastLine,			// last line of the range
+                                                fpError fpErrorHandler,	// error handler function
+                                                fpAlloc fpMemoryAlloc)	// memory allocation function
+{
+	if (fpErrorHandler == nullptr)         // cannot display a message if no error handler
+		return nullptr;
 
-	options.importOptions(opt, optionsVector);
+	if (pSourceIn == nullptr)
+	{
+		fpErrorHandler(101, "No pointer to source input.");
+		return nullptr;
+	}
+	if (pOptions == nullptr)
+	{
+		fpErrorHandler(102, "No pointer to AStyle options.");
+		return nullptr;
+	}
+	if (fpMemoryAlloc == nullptr)
+	{
+		fpErrorHandler(103, "No pointer to memory allocation function.");
+		return nullptr;
+	}
 
-	bool ok = options.parseOptions(optionsVector, "Invalid Artistic Style options:");
-	if (!ok)
-		fpErrorHandler(130, options.getOptionErrors().c_str());
+	ASFormatterHandle handle(fpErrorHandler, fpMemoryAlloc);
+	handle.setOptions(pOptions);
+	return handle.formatRangeToAlloc(pSourceIn, pFirstLine, pLastLine);
+}
 
-	stringstream in(pSourceIn);
-	ASStreamIterator<stringstream> streamIterator(&in);
-	ostringstream out;
-	formatter.init(&streamIterator);
+//----------------------------------------------------------------------------
+// ASTYLE_LIB entry points for the formatter handle
+//----------------------------------------------------------------------------
+/*
+ * The handle keeps the formatter with the parsed options between calls,
+ * so the options are not parsed again for each source. A handle must be
+ * used by only one thread at a time.
+ *
+ * IMPORTANT Visual C DLL linker for WIN32 must have the additional options:
+ *           /EXPORT:AStyleCreate=_AStyleCreate@12
+ *           /EXPORT:AStyleFormat=_AStyleFormat@8
+ *           /EXPORT:AStyleFormatBuffer=_AStyleFormatBuffer@20
+ *           /EXPORT:AStyleFormatRange=_AStyleFormatRange@16
+ *           /EXPORT:AStyleDestroy=_AStyleDestroy@4
+ * No /EXPORT is required for x64
+ */
 
-	while (formatter.hasMoreLines())
+/**
+ * Create a formatter handle with the options.
+ * Invalid options are sent to the error handler and the handle is still
+ * created, the same as AStyleMain.
+ *
+ * @return              The handle, or nullptr if an error occurred.
+ *                      It must be released by AStyleDestroy.
+ */
+extern "C" EXPORT AStyleHandle STDCALL AStyleCreate(const char* pOptions,		// AStyle options
+                                                    fpError fpErrorHandler,	// error handler function
+                                                    fpAlloc fpMemoryAlloc)		// memory allocation function
+{
+	if (fpErrorHandler == nullptr)         // cannot display a message if no error handler
+		return nullptr;
+
+	if (pOptions == nullptr)
 	{
-		out << formatter.nextLine();
-		if (formatter.hasMoreLines())
-			out << streamIterator.getOutputEOL();
-		else
-		{
-			// this can happen if the file if missing a closing brace and break-blocks is requested
-			if (formatter.getIsLineReady())
-			{
-				out << streamIterator.getOutputEOL();
-				out << formatter.nextLine();
-			}
-		}
+		fpErrorHandler(102, "No pointer to AStyle options.");
+		return nullptr;
+	}
+	if (fpMemoryAlloc == nullptr)
+	{
+		fpErrorHandler(103, "No pointer to memory allocation function.");
+		return nullptr;
 	}
 
-	size_t textSizeOut = out.str().length();
-	char* pTextOut = fpMemoryAlloc((long) textSizeOut + 1);     // call memory allocation function
-	if (pTextOut == nullptr)
+	ASFormatterHandle* handle = new (nothrow) ASFormatterHandle(fpErrorHandler, fpMemoryAlloc);
+	if (handle == nullptr)
 	{
-		fpErrorHandler(120, "Allocation failure on output.");
+		fpErrorHandler(105, "Allocation failure on formatter handle.");
 		return nullptr;
 	}
+	handle->setOptions(pOptions);
+	return handle;
+}
 
-	strcpy(pTextOut, out.str().c_str());
-#ifndef NDEBUG
-	// The checksum is an assert in the console build and ASFormatter.
-	// This error returns the incorrectly formatted file to the editor.
-	// This is done to allow the file to be saved for debugging purposes.
-	if (formatter.getChecksumDiff() != 0)
-		fpErrorHandler(220,
-		               "Checksum error.\n"
-		               "The incorrectly formatted file will be returned for debugging.");
-#endif
-	return pTextOut;
+/**
+ * Format a source with a handle from AStyleCreate.
+ * The output is allocated by the memory allocation function of the handle.
+ *
+ * @return              The formatted text, or nullptr if an error occurred.
+ */
+extern "C" EXPORT char* STDCALL AStyleFormat(AStyleHandle handle,		// handle from AStyleCreate
+                                             const char* pSourceIn)		// the source to be formatted
+{
+	if (handle == nullptr)         // cannot display a message if no handle
+		return nullptr;
+
+	// a null source is sent to the error handler by the handle
+	size_t sourceLength = (pSourceIn != nullptr) ? strlen(pSourceIn) : 0;
+	return handle->formatToAlloc(pSourceIn, sourceLength);
+}
+
+/**
+ * Format a source of sourceLength characters with a handle from AStyleCreate.
+ * The source does not need a terminating NUL and may contain NUL characters.
+ * The formatted text is sent to the output function in pieces as it is
+ * formatted, it is not terminated by a NUL. The pWriteData pointer is
+ * passed to the output function unchanged.
+ * If an error is returned, the output that was sent must be discarded.
+ *
+ * @return              1 if the source was formatted, 0 if an error occurred.
+ */
+extern "C" EXPORT int STDCALL AStyleFormatBuffer(AStyleHandle handle,		// handle from AStyleCreate
+                                                 const char* pSourceIn,		// the source to be formatted
+                                                 size_t sourceLength,		// length of the source
+                                                 fpWrite fpWriteOutput,		// output function
+                                                 void* pWriteData)			// data for the output function
+{
+	if (handle == nullptr)         // cannot display a message if no handle
+		return 0;
+
+	return handle->formatToWrite(pSourceIn, sourceLength, fpWriteOutput, pWriteData) ? 1 : 0;
+}
+
+/**
+ * Format a range of lines in the source with a handle from AStyleCreate.
+ * The checkpoints taken by the previous calls are used for the parts of
+ * the source that have not changed, so an editor should use one handle
+ * for each source it formats repeatedly.
+ * The parameters and the return are the same as AStyleMainRange.
+ *
+ * @return              The formatted lines, or nullptr if an error occurred.
+ */
+extern "C" EXPORT char* STDCALL AStyleFormatRange(AStyleHandle handle,		// handle from AStyleCreate
+                                                  const char* pSourceIn,	// the source to be formatted
+                                                  int* pFirstLine,			// first line of the range
+                                                  int* pLastLine)			// last line of the range
+{
+	if (handle == nullptr)                 // cannot display a message if no handle
+		return nullptr;
+	return handle->formatRangeToAlloc(pSourceIn, pFirstLine, pLastLine);
+}
+
+/**
+ * Release a handle from AStyleCreate.
+ */
+extern "C" EXPORT void STDCALL AStyleDestroy(AStyleHandle handle)
+{
+	delete handle;
 }
 
 extern "C" EXPORT const char* STDCALL AStyleGetVersion(void)
@@ -4306,6 +6438,12 @@ int main(int argc, char** argv)
 	else
 		console->formatCinToCout();
 
+	// the check option reports files that would be formatted
+	if (console->getIsCheck() && console->getFilesFormatted() > 0)
+		return EXIT_FAILURE;
+	// the verify option reports files that were not written
+	if (console->getFilesVerifyFailed() > 0)
+		return EXIT_FAILURE;
 	return EXIT_SUCCESS;
 }
 
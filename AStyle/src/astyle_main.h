@@ -12,8 +12,10 @@
 
 #include "astyle.h"
 
-#include <sstream>
+#include <cstdint>
 #include <ctime>
+#include <map>
+#include <sstream>
 
 #if defined(__BORLANDC__) && __BORLANDC__ < 0x0650
 	// Embarcadero needs this for the following utime.h
@@ -104,6 +106,8 @@
 	// define pointers to callback error handler and memory allocation
 	typedef void (STDCALL* fpError)(int errorNumber, const char* errorMessage);
 	typedef char* (STDCALL* fpAlloc)(unsigned long memoryNeeded);
+	// define pointer to callback output function for AStyleFormatBuffer
+	typedef void (STDCALL* fpWrite)(const char* text, size_t textLength, void* pWriteData);
 
 #endif  // #ifdef ASTYLE_LIB
 
@@ -130,12 +134,12 @@ public:
 	explicit ASStreamIterator(T* in);
 	virtual ~ASStreamIterator();
 	bool getLineEndChange(int lineEndFormat) const;
-	int  getStreamLength() const;
-	string nextLine(bool emptyLineWasDeleted);
-	string peekNextLine();
-	void peekReset();
+	streamoff getStreamLength() const override;
+	string nextLine(bool emptyLineWasDeleted) override;
+	string peekNextLine() override;
+	void peekReset() override;
 	void saveLastInputLine();
-	streamoff tellg();
+	streamoff tellg() override;
 
 private:
 	ASStreamIterator(const ASStreamIterator& copy);       // copy constructor not to be implemented
@@ -155,8 +159,100 @@ public:	// inline functions
 	bool compareToInputBuffer(const string& nextLine_) const
 	{ return (nextLine_ == prevBuffer); }
 	const string& getOutputEOL() const { return outputEOL; }
-	streamoff getPeekStart() const { return peekStart; }
-	bool hasMoreLines() const { return !inStream->eof(); }
+	streamoff getPeekStart() const override { return peekStart; }
+	bool hasMoreLines() const override { return !inStream->eof(); }
+};
+
+//----------------------------------------------------------------------------
+// ASBufferIterator class
+// iterates the lines of a contiguous character buffer, such as a memory
+// mapped file, without copying the buffer to a stream
+// it can also read a stream that cannot seek, such as a pipe, as the
+// lines are needed
+// it returns the same lines and end of line counts as ASStreamIterator
+// ASSourceIterator is an inherited abstract class defined in astyle.h
+//----------------------------------------------------------------------------
+
+class ASBufferIterator : public ASSourceIterator
+{
+public:
+	bool checkForEmptyLine;
+
+	// function declarations
+	ASBufferIterator(const char* data, size_t dataLength);
+	explicit ASBufferIterator(istream* in, size_t blockSize = 65536);
+	virtual ~ASBufferIterator();
+	bool getLineEndChange(int lineEndFormat) const;
+	streamoff getStreamLength() const override;
+	string nextLine(bool emptyLineWasDeleted) override;
+	string peekNextLine() override;
+	void peekReset() override;
+	void saveLastInputLine();
+	void seekg(streamoff pos);
+	streamoff tellg() override;
+
+private:
+	// a line split from the buffer
+	struct LineSpan
+	{
+		size_t start;           // position of the line in the buffer
+		size_t length;          // length of the line without the end of line
+		size_t eolLength;       // number of end of line characters, 0 at the end of the buffer
+	};
+
+	ASBufferIterator(const ASBufferIterator& copy);       // copy constructor not to be implemented
+	ASBufferIterator& operator=(ASBufferIterator&);       // assignment operator not to be implemented
+	size_t findLineEnd(size_t start);
+	size_t findNextChar(char ch, size_t start, size_t& searchStart, size_t& found) const;
+	size_t findStreamLineEnd(size_t start);
+	bool hasData(size_t pos);
+	bool readStream();
+	size_t readStreamLine(char* readData);
+	LineSpan splitLine(size_t start);
+	const char* inData;     // pointer to the input buffer
+	size_t inLength;        // length of the input buffer, or of the stream read so far
+	istream* inStream;      // stream read in blocks, nullptr for a buffer
+	size_t inBlockSize;     // maximum number of bytes of each stream read
+	bool inStreamEnd;       // the stream has been read to the end
+	string inWindow;        // stream data that is still needed, inData points to it
+	size_t inWindowStart;   // stream position of the first character in inWindow
+	size_t inReadEnd;       // end of the input examined, past the end if the end was found
+	size_t inPos;           // position of the next character to read
+	bool inEof;             // a read was attempted at the end of the buffer
+	size_t lfSearchStart;   // start of the last search for a LF
+	size_t lfFound;         // position of the LF found by the last search
+	size_t crSearchStart;   // start of the last search for a CR
+	size_t crFound;         // position of the CR found by the last search
+	vector<LineSpan> lineCache; // lines split by peekNextLine, starting at or before inPos
+	size_t lineCacheNext;   // index in lineCache of the line for nextLine
+	size_t peekIndex;       // index in lineCache of the line for peekNextLine
+	size_t bytesSplit;      // number of bytes searched for line ends
+	size_t bytesPeeked;     // number of bytes returned by peekNextLine
+	string buffer;          // current input line
+	string prevBuffer;      // previous input line
+	int lineNumber;         // line number of buffer, one based
+	int prevLineNumber;     // line number of prevBuffer, one based
+	string outputEOL;       // next output end of line char
+	int eolWindows;         // number of Windows line endings, CRLF
+	int eolLinux;           // number of Linux line endings, LF
+	int eolMacOld;          // number of old Mac line endings. CR
+	streamoff peekStart;    // starting position for peekNextLine
+	bool prevLineDeleted;   // the previous input line was deleted
+
+	// pointer to the character at stream position 'pos'
+	const char* charAt(size_t pos) const { return inData + (pos - inWindowStart); }
+
+public:	// inline functions
+	bool compareToInputBuffer(const string& nextLine_) const
+	{ return (nextLine_ == prevBuffer); }
+	size_t getBytesPeeked() const { return bytesPeeked; }	// for unit testing
+	size_t getBytesSplit() const { return bytesSplit; }	// for unit testing
+	size_t getWindowCapacity() const { return inWindow.capacity(); }	// for unit testing
+	size_t getReadEnd() const { return inReadEnd; }
+	int getCompareLineNumber() const { return prevLineNumber; }	// input line of compareToInputBuffer
+	const string& getOutputEOL() const { return outputEOL; }
+	streamoff getPeekStart() const override { return peekStart; }
+	bool hasMoreLines() const override { return !inEof; }
 };
 
 //----------------------------------------------------------------------------
@@ -175,9 +271,17 @@ private:
 	enum { SURROGATE_TRAIL_FIRST = 0xDC00 };
 	enum { SURROGATE_TRAIL_LAST = 0xDFFF };
 	enum { SURROGATE_FIRST_VALUE = 0x10000 };
-	enum eState { eStart, eSecondOf4Bytes, ePenultimate, eFinal };
+
+	// blocks of ASCII characters, see the ASEncoding class in astyle_main.cpp
+	static size_t asciiLengthUtf8(const ubyte* utf8In, size_t inLen);
+	static size_t asciiLengthUtf16(const ubyte* utf16In, size_t units, bool isBigEndian);
+	static size_t asciiUtf8ToUtf16(const ubyte* utf8In, size_t inLen, bool isBigEndian, utf16* utf16Out);
+	static size_t asciiUtf16ToUtf8(const ubyte* utf16In, size_t units, bool isBigEndian, ubyte* utf8Out);
 
 public:
+	// utf16ToUtf8 conversion state, kept by the caller for subsequent blocks
+	enum eState { eStart, eSecondOf4Bytes, ePenultimate, eFinal };
+
 	bool   getBigEndian() const;
 	int    swap16bit(int value) const;
 	size_t utf16len(const utf16* utf16In) const;
@@ -185,7 +289,7 @@ public:
 	size_t utf8ToUtf16(char* utf8In, size_t inLen, bool isBigEndian, char* utf16Out) const;
 	size_t utf16LengthFromUtf8(const char* utf8In, size_t len) const;
 	size_t utf16ToUtf8(char* utf16In, size_t inLen, bool isBigEndian,
-	                   bool firstBlock, char* utf8Out) const;
+	                   bool firstBlock, char* utf8Out, eState* blockState = nullptr) const;
 };
 
 //----------------------------------------------------------------------------
@@ -205,6 +309,9 @@ public:
 	string getOptionErrors() const;
 	void importOptions(stringstream& in, vector<string>& optionsVector);
 	bool parseOptions(vector<string>& optionsVector, const string& errorInfo);
+#ifndef ASTYLE_LIB
+	string getFormattingOptions(const vector<string>& optionsVector);
+#endif
 
 private:
 	// variables
@@ -225,10 +332,79 @@ private:
 	bool isParamOption(const string& arg, const char* option);
 	bool isParamOption(const string& arg, const char* option1, const char* option2);
 	void parseOption(const string& arg, const string& errorInfo);
+	void splitOption(const string& arg, vector<string>& subArgs) const;
 };
 
 #ifndef	ASTYLE_LIB
 
+//----------------------------------------------------------------------------
+// ASMappedFile class for console build
+// maps an input file into memory for ASBufferIterator
+// the file is read into memory if it cannot be mapped,
+// if it is not a regular file, or if it changes while it is mapped
+// LIMITATION: on Linux and macOS a mapped file that is truncated by another
+//     process while it is formatted raises SIGBUS and ends the program,
+//     a change after the size is checked cannot be detected
+//     Windows does not allow a mapped file to be truncated
+//----------------------------------------------------------------------------
+
+class ASMappedFile
+{
+public:
+	ASMappedFile();
+	~ASMappedFile();
+	void close();
+	bool open(const string& fileName_);
+	void replaceData(string& newData);
+
+private:
+	ASMappedFile(const ASMappedFile& copy);       // copy constructor not to be implemented
+	ASMappedFile& operator=(ASMappedFile&);       // assignment operator not to be implemented
+	bool mapFile(const string& fileName_);
+	const char* data;       // pointer to the file data
+	size_t dataSize;        // size of the file data
+	bool isMapped;          // data is a mapped view of the file
+	string fileData;        // file data when the file is not mapped
+
+public:	// inline functions
+	const char* getData() const { return data; }
+	size_t getSize() const { return dataSize; }
+};
+
+//----------------------------------------------------------------------------
+// ASFileCache class for console build
+// remembers the files that were formatted with the same options
+// so they can be skipped without formatting them again
+//----------------------------------------------------------------------------
+
+class ASFileCache
+{
+public:
+	ASFileCache();
+	static uint64_t computeHash(const char* data, size_t dataSize);
+	bool isFileCached(const string& fileName_);
+	bool load(const string& cacheFileName);
+	void removeFile(const string& fileName_);
+	bool save(const string& cacheFileName) const;
+	void setOptionsHash(uint64_t hash);
+	void updateFile(const string& fileName_);
+
+private:
+	// the state of a formatted file
+	struct CacheEntry
+	{
+		uint64_t optionsHash;   // hash of the options used to format the file
+		uint64_t contentHash;   // hash of the formatted file contents
+		long long fileSize;     // size of the formatted file
+		long long modified;     // date modified of the formatted file
+	};
+
+	bool getFileState(const string& fileName_, CacheEntry& entry) const;
+	map<string, CacheEntry> entries;    // file paths and states
+	uint64_t optionsHash;               // hash of the current options
+	bool isModified;                    // entries have changed since load
+};
+
 //----------------------------------------------------------------------------
 // ASConsole class for console build
 //----------------------------------------------------------------------------
@@ -239,10 +415,12 @@ private:    // variables
 	ASFormatter& formatter;             // reference to the ASFormatter object
 	ASEncoding encode;                  // file encoding conversion
 	ASLocalizer localizer;              // language translation
+	ASFileCache fileCache;              // formatted files for the cache= option
 	ostream* errorStream;               // direct error messages to cerr or cout
 	// command line options
 	bool isRecursive;                   // recursive option
 	bool isDryRun;                      // dry-run option
+	bool isCheck;                       // check option, stop at the first changed line
 	bool noBackup;                      // suffix=none option
 	bool preserveDate;                  // preserve-date option
 	bool isVerbose;                     // verbose option
@@ -251,6 +429,8 @@ private:    // variables
 	bool ignoreExcludeErrors;           // don't abort on unmatched excludes
 	bool ignoreExcludeErrorsDisplay;    // don't display unmatched excludes
 	bool useAscii;                      // ascii option
+	int  numJobs;                       // jobs= option, files formatted concurrently
+	string cacheFileName;               // cache= option, file path and name of the cache
 	// other variables
 	bool bypassBrowserOpen;             // don't open the browser on html options
 	bool hasWildcard;                   // file name includes a wildcard
@@ -258,8 +438,15 @@ private:    // variables
 	bool filesAreIdentical;             // input and output files are identical
 	int  filesFormatted;                // number of files formatted
 	int  filesUnchanged;                // number of files unchanged
+	int  filesVerifyFailed;             // number of files not written by the verify option
 	bool lineEndsMixed;                 // output has mixed line ends
 	int  linesOut;                      // number of output lines
+	int  changedLine;                   // first changed line of the last file, check option
+	bool verifyFailed;                  // the last file failed the verify option
+	bool isWorker;                      // worker console of formatFilesConcurrently()
+	string fileErrorMessage;            // a worker's error for the last file, reported by the main console
+	int  cacheHits;                     // number of files skipped by the cache
+	int  cacheMisses;                   // number of files not found in the cache
 
 	string outputEOL;                   // current line end
 	string prevEOL;                     // previous line end
@@ -282,7 +469,7 @@ private:    // variables
 public:     // functions
 	explicit ASConsole(ASFormatter& formatterArg);
 	~ASConsole();
-	void convertLineEnds(ostringstream& out, int lineEnd);
+	void convertLineEnds(string& out, int lineEnd);
 	FileEncoding detectEncoding(const char* data, size_t dataSize) const;
 	void error() const;
 	void error(const char* why, const char* what) const;
@@ -290,17 +477,24 @@ public:     // functions
 	vector<string> getArgvOptions(int argc, char** argv) const;
 	bool fileExists(const char* file) const;
 	bool fileNameVectorIsEmpty() const;
+	int  getCacheHits() const;
+	int  getCacheMisses() const;
+	string getCacheFileName() const;
+	int  getChangedLine() const;
 	ostream* getErrorStream() const;
 	bool getFilesAreIdentical() const;
 	int  getFilesFormatted() const;
+	int  getFilesVerifyFailed() const;
 	bool getIgnoreExcludeErrors() const;
 	bool getIgnoreExcludeErrorsDisplay() const;
+	bool getIsCheck() const;
 	bool getIsDryRun() const;
 	bool getIsFormattedOnly() const;
 	bool getIsQuiet() const;
 	bool getIsRecursive() const;
 	bool getIsVerbose() const;
 	bool getLineEndsMixed() const;
+	int  getNumJobs() const;
 	bool getNoBackup() const;
 	bool getPreserveDate() const;
 	string getLanguageID() const;
@@ -315,15 +509,18 @@ public:     // functions
 	void processFiles();
 	void processOptions(const vector<string>& argvOptions);
 	void setBypassBrowserOpen(bool state);
+	void setCacheFileName(const string& name);
 	void setErrorStream(ostream* errStreamPtr);
 	void setIgnoreExcludeErrors(bool state);
 	void setIgnoreExcludeErrorsAndDisplay(bool state);
+	void setIsCheck(bool state);
 	void setIsDryRun(bool state);
 	void setIsFormattedOnly(bool state);
 	void setIsQuiet(bool state);
 	void setIsRecursive(bool state);
 	void setIsVerbose(bool state);
 	void setNoBackup(bool state);
+	void setNumJobs(int jobs);
 	void setOptionFileName(const string& name);
 	void setOrigSuffix(const string& suffix);
 	void setPreserveDate(bool state);
@@ -344,17 +541,28 @@ public:     // functions
 private:	// functions
 	ASConsole(const ASConsole&);           // copy constructor not to be implemented
 	ASConsole& operator=(ASConsole&);      // assignment operator not to be implemented
-	void correctMixedLineEnds(ostringstream& out);
+	void checkCinFormatting(ASBufferIterator& streamIterator, LineEndFormat lineEndFormat);
+	void compareFormattedLine(ASBufferIterator& streamIterator, const string& nextLine,
+	                          int& unchangedLine);
+	uint64_t computeOptionsHash();
+	void correctMixedLineEnds(string& out);
+	void fileError(const char* why, const char* what);
 	void formatFile(const string& fileName_);
+	bool formatAndWriteFile(const string& fileName_);
+	void formatFilesConcurrently(vector<unique_ptr<ASConsole> >& workers);
+	bool isCacheUsed() const;
+	bool isFileCached(const string& fileName_);
 	string getParentDirectory(const string& absPath) const;
 	string findProjectOptionFilePath(const string& fileName_) const;
 	string getCurrentDirectory(const string& fileName_) const;
+	string getDisplayName(const string& fileName_) const;
 	void getFileNames(const string& directory, const vector<string>& wildcards);
 	void getFilePaths(const string& filePath);
 	string getFullPathName(const string& relativePath) const;
 	string getParam(const string& arg, const char* op);
 	bool isHomeOrInvalidAbsPath(const string& absPath) const;
 	void initializeOutputEOL(LineEndFormat lineEndFormat);
+	void initializeWorker(ASConsole& worker) const;
 	bool isOption(const string& arg, const char* op);
 	bool isOption(const string& arg, const char* a, const char* b);
 	bool isParamOption(const string& arg, const char* option);
@@ -365,14 +573,18 @@ private:	// functions
 	void printSeparatingLine() const;
 	void printVerboseHeader() const;
 	void printVerboseStats(clock_t startTime) const;
+	void reportFileResult(const string& fileName_, bool isFormatted, int lineNumber);
+	void reportVerifyFailure(const string& fileName_);
+	void updateFileCache(const string& fileName_, bool isFormatted);
 	FileEncoding readFile(const string& fileName_, stringstream& in) const;
-	void removeFile(const char* fileName_, const char* errMsg) const;
-	void renameFile(const char* oldFileName, const char* newFileName, const char* errMsg) const;
+	FileEncoding readFile(const string& fileName_, ASMappedFile& in);
+	void removeFile(const char* fileName_, const char* errMsg);
+	void renameFile(const char* oldFileName, const char* newFileName, const char* errMsg);
 	void setOutputEOL(LineEndFormat lineEndFormat, const string& currentEOL);
 	void sleep(int seconds) const;
 	int  waitForRemove(const char* newFileName) const;
 	int  wildcmp(const char* wild, const char* data) const;
-	void writeFile(const string& fileName_, FileEncoding encoding, ostringstream& out) const;
+	void writeFile(const string& fileName_, FileEncoding encoding, const string& out);
 #ifdef _WIN32
 	void displayLastError();
 #endif
@@ -394,10 +606,48 @@ public:
 	virtual char* convertUtf16ToUtf8(const char16_t* utf16In) const;
 
 private:
-	static char* STDCALL tempMemoryAllocation(unsigned long memoryNeeded);
+	ASEncoding encode;             // file encoding conversion
+};
+
+//----------------------------------------------------------------------------
+// ASFormatterHandle class for library build
+// keeps a formatter with parsed options for formatting many sources
+//----------------------------------------------------------------------------
+
+class ASFormatterHandle
+{
+public:
+	ASFormatterHandle(fpError fpErrorHandlerArg, fpAlloc fpMemoryAllocArg);
+	bool setOptions(const char* pOptions);
+	const string* format(const char* pSourceIn, size_t sourceLength);
+	char* formatToAlloc(const char* pSourceIn, size_t sourceLength);
+	bool formatToWrite(const char* pSourceIn, size_t sourceLength, fpWrite fpWriteOutput, void* pWriteData);
+	char* formatRangeToAlloc(const char* pSourceIn, int* pFirstLine, int* pLastLine);
 
 private:
-	ASEncoding encode;             // file encoding conversion
+	// a checkpoint taken by formatRange, it is valid while the source read is unchanged
+	struct RangeCheckpoint
+	{
+		unique_ptr<ASCheckpoint> checkpoint;
+		size_t basePos;         // source position of the iterator used by the checkpoint
+		size_t sourceRead;      // length of the source read, plus one if the end was read
+		int inputLine;          // first input line formatted after the checkpoint
+	};
+
+	ASFormatterHandle(const ASFormatterHandle&);            // copy constructor not to be implemented
+	ASFormatterHandle& operator=(ASFormatterHandle&);      // assignment operator not to be implemented
+	template<typename Write>
+	bool formatLines(const char* pSourceIn, size_t sourceLength, Write write);
+	const string* formatRange(const char* pSourceIn, int& firstLine, int& lastLine);
+
+private:
+	ASFormatter formatter;
+	string out;                    // formatted text, the capacity is kept between calls
+	fpError fpErrorHandler;
+	fpAlloc fpMemoryAlloc;
+	vector<RangeCheckpoint> checkpoints;    // checkpoints from formatRange, in line order
+	string checkpointSource;       // the source used by the last formatRange
+	int checkpointInterval;        // minimum number of input lines between checkpoints
 };
 
 #endif	// ASTYLE_LIB
@@ -444,7 +694,31 @@ extern "C" EXPORT char* STDCALL AStyleMain(const char* pSourceIn,
                                            const char* pOptions,
                                            fpError fpErrorHandler,
                                            fpAlloc fpMemoryAlloc);
+extern "C" EXPORT char* STDCALL AStyleMainRange(const char* pSourceIn,
+                                                const char* pOptions,
+                                                int* pFirstLine,
+                                                int* pLastLine,
+                                                fpError fpErrorHandler,
+                                                fpAlloc fpMemoryAlloc);
 extern "C" EXPORT const char* STDCALL AStyleGetVersion(void);
+// formatter handle interface
+// the handle is opaque to the caller, it may be declared as void*
+typedef astyle::ASFormatterHandle* AStyleHandle;
+extern "C" EXPORT AStyleHandle STDCALL AStyleCreate(const char* pOptions,
+                                                    fpError fpErrorHandler,
+                                                    fpAlloc fpMemoryAlloc);
+extern "C" EXPORT char* STDCALL AStyleFormat(AStyleHandle handle,
+                                             const char* pSourceIn);
+extern "C" EXPORT int STDCALL AStyleFormatBuffer(AStyleHandle handle,
+                                                 const char* pSourceIn,
+                                                 size_t sourceLength,
+                                                 fpWrite fpWriteOutput,
+                                                 void* pWriteData);
+extern "C" EXPORT char* STDCALL AStyleFormatRange(AStyleHandle handle,
+                                                  const char* pSourceIn,
+                                                  int* pFirstLine,
+                                                  int* pLastLine);
+extern "C" EXPORT void STDCALL AStyleDestroy(AStyleHandle handle);
 #endif	// ASTYLE_LIB
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,384 @@
+// AStyleTestBench.cpp
+// Copyright (c) 2018 by Jim Pattee <jimp03@email.com>.
+// This code is licensed under the MIT License.
+// License.md describes the conditions under which this software may be distributed.
+
+// AStyleTestBench measures the formatter. The allocation counts and the
+// times are reported with RecordProperty and are not checked, except that
+// the formatted output must be correct. The tests that check the behavior
+// of the optimized code are in AStyleTestCon.
+
+//----------------------------------------------------------------------------
+// headers
+//----------------------------------------------------------------------------
+
+#include "AStyleTestCon_Reference.h"
+#include <atomic>
+#include <chrono>
+
+//----------------------------------------------------------------------------
+// global variables
+//----------------------------------------------------------------------------
+
+// defined in AStyleTestBench_Alloc.cpp
+// used by the AllocationCount tests
+extern atomic<size_t> allocationCount;
+extern atomic<bool> countAllocations;
+
+//----------------------------------------------------------------------------
+// anonymous namespace
+//----------------------------------------------------------------------------
+
+namespace {
+//
+//----------------------------------------------------------------------------
+// AStyle allocation count tests
+//----------------------------------------------------------------------------
+
+TEST(AllocationCount, InitBenchmark)
+// Count the heap allocations made by ASFormatter::init() and by formatting
+// a series of small files with one ASFormatter object.
+// The stacks are reused, so init() does not allocate after the first file.
+{
+	string textIn =
+	    "namespace FooName\n"
+	    "{\n"
+	    "class Foo\n"
+	    "{\n"
+	    "public:\n"
+	    "    void foo(int a)\n"
+	    "    {\n"
+	    "#ifdef FOO\n"
+	    "        if (a > 0 && (bar(a) || baz[a]))\n"
+	    "        {\n"
+	    "            for (int i = 0; i < a; i++)\n"
+	    "                bar(i);\n"
+	    "        }\n"
+	    "        else\n"
+	    "            baz(a);\n"
+	    "#endif\n"
+	    "    }\n"
+	    "};\n"
+	    "}\n";
+	const int files = 100;
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	size_t firstInitAllocations = 0;
+	size_t firstFileAllocations = 0;
+	size_t initAllocations = 0;
+	size_t fileAllocations = 0;
+	string firstTextOut;
+	for (int i = 0; i < files; i++)
+	{
+		string textOut;
+		ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+		allocationCount = 0;
+		countAllocations = true;
+		formatter.init(&bufferIterator);
+		countAllocations = false;
+		size_t fileInitAllocations = allocationCount;
+		allocationCount = 0;
+		countAllocations = true;
+		while (formatter.hasMoreLines())
+			textOut.append(formatter.nextLine()).append("\n");
+		countAllocations = false;
+		if (i == 0)
+		{
+			firstTextOut = textOut;
+			firstInitAllocations = fileInitAllocations;
+			firstFileAllocations = allocationCount;
+			continue;
+		}
+		initAllocations += fileInitAllocations;
+		fileAllocations += allocationCount;
+		EXPECT_EQ(firstTextOut, textOut);
+	}
+	RecordProperty("Files", files);
+	RecordProperty("FirstInitAllocations", static_cast<int>(firstInitAllocations));
+	RecordProperty("FirstFileAllocations", static_cast<int>(firstFileAllocations));
+	RecordProperty("InitAllocationsPerFile", static_cast<int>(initAllocations / (files - 1)));
+	RecordProperty("AllocationsPerFile", static_cast<int>(fileAllocations / (files - 1)));
+	EXPECT_GT(firstInitAllocations, 0U);
+	EXPECT_EQ(0U, initAllocations);
+}
+
+TEST(AllocationCount, NestedBenchmark)
+// Count the heap allocations and the time to format deeply nested code
+// with nested namespaces and lambdas in lambdas.
+{
+	const int depth = 40;
+	string textIn;
+	for (int i = 0; i < depth; i++)
+		textIn.append("namespace N" + to_string(i) + " {\n");
+	textIn.append("void foo() {\n");
+	for (int i = 0; i < depth; i++)
+		textIn.append("auto f" + to_string(i) + " = [&](int a) {\n"
+		              "if (a) { bar(a); } else { baz(a); }\n");
+	for (int i = 0; i < depth; i++)
+		textIn.append("};\n");
+	textIn.append("}\n");
+	for (int i = 0; i < depth; i++)
+		textIn.append("}\n");
+	const int files = 20;
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setNamespaceIndent(true);
+	size_t fileAllocations = 0;
+	string firstTextOut;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < files; i++)
+	{
+		string textOut;
+		ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+		formatter.init(&bufferIterator);
+		allocationCount = 0;
+		countAllocations = true;
+		while (formatter.hasMoreLines())
+			textOut.append(formatter.nextLine()).append("\n");
+		countAllocations = false;
+		if (i == 0)
+		{
+			firstTextOut = textOut;
+			continue;
+		}
+		fileAllocations += allocationCount;
+		EXPECT_EQ(firstTextOut, textOut);
+	}
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int formatTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - start).count());
+	RecordProperty("Depth", depth);
+	RecordProperty("AllocationsPerFile", static_cast<int>(fileAllocations / (files - 1)));
+	RecordProperty("FormatMicroseconds", formatTime);
+	// the innermost lambda is indented by the namespaces, the function, and the lambdas
+	EXPECT_NE(firstTextOut.find(string((depth * 2) * 4, ' ') + "bar(a);"), string::npos);
+}
+
+TEST(AllocationCount, PerCharacterBenchmark)
+// Count the heap allocations made by ASFormatter::nextLine() for each
+// character of a file with long names, pointers, references, and comments.
+// The allocations should be the input, trimmed, and output line copies,
+// and the growth of the beautifier stacks. The text is not copied to be parsed.
+{
+	string textIn =
+	    "#if defined(LONG_PREPROCESSOR_NAME)\n"
+	    "void formatterFunctionName(const std::string& referenceArgument, int* pointerArgument)\n"
+	    "{\n"
+	    "    // a comment with text\n"
+	    "    SomeLongClassName* pointerVariableName = getPointerVariableName(referenceArgument);\n"
+	    "    if (pointerVariableName != nullptr && *pointerArgument > 0)\n"
+	    "    {\n"
+	    "        int& referenceVariableName = pointerVariableName->memberVariableName;\n"
+	    "        referenceVariableName = *pointerArgument; /* block comment */\n"
+	    "    }\n"
+	    "}\n"
+	    "#endif\n";
+	const int files = 20;
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setPointerAlignment(PTR_ALIGN_TYPE);
+	size_t fileAllocations = 0;
+	size_t fileLines = 0;
+	string firstTextOut;
+	for (int i = 0; i < files; i++)
+	{
+		string textOut;
+		ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+		formatter.init(&bufferIterator);
+		allocationCount = 0;
+		countAllocations = true;
+		while (formatter.hasMoreLines())
+		{
+			textOut.append(formatter.nextLine()).append("\n");
+			if (i == 0)
+				fileLines++;
+		}
+		countAllocations = false;
+		if (i == 0)
+		{
+			firstTextOut = textOut;
+			continue;
+		}
+		fileAllocations += allocationCount;
+		EXPECT_EQ(firstTextOut, textOut);
+	}
+	size_t allocationsPerFile = fileAllocations / (files - 1);
+	RecordProperty("Characters", static_cast<int>(textIn.length()));
+	RecordProperty("AllocationsPerFile", static_cast<int>(allocationsPerFile));
+	RecordProperty("AllocationsPer1000Characters", static_cast<int>(allocationsPerFile * 1000 / textIn.length()));
+	EXPECT_NE(firstTextOut.find("SomeLongClassName* pointerVariableName"), string::npos);
+	EXPECT_LE(allocationsPerFile, fileLines * 6);
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASBase header index tests
+//----------------------------------------------------------------------------
+
+TEST(HeaderIndex, Benchmark)
+// Time findHeader and the linear scan it replaced for every word
+// in a large corpus, in each of the header vectors.
+{
+	vector<string> corpus = getHeaderCorpus();
+	HeaderFinder finder(C_TYPE);
+	vector<pair<const string*, int> > words;
+	for (const string& line : corpus)
+		for (size_t i = 0; i < line.length(); i++)
+			if (finder.isWordStart(line, i))
+				words.emplace_back(&line, static_cast<int>(i));
+	// find each word in each of the header vectors
+	size_t linearFound = 0;
+	size_t indexFound = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (const vector<const string*>* headers : finder.headerVectors)
+		for (const pair<const string*, int>& word : words)
+			if (finder.findHeaderLinear(*word.first, word.second, headers) != nullptr)
+				linearFound++;
+	chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+	for (const vector<const string*>* headers : finder.headerVectors)
+		for (const pair<const string*, int>& word : words)
+			if (finder.findHeaderIndex(*word.first, word.second, headers) != nullptr)
+				indexFound++;
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int linearTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(middle - start).count());
+	int indexTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - middle).count());
+	RecordProperty("Lookups", static_cast<int>(words.size() * finder.headerVectors.size()));
+	RecordProperty("LinearScanMicroseconds", linearTime);
+	RecordProperty("HeaderIndexMicroseconds", indexTime);
+	EXPECT_GT(indexFound, 0U);
+	EXPECT_EQ(linearFound, indexFound);
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASBase operator index tests
+//----------------------------------------------------------------------------
+
+TEST(OperatorIndex, Benchmark)
+// Time findOperator and the linear scan it replaced, starting at each
+// operator character of the corpus, with the three operator vectors.
+{
+	vector<string> corpus = getOperatorCorpus();
+	OperatorFinder finder(C_TYPE);
+	vector<pair<const string*, int> > operatorChars;
+	for (const string& line : corpus)
+		for (size_t i = 0; i < line.length(); i++)
+			if (finder.isOperatorStart(line, i))
+				operatorChars.emplace_back(&line, static_cast<int>(i));
+	// find each operator in each of the operator vectors
+	size_t linearFound = 0;
+	size_t indexFound = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (const vector<const string*>* operators : finder.operatorVectors)
+		for (const pair<const string*, int>& operatorChar : operatorChars)
+			if (finder.findOperatorLinear(*operatorChar.first, operatorChar.second, operators) != nullptr)
+				linearFound++;
+	chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+	for (const vector<const string*>* operators : finder.operatorVectors)
+		for (const pair<const string*, int>& operatorChar : operatorChars)
+			if (finder.findOperatorIndex(*operatorChar.first, operatorChar.second, operators) != nullptr)
+				indexFound++;
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int linearTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(middle - start).count());
+	int indexTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - middle).count());
+	RecordProperty("Lookups", static_cast<int>(operatorChars.size() * finder.operatorVectors.size()));
+	RecordProperty("LinearScanMicroseconds", linearTime);
+	RecordProperty("OperatorIndexMicroseconds", indexTime);
+	EXPECT_GT(indexFound, 0U);
+	EXPECT_EQ(linearFound, indexFound);
+}
+
+//----------------------------------------------------------------------------
+// AStyle character class table tests
+//----------------------------------------------------------------------------
+
+TEST(CharClass, Benchmark)
+// Time getCurrentWord with the character class table and with the
+// predicates it replaced, for each word of the operator corpus.
+{
+	vector<string> corpus = getOperatorCorpus();
+	CharClassifier classifier(C_TYPE);
+	vector<pair<const string*, size_t> > wordStarts;
+	for (const string& line : corpus)
+		for (size_t i = 0; i < line.length(); i++)
+			if (classifier.isLegalNameCharLinear(line[i])
+			        && (i == 0 || !classifier.isLegalNameCharLinear(line[i - 1])))
+				wordStarts.emplace_back(&line, i);
+	const int repeat = 20;
+	size_t linearLength = 0;
+	size_t tableLength = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+		for (const pair<const string*, size_t>& wordStart : wordStarts)
+			linearLength += classifier.getCurrentWordLinear(*wordStart.first, wordStart.second).length();
+	chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++)
+		for (const pair<const string*, size_t>& wordStart : wordStarts)
+			tableLength += classifier.getCurrentWordTable(*wordStart.first, wordStart.second).length();
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int linearTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(middle - start).count());
+	int tableTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - middle).count());
+	RecordProperty("Words", static_cast<int>(wordStarts.size() * repeat));
+	RecordProperty("PredicateMicroseconds", linearTime);
+	RecordProperty("CharClassTableMicroseconds", tableTime);
+	EXPECT_GT(tableLength, 0U);
+	EXPECT_EQ(linearLength, tableLength);
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASScanner tests
+//----------------------------------------------------------------------------
+
+vector<string> getSourceCorpus()
+// Return the lines of this source file, or the operator corpus if the
+// source is not available. The lines are repeated to make a large source.
+{
+	vector<string> corpus;
+	ifstream source(__FILE__);
+	string line;
+	while (getline(source, line))
+		corpus.emplace_back(line);
+	if (corpus.empty())
+		return getOperatorCorpus();
+	size_t sourceLines = corpus.size();
+	for (int i = 0; i < 9; i++)
+		corpus.insert(corpus.end(), corpus.begin(), corpus.begin() + sourceLines);
+	return corpus;
+}
+
+TEST(Scanner, Benchmark)
+// Time the scanners and the string functions on a real source.
+// Each line is searched from every syntax character to the end of the line.
+{
+	vector<string> corpus = getSourceCorpus();
+	size_t bytes = 0;
+	for (const string& line : corpus)
+		bytes += line.length();
+	size_t stringSum = 0;
+	size_t scannerSum = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (const string& line : corpus)
+	{
+		stringSum += line.find_first_not_of(" \t") + line.find_last_not_of(" \t") + line.find("*/");
+		for (size_t i = line.find_first_of("\"'/;{}"); i != string::npos; i = line.find_first_of("\"'/;{}", i + 1))
+			stringSum += i;
+	}
+	chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+	for (const string& line : corpus)
+	{
+		scannerSum += ASScanner::findNonBlank(line) + ASScanner::findLastNonBlank(line) + ASScanner::findCommentEnd(line);
+		for (size_t i = ASScanner::findSyntaxChar(line); i != string::npos; i = ASScanner::findSyntaxChar(line, i + 1))
+			scannerSum += i;
+	}
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int stringTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(middle - start).count());
+	int scannerTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - middle).count());
+	RecordProperty("Bytes", static_cast<int>(bytes));
+	RecordProperty("StringMicroseconds", stringTime);
+	RecordProperty("ScannerMicroseconds", scannerTime);
+	RecordProperty("StringBytesPerMicrosecond", static_cast<int>(bytes / max(stringTime, 1)));
+	RecordProperty("ScannerBytesPerMicrosecond", static_cast<int>(bytes / max(scannerTime, 1)));
+	EXPECT_GT(bytes, 0U);
+	EXPECT_EQ(stringSum, scannerSum);
+}
+
+//----------------------------------------------------------------------------
+
+}  // namespace
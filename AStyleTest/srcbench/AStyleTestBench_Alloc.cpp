@@ -0,0 +1,65 @@
+// AStyleTestBench_Alloc.cpp
+// Copyright (c) 2018 by Jim Pattee <jimp03@email.com>.
+// This code is licensed under the MIT License.
+// License.md describes the conditions under which this software may be distributed.
+
+// The replacement global operator new and delete that count the heap
+// allocations for AStyleTestBench. They are in a separate file so the
+// compiler cannot inline them into the new and delete expressions.
+// GCC warns about a mismatched malloc and free when they are inlined.
+
+//----------------------------------------------------------------------------
+// headers
+//----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+// global variables
+//----------------------------------------------------------------------------
+
+// heap allocation count for the AllocationCount tests
+// allocations are counted only while countAllocations is true
+// they are atomic because the formatter may be run by several threads
+atomic<size_t> allocationCount(0);
+atomic<bool> countAllocations(false);
+
+void* operator new(size_t size)
+{
+	if (countAllocations)
+		++allocationCount;
+	void* ptr = malloc(size > 0 ? size : 1);
+	if (ptr == nullptr)
+		throw bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+// sized deallocation is used by C++14 compilers
+void operator delete(void* ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
@@ -209,6 +209,78 @@ TEST(ProcessOptions, OtherOptions_Short)
 	EXPECT_TRUE(console->getPreserveDate());
 }
 
+TEST(ProcessOptions, CheckOption)
+// test processOptions for the check option
+// a check is also a dry run
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	EXPECT_FALSE(console->getIsCheck());
+	// set console options
+	vector<string> optionsIn;
+	optionsIn.push_back("--check");
+	console->processOptions(optionsIn);
+	// check console options
+	EXPECT_TRUE(console->getIsCheck());
+	EXPECT_TRUE(console->getIsDryRun());
+}
+
+TEST(ProcessOptions, JobsOption)
+// test processOptions for the jobs option
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	EXPECT_EQ(1, console->getNumJobs());
+	// set console options
+	vector<string> optionsIn;
+	optionsIn.push_back("--jobs=4");
+	console->processOptions(optionsIn);
+	// check console options
+	EXPECT_EQ(4, console->getNumJobs());
+}
+
+TEST(ProcessOptions, JobsOption_Processors)
+// test processOptions for the jobs option using the number of processors
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	// set console options
+	vector<string> optionsIn;
+	optionsIn.push_back("--jobs=0");
+	console->processOptions(optionsIn);
+	// check console options
+	EXPECT_GE(console->getNumJobs(), 1);
+}
+
+TEST(ProcessOptions, JobsOption_Error)
+// test processOptions for jobs option errors
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	// build optionsIn
+	vector<string> optionsIn;
+	optionsIn.push_back("--jobs=-1");
+	optionsIn.push_back("--jobs=257");
+	optionsIn.push_back("--jobs=");
+	optionsIn.push_back("--jobs=abc");
+	optionsIn.push_back("--jobs=4x");
+	optionsIn.push_back("--jobs=99999999999");
+	// cannot use death test with leak finder
+#if GTEST_HAS_DEATH_TEST && !(LEAK_DETECTOR || LEAK_FINDER)
+	// test processOptions with invalid jobs options
+	EXPECT_EXIT(console->processOptions(optionsIn),
+	            ExitedWithCode(EXIT_FAILURE),
+	            "Invalid command line options:\n"
+	            "\tjobs=-1\n"
+	            "\tjobs=257\n"
+	            "\tjobs=\n"
+	            "\tjobs=abc\n"
+	            "\tjobs=4x\n"
+	            "\tjobs=99999999999\n"
+	            "For help on options type 'astyle -h'");
+#endif
+}
+
 TEST(ProcessOptions, ConsoleOptions_Error)
 // test processOptions for command line options errors
 {
@@ -1960,6 +2032,128 @@ TEST(Checksum, CheckSumError)
 	EXPECT_TRUE(formatter.getChecksumDiff() == 0);
 }
 
+TEST_F(ChecksumF, VerifyAddBraces)
+// test the verify option with add-braces
+// the file must be written and the verify hashes must be the same
+{
+	ASSERT_TRUE(console != nullptr) << "Console object not initialized.";
+	console->setIsQuiet(true);		// change this to see results
+	console->setNoBackup(true);
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--verify");
+	astyleOptionsVector.push_back("--add-braces");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// call astyle processFiles()
+	console->processFiles();
+	// verify the file was formatted and written
+	EXPECT_FALSE(formatter.getVerifyFailed());
+	EXPECT_EQ(console->getFilesVerifyFailed(), 0);
+	EXPECT_EQ(console->getFilesFormatted(), 1);
+}
+
+TEST_F(ChecksumF, VerifyRemoveBraces)
+// test the verify option with add-one-line-braces and then remove-braces
+// the file must be written and the verify hashes must be the same
+{
+	ASSERT_TRUE(console != nullptr) << "Console object not initialized.";
+	console->setIsQuiet(true);		// change this to see results
+	console->setNoBackup(true);
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--verify");
+	astyleOptionsVector.push_back("--add-one-line-braces");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	console->processFiles();
+	EXPECT_FALSE(formatter.getVerifyFailed());
+	// remove the braces that were added
+	ASFormatter formatter2;
+	unique_ptr<ASConsole> console2(new ASConsole(formatter2));
+	console2->setIsQuiet(true);
+	console2->setNoBackup(true);
+	vector<string> astyleOptionsVector2;
+	astyleOptionsVector2.push_back("--verify");
+	astyleOptionsVector2.push_back("--remove-braces");
+	astyleOptionsVector2.push_back(getTestDirectory() + "/*.cpp");
+	console2->processOptions(astyleOptionsVector2);
+	console2->processFiles();
+	EXPECT_FALSE(formatter2.getVerifyFailed());
+	EXPECT_EQ(console2->getFilesVerifyFailed(), 0);
+	EXPECT_EQ(console2->getFilesFormatted(), 1);
+}
+
+TEST(Checksum, VerifyHash)
+// test the hash used by the verify option
+{
+	// white space and line ends are not hashed
+	EXPECT_EQ(ASFormatter::computeVerifyHash("a = b;"), ASFormatter::computeVerifyHash("a=b;"));
+	EXPECT_EQ(ASFormatter::computeVerifyHash("\t \t"), ASFormatter::computeVerifyHash(""));
+	EXPECT_EQ(ASFormatter::computeVerifyHash("if (a) { b; }"),
+	          ASFormatter::computeVerifyHash("if (a)\n{\n    b;\n}"));
+	// the hash depends on the order of the characters
+	EXPECT_NE(ASFormatter::computeVerifyHash("ab"), ASFormatter::computeVerifyHash("ba"));
+	EXPECT_NE(ASFormatter::computeVerifyHash("if (a) { b; }"),
+	          ASFormatter::computeVerifyHash("if (a) b; { }"));
+	EXPECT_NE(ASFormatter::computeVerifyHash("x = a;"), ASFormatter::computeVerifyHash("x = a;;"));
+	// a comment may be moved past the code, but not past another comment
+	EXPECT_EQ(ASFormatter::computeVerifyHash("if (a) { // comment\n    b;\n}"),
+	          ASFormatter::computeVerifyHash("if (a) // comment\n{\n    b;\n}"));
+	EXPECT_NE(ASFormatter::computeVerifyHash("a; // one\nb; // two"),
+	          ASFormatter::computeVerifyHash("a; // two\nb; // one"));
+	// the stars in a block comment are not hashed
+	EXPECT_EQ(ASFormatter::computeVerifyHash("/*\n * text *\n */"),
+	          ASFormatter::computeVerifyHash("/*\n   text\n*/"));
+	// comment characters in quotes are code
+	EXPECT_EQ(ASFormatter::computeVerifyHash("s = \"// a\"; {"),
+	          ASFormatter::computeVerifyHash("s = \"// a\";\n{"));
+	EXPECT_EQ(ASFormatter::computeVerifyHash("n = 1'000; { // c"),
+	          ASFormatter::computeVerifyHash("n = 1'000; // c\n{"));
+	EXPECT_EQ(ASFormatter::computeVerifyHash("s = u8R\"x(a\")x\"; { // c"),
+	          ASFormatter::computeVerifyHash("s = u8R\"x(a\")x\"; // c\n{"));
+}
+
+TEST(Checksum, VerifyMovedBrace)
+// test that the verify hash finds a brace moved in the formatted output
+{
+	string textIn =
+	    "void foo()\n"
+	    "{\n"
+	    "    if (isFoo) { // comment\n"
+	    "        bar();\n"
+	    "    }\n"
+	    "}";
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setVerifyMode(true);
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	vector<string> linesOut;
+	while (formatter.hasMoreLines())
+		linesOut.emplace_back(formatter.nextLine());
+	// the formatter moves the opening brace after the comment
+	EXPECT_FALSE(formatter.getVerifyFailed());
+	ASSERT_EQ(linesOut.size(), 7U);
+	ASSERT_EQ(linesOut[3], "    {");
+	// the input and the output have the same hash
+	ASVerifyHash hashIn;
+	ASVerifyHash hashOut;
+	stringstream in(textIn);
+	string lineIn;
+	while (getline(in, lineIn))
+		hashIn.addLine(lineIn);
+	for (const string& line : linesOut)
+		hashOut.addLine(line);
+	EXPECT_TRUE(hashIn == hashOut);
+	// the brace moved after the call
+	swap(linesOut[3], linesOut[4]);
+	ASVerifyHash movedHashOut;
+	for (const string& line : linesOut)
+		movedHashOut.addLine(line);
+	EXPECT_TRUE(hashIn != movedHashOut);
+}
+
 //----------------------------------------------------------------------------
 // AStyle ASResource operator vectors sequence
 //----------------------------------------------------------------------------
@@ -529,6 +529,213 @@ TEST_F(GetFileTypeF, FileTypeError)
 	EXPECT_EQ(C_TYPE, formatter.getFileType());
 }
 
+//----------------------------------------------------------------------------
+// AStyle test the cache= option
+//----------------------------------------------------------------------------
+
+struct CacheF : public Test
+{
+	string cacheFileName;
+	vector<string> fileNames;
+	int cacheHits;
+	int cacheMisses;
+	int filesFormatted;
+
+	// build fileNames vector and write the output files
+	CacheF()
+	{
+		char textFormatted[] =
+		    "\nvoid foo()\n"
+		    "{\n"
+		    "bar();\n"
+		    "}\n";
+		char textUnchanged[] =
+		    "\nvoid foo()\n"
+		    "{\n"
+		    "    bar();\n"
+		    "}\n";
+		cleanTestDirectory(getTestDirectory());
+		cacheFileName = getTestDirectory() + "/astyle.cache";
+		fileNames.push_back(getTestDirectory() + "/fileFormatted.cpp");
+		createTestFile(fileNames.back(), textFormatted);
+		fileNames.push_back(getTestDirectory() + "/fileUnchanged.cpp");
+		createTestFile(fileNames.back(), textUnchanged);
+		cacheHits = 0;
+		cacheMisses = 0;
+		filesFormatted = 0;
+	}
+
+	// format the files with a new console and save the counts
+	void runAStyle(const vector<string>& options)
+	{
+		ASFormatter formatter;
+		unique_ptr<ASConsole> console(new ASConsole(formatter));
+		console->setIsQuiet(true);		// change this to see results
+		vector<string> astyleOptionsVector(options);
+		astyleOptionsVector.push_back("--cache=" + cacheFileName);
+		astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+		console->processOptions(astyleOptionsVector);
+		console->processFiles();
+		cacheHits = console->getCacheHits();
+		cacheMisses = console->getCacheMisses();
+		filesFormatted = console->getFilesFormatted();
+	}
+};
+
+TEST_F(CacheF, CacheOption)
+// test processOptions for the cache option
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	EXPECT_TRUE(console->getCacheFileName().empty());
+	vector<string> optionsIn;
+	optionsIn.push_back("--cache=" + cacheFileName);
+	console->processOptions(optionsIn);
+	EXPECT_EQ(cacheFileName, console->getCacheFileName());
+}
+
+TEST_F(CacheF, CacheHits)
+// test that the files are skipped when they have not changed
+{
+	vector<string> options;
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(2, cacheMisses);
+	EXPECT_EQ(1, filesFormatted);
+	// the second run should not format anything
+	runAStyle(options);
+	EXPECT_EQ(2, cacheHits);
+	EXPECT_EQ(0, cacheMisses);
+	EXPECT_EQ(0, filesFormatted);
+}
+
+TEST_F(CacheF, CacheHitsWithJobs)
+// test the cache with files formatted concurrently
+{
+	vector<string> options;
+	options.push_back("--jobs=2");
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(2, cacheMisses);
+	EXPECT_EQ(1, filesFormatted);
+	runAStyle(options);
+	EXPECT_EQ(2, cacheHits);
+	EXPECT_EQ(0, cacheMisses);
+	EXPECT_EQ(0, filesFormatted);
+}
+
+TEST_F(CacheF, CacheModifiedFile)
+// test that a file changed after it was cached is formatted
+{
+	char textModified[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "baz();\n"
+	    "}\n";
+	vector<string> options;
+	runAStyle(options);
+	createTestFile(fileNames[1], textModified);
+	runAStyle(options);
+	EXPECT_EQ(1, cacheHits);
+	EXPECT_EQ(1, cacheMisses);
+	EXPECT_EQ(1, filesFormatted);
+}
+
+TEST_F(CacheF, CacheModifiedFileSameSize)
+// test that a file changed to the same size in the same second is formatted
+// the contents must be checked
+{
+	char textModified[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "    baz();\n"
+	    "}\n";
+	vector<string> options;
+	runAStyle(options);
+	createTestFile(fileNames[1], textModified);
+	runAStyle(options);
+	EXPECT_EQ(1, cacheHits);
+	EXPECT_EQ(1, cacheMisses);
+	EXPECT_EQ(0, filesFormatted);
+}
+
+TEST_F(CacheF, CacheOptionsChanged)
+// test that all files are formatted when the options change
+{
+	vector<string> options;
+	runAStyle(options);
+	options.push_back("--indent=spaces=4");
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(2, cacheMisses);
+	EXPECT_EQ(0, filesFormatted);
+}
+
+TEST_F(CacheF, CacheConsoleOptionsChanged)
+// test that the options that do not change the formatting keep the cache
+// the short options may be combined with a formatting option
+{
+	vector<string> options;
+	options.push_back("-s4");
+	runAStyle(options);
+	options.clear();
+	options.push_back("-s4QZ");
+	options.push_back("--jobs=2");
+	options.push_back("--dry-run");
+	runAStyle(options);
+	EXPECT_EQ(2, cacheHits);
+	EXPECT_EQ(0, cacheMisses);
+	// a changed formatting option in a combined option is not ignored
+	options[0] = "-s2QZ";
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(2, cacheMisses);
+}
+
+TEST_F(CacheF, CacheDryRun)
+// test that a file that would be formatted by a dry run is not cached
+{
+	vector<string> options;
+	options.push_back("--dry-run");
+	runAStyle(options);
+	EXPECT_EQ(1, filesFormatted);
+	runAStyle(options);
+	EXPECT_EQ(1, cacheHits);
+	EXPECT_EQ(1, cacheMisses);
+	EXPECT_EQ(1, filesFormatted);
+}
+
+TEST_F(CacheF, CacheVerify)
+// test that the cache is not used with the verify option
+// the files must be formatted to be verified
+{
+	vector<string> options;
+	runAStyle(options);
+	options.push_back("--verify");
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(0, cacheMisses);
+	EXPECT_EQ(0, filesFormatted);
+	// the cache is not changed by the verify
+	options.clear();
+	runAStyle(options);
+	EXPECT_EQ(2, cacheHits);
+	EXPECT_EQ(0, cacheMisses);
+}
+
+TEST_F(CacheF, CacheFileError)
+// test that an invalid cache file is ignored
+{
+	char textCache[] = "not an astyle cache\n";
+	createTestFile(cacheFileName, textCache);
+	vector<string> options;
+	runAStyle(options);
+	EXPECT_EQ(0, cacheHits);
+	EXPECT_EQ(2, cacheMisses);
+	runAStyle(options);
+	EXPECT_EQ(2, cacheHits);
+}
+
 //----------------------------------------------------------------------------
 // AStyle Language Vectors
 //----------------------------------------------------------------------------
@@ -664,6 +871,37 @@ TEST(LanguageVectors, MultipleObjects)
 #endif
 }
 
+TEST(LanguageVectors, SharedVectors)
+// The language vectors are built once per process for each file type
+// and are shared by all ASFormatter objects.
+// Check that they are the same object and have the same content
+// as the vectors built by ASResource.
+{
+	ASResource resource;
+	const int fileTypes[] = { C_TYPE, JAVA_TYPE, SHARP_TYPE };
+	for (int fileType : fileTypes)
+	{
+		const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+		EXPECT_EQ(&languageVectors, &ASLanguageVectors::getLanguageVectors(fileType));
+		vector<const string*> headers;
+		resource.buildHeaders(&headers, fileType, true);
+		EXPECT_TRUE(headers == languageVectors.beautifierHeaders);
+		vector<const string*> formatterHeaders;
+		resource.buildHeaders(&formatterHeaders, fileType);
+		EXPECT_TRUE(formatterHeaders == languageVectors.formatterHeaders);
+		vector<const string*> operators;
+		resource.buildOperators(&operators, fileType);
+		EXPECT_TRUE(operators == languageVectors.operators);
+		vector<const string*> preCommandHeaders;
+		resource.buildPreCommandHeaders(&preCommandHeaders, fileType);
+		EXPECT_TRUE(preCommandHeaders == languageVectors.preCommandHeaders);
+	}
+	EXPECT_NE(&ASLanguageVectors::getLanguageVectors(C_TYPE),
+	          &ASLanguageVectors::getLanguageVectors(JAVA_TYPE));
+	EXPECT_NE(&ASLanguageVectors::getLanguageVectors(C_TYPE),
+	          &ASLanguageVectors::getLanguageVectors(SHARP_TYPE));
+}
+
 //----------------------------------------------------------------------------
 // AStyle test recursive option - getFilePaths(), wildcmp(), and fileName vector
 //----------------------------------------------------------------------------
@@ -995,6 +1233,124 @@ TEST_F(DryRunF, DryRunSans)
 	}
 }
 
+TEST_F(DryRunF, CheckTest)
+// Test check option.
+// The files should be reported as formatted but NOT changed.
+{
+	console->setIsQuiet(true);		// change this to see results
+	// set the formatter options
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	astyleOptionsVector.push_back("--style=attach");
+	astyleOptionsVector.push_back("--check");
+	// process the file
+	console->processOptions(astyleOptionsVector);
+	console->processFiles();
+	EXPECT_EQ(2, console->getFilesFormatted());
+	// check that the files were not changed
+	vector<string> fileName = console->getFileName();
+	ASSERT_EQ(fileNames.size(), fileName.size());
+	for (size_t i = 0; i < fileNames.size(); i++)
+	{
+		EXPECT_EQ(fileNames[i], fileName[i]);
+		// check for .orig file
+		string origFileName = fileNames[i] + ".orig";
+		struct stat stBuf;
+		// display error if file is present
+		if (stat(origFileName.c_str(), &stBuf) != -1)
+			EXPECT_STREQ("no .orig file", origFileName.c_str());
+	}
+}
+
+TEST_F(DryRunF, CheckLineNumber)
+// Test check option line number.
+// The line number is the first changed input line,
+// even if the formatter has read the following lines.
+{
+	char textIn[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "    bar();\n"
+	    "\n"
+	    "    baz();\n"
+	    "}\n";
+	string fileName = getTestDirectory() + "/check-line.cpp";
+	createTestFile(fileName, textIn);
+	const char* options[] = { "--style=attach", "--delete-empty-lines" };
+	const int changedLine[] = { 2, 5 };
+	for (int i = 0; i < 2; i++)
+	{
+		ASFormatter checkFormatter;
+		unique_ptr<ASConsole> checkConsole(new ASConsole(checkFormatter));
+		checkConsole->setIsQuiet(true);		// change this to see results
+		vector<string> astyleOptionsVector;
+		astyleOptionsVector.push_back(fileName);
+		astyleOptionsVector.push_back(options[i]);
+		astyleOptionsVector.push_back("--check");
+		checkConsole->processOptions(astyleOptionsVector);
+		checkConsole->processFiles();
+		EXPECT_EQ(1, checkConsole->getFilesFormatted()) << options[i];
+		EXPECT_EQ(changedLine[i], checkConsole->getChangedLine()) << options[i];
+	}
+}
+
+TEST_F(DryRunF, CheckStdin)
+// Test check option with standard input.
+// The result must be in the file count and nothing written to stdout.
+{
+	string outFileName = getTestDirectory() + "/check-stdout.cpp";
+	const char* styles[] = { "--style=attach", "--style=allman" };
+	for (int i = 0; i < 2; i++)
+	{
+		ASFormatter checkFormatter;
+		unique_ptr<ASConsole> checkConsole(new ASConsole(checkFormatter));
+		checkConsole->setIsQuiet(true);		// change this to see results
+		vector<string> astyleOptionsVector;
+		astyleOptionsVector.push_back("--stdin=" + fileNames[0]);
+		astyleOptionsVector.push_back("--stdout=" + outFileName);
+		astyleOptionsVector.push_back(styles[i]);
+		astyleOptionsVector.push_back("--check");
+		checkConsole->processOptions(astyleOptionsVector);
+		// cannot use death test with leak finder
+#if GTEST_HAS_DEATH_TEST && !(LEAK_DETECTOR || LEAK_FINDER)
+		// stdin and stdout are reopened, so this must run in a child process
+		// the exit code is the number of files formatted
+		int filesFormatted = (i == 0) ? 1 : 0;
+		EXPECT_EXIT({ checkConsole->formatCinToCout(); exit(checkConsole->getFilesFormatted()); },
+		            ExitedWithCode(filesFormatted), "") << styles[i];
+		// the formatted text must not be written
+		struct stat stBuf;
+		ASSERT_EQ(0, stat(outFileName.c_str(), &stBuf)) << styles[i];
+		EXPECT_EQ(0, stBuf.st_size) << styles[i];
+#endif
+	}
+}
+
+TEST_F(DryRunF, VerifyStdin)
+// Test verify option with standard input.
+// The output is held until the verify is done, then written to stdout.
+{
+	string outFileName = getTestDirectory() + "/verify-stdout.cpp";
+	console->setIsQuiet(true);		// change this to see results
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--stdin=" + fileNames[0]);
+	astyleOptionsVector.push_back("--stdout=" + outFileName);
+	astyleOptionsVector.push_back("--style=attach");
+	astyleOptionsVector.push_back("--verify");
+	console->processOptions(astyleOptionsVector);
+	// cannot use death test with leak finder
+#if GTEST_HAS_DEATH_TEST && !(LEAK_DETECTOR || LEAK_FINDER)
+	// stdin and stdout are reopened, so this must run in a child process
+	EXPECT_EXIT({ console->formatCinToCout(); exit(EXIT_SUCCESS); },
+	            ExitedWithCode(EXIT_SUCCESS), "");
+	// the formatted text must be written
+	ifstream fin(outFileName.c_str(), ios::binary);
+	ASSERT_TRUE(fin.is_open());
+	string textOut((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+	EXPECT_EQ("\nvoid foo() {\n    bar();\n}\n", textOut);
+#endif
+}
+
 //----------------------------------------------------------------------------
 // AStyle line ends formatted
 // tests if a line end change formats the file
@@ -1488,6 +1844,88 @@ TEST_F(LineEndsDefaultMixedF, LineEndMacOld)
 //	systemPause("Check MacOld Line Ends");
 }
 
+TEST_F(LineEndsDefaultMixedF, LineEndsWithJobs)
+// test that the worker line end results are merged into the console
+{
+	console->setIsQuiet(true);		// change this to see results
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--jobs=2");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// call astyle processFiles()
+	console->processFiles();
+	ASSERT_EQ(3U, console->getFileName().size());
+	// the results of the last file are kept, the same as one job
+	EXPECT_TRUE(console->getLineEndsMixed());
+	EXPECT_FALSE(console->getFilesAreIdentical());
+	EXPECT_EQ(3, console->getFilesFormatted());
+}
+
+TEST(FormatFilesConcurrently, FileError)
+// test a file that cannot be formatted by a worker thread
+// the error is reported by the main thread after the other files are done
+{
+	char textIn[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "bar();\n"
+	    "}\n";
+	// a UTF-32 BOM cannot be processed
+	char textUtf32[] = "\xFF\xFE\x00\x00\x61\x00\x00\x00";
+	cleanTestDirectory(getTestDirectory());
+	string fileName1 = getTestDirectory() + "/fileError1.cpp";
+	string fileName2 = getTestDirectory() + "/fileError2.cpp";
+	string fileName3 = getTestDirectory() + "/fileError3.cpp";
+	createTestFile(fileName1, textIn);
+	createTestFile(fileName2, textUtf32, sizeof(textUtf32) - 1);
+	createTestFile(fileName3, textIn);
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	console->setIsQuiet(true);		// change this to see results
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--ascii");
+	astyleOptionsVector.push_back("--suffix=none");
+	astyleOptionsVector.push_back("--jobs=2");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// cannot use death test with leak finder
+#if GTEST_HAS_DEATH_TEST && !(LEAK_DETECTOR || LEAK_FINDER)
+	EXPECT_EXIT(console->processFiles(),
+	            ExitedWithCode(EXIT_FAILURE),
+	            "Cannot process UTF-32 encoding .*fileError2.cpp\n"
+	            "Artistic Style has terminated");
+	// the other files have been formatted
+	ifstream fin(fileName3.c_str(), ios::binary);
+	string textOut((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+	EXPECT_EQ("\nvoid foo()\n{\n    bar();\n}\n", textOut);
+#endif
+}
+
+TEST(ConvertLineEnds, AllLineEnds)
+// test convertLineEnds() converting mixed line ends in place
+{
+	ASFormatter formatter;
+	unique_ptr<ASConsole> console(new ASConsole(formatter));
+	const string textIn = "\rvoid foo()\r\n{\n    bar1()\r    bar2()\n\r}\r";
+	// windows
+	string textOut = textIn;
+	console->convertLineEnds(textOut, LINEEND_WINDOWS);
+	EXPECT_EQ("\r\nvoid foo()\r\n{\r\n    bar1()\r\n    bar2()\r\n\r\n}\r\n", textOut);
+	// linux
+	textOut = textIn;
+	console->convertLineEnds(textOut, LINEEND_LINUX);
+	EXPECT_EQ("\nvoid foo()\n{\n    bar1()\n    bar2()\n\n}\n", textOut);
+	// macold
+	textOut = textIn;
+	console->convertLineEnds(textOut, LINEEND_MACOLD);
+	EXPECT_EQ("\rvoid foo()\r{\r    bar1()\r    bar2()\r\r}\r", textOut);
+	// no change
+	textOut = "\r\nvoid foo()\r\n";
+	console->convertLineEnds(textOut, LINEEND_WINDOWS);
+	EXPECT_EQ("\r\nvoid foo()\r\n", textOut);
+}
+
 //----------------------------------------------------------------------------
 // AStyle line ends formatted
 // tests that default line ends does NOT call the convertLineEnds() function when not needed
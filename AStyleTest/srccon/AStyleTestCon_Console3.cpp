@@ -15,6 +15,7 @@
 
 //#include <algorithm>
 #include "AStyleTestCon.h"
+#include "AStyleTestCon_Reference.h"
 #ifdef _WIN32
 	#include <windows.h>
 #else
@@ -425,6 +426,938 @@ TEST_F(ProcessMiscOptions3F, HtmlOption_InvalidFileName)
 #endif
 }
 
+//----------------------------------------------------------------------------
+// AStyle ASBufferIterator tests
+//----------------------------------------------------------------------------
+
+void compareBufferIterator(const string& textIn, ASBufferIterator& bufferIterator)
+// Compare an ASBufferIterator to an ASStreamIterator for the same input.
+// The lines, stream positions, and line ends must be the same.
+{
+	stringstream in(textIn);
+	ASStreamIterator<stringstream> streamIterator(&in);
+	int lineNum = 0;
+	while (streamIterator.hasMoreLines())
+	{
+		ASSERT_TRUE(bufferIterator.hasMoreLines()) << "line " << lineNum;
+		// peek two lines ahead if not at the beginning
+		if (lineNum > 0)
+		{
+			for (int i = 0; i < 2 && streamIterator.hasMoreLines(); i++)
+			{
+				EXPECT_EQ(streamIterator.peekNextLine(), bufferIterator.peekNextLine());
+				EXPECT_EQ(streamIterator.tellg(), bufferIterator.tellg());
+				EXPECT_EQ(streamIterator.hasMoreLines(), bufferIterator.hasMoreLines());
+			}
+			streamIterator.peekReset();
+			bufferIterator.peekReset();
+		}
+		EXPECT_EQ(streamIterator.nextLine(false), bufferIterator.nextLine(false)) << "line " << lineNum;
+		EXPECT_EQ(streamIterator.tellg(), bufferIterator.tellg()) << "line " << lineNum;
+		EXPECT_EQ(streamIterator.getOutputEOL(), bufferIterator.getOutputEOL()) << "line " << lineNum;
+		lineNum++;
+	}
+	EXPECT_FALSE(bufferIterator.hasMoreLines());
+	EXPECT_EQ(streamIterator.getStreamLength(), bufferIterator.getStreamLength());
+	for (int lineEnd = LINEEND_DEFAULT; lineEnd <= LINEEND_MACOLD; lineEnd++)
+		EXPECT_EQ(streamIterator.getLineEndChange(lineEnd), bufferIterator.getLineEndChange(lineEnd));
+}
+
+void compareBufferIterator(const string& textIn)
+// Compare a buffer and a stream read in small blocks to an ASStreamIterator.
+// The small blocks split the line ends between reads.
+{
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	compareBufferIterator(textIn, bufferIterator);
+	for (size_t blockSize = 1; blockSize <= 3; blockSize++)
+	{
+		stringstream in(textIn);
+		ASBufferIterator pipeIterator(&in, blockSize);
+		compareBufferIterator(textIn, pipeIterator);
+	}
+}
+
+TEST(BufferIterator, LineEnds)
+// test ASBufferIterator with the different line ends
+{
+	compareBufferIterator("void foo()\n{\n    bar();\n}\n");
+	compareBufferIterator("void foo()\r\n{\r\n    bar();\r\n}\r\n");
+	compareBufferIterator("void foo()\r{\r    bar();\r}\r");
+	compareBufferIterator("void foo()\n\r{\n\r    bar();\n\r}\n\r");
+	compareBufferIterator("void foo()\r\n{\r    bar();\n\n\r\r}\n");
+}
+
+TEST(BufferIterator, EndOfBuffer)
+// test ASBufferIterator at the end of the buffer
+{
+	compareBufferIterator("");
+	compareBufferIterator("\n");
+	compareBufferIterator("\r");
+	compareBufferIterator("\r\n");
+	compareBufferIterator("a");
+	compareBufferIterator("void foo()\n{\n    bar();\n}");
+	compareBufferIterator("void foo()\n\n\n");
+}
+
+TEST(BufferIterator, PeekCache)
+// Benchmark the bytes re-read by the look-ahead in ASFormatter.
+// An ASStreamIterator reads the peeked bytes again after peekReset().
+// The ASBufferIterator line cache must split each byte only once.
+{
+	// preprocessor blocks and comments between the headers and braces
+	string block =
+	    "#ifdef FOO\n"
+	    "// comment 1\n"
+	    "// comment 2\n"
+	    "#ifdef BAR\n"
+	    "int a;\n"
+	    "#endif\n"
+	    "#endif\n"
+	    "\n"
+	    "void foo()\n"
+	    "// comment 3\n"
+	    "{\n"
+	    "    if (isFoo)\n"
+	    "    /* comment 4\n"
+	    "       comment 5 */\n"
+	    "    {\n"
+	    "        bar();\n"
+	    "    }\n"
+	    "}\n"
+	    "\n";
+	string textIn;
+	for (int i = 0; i < 100; i++)
+		textIn.append(block);
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setBreakBlocksMode(true);
+	formatter.setPreprocBlockIndent(true);
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	while (formatter.hasMoreLines())
+		formatter.nextLine();
+	// report the bytes re-read per file
+	size_t bytesReread = bufferIterator.getBytesSplit() - textIn.length();
+	RecordProperty("FileBytes", static_cast<int>(textIn.length()));
+	RecordProperty("StreamBytesReread", static_cast<int>(bufferIterator.getBytesPeeked()));
+	RecordProperty("BufferBytesReread", static_cast<int>(bytesReread));
+	// the look-ahead must have been used
+	EXPECT_GT(bufferIterator.getBytesPeeked(), textIn.length() / 2);
+	EXPECT_EQ(0U, bytesReread);
+}
+
+TEST(BufferIterator, StreamWindow)
+// A stream is read in blocks as the lines are needed.
+// The output must be the same as a buffer and the data kept must be
+// bounded by the look-ahead, not by the length of the input.
+{
+	string block =
+	    "#ifdef FOO\n"
+	    "// comment 1\n"
+	    "#endif\n"
+	    "\n"
+	    "void foo()\n"
+	    "// comment 2\n"
+	    "{\n"
+	    "    if (isFoo)\n"
+	    "    {\n"
+	    "        bar();\n"
+	    "    }\n"
+	    "}\n"
+	    "\n";
+	string textIn;
+	for (int i = 0; i < 2000; i++)
+		textIn.append(block);
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setBreakBlocksMode(true);
+	formatter.setPreprocBlockIndent(true);
+	// format from the buffer
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	vector<string> bufferLines;
+	while (formatter.hasMoreLines())
+		bufferLines.emplace_back(formatter.nextLine());
+	// format from the stream
+	const size_t blockSize = 1024;
+	stringstream in(textIn);
+	ASBufferIterator pipeIterator(&in, blockSize);
+	formatter.init(&pipeIterator);
+	vector<string> pipeLines;
+	bool isFirstLineEarly = false;
+	while (formatter.hasMoreLines())
+	{
+		pipeLines.emplace_back(formatter.nextLine());
+		if (pipeLines.size() == 1)
+			isFirstLineEarly = (in.tellg() > 0 && in.tellg() <= static_cast<streamoff>(blockSize));
+	}
+	EXPECT_TRUE(bufferLines == pipeLines);
+	EXPECT_TRUE(isFirstLineEarly);
+	EXPECT_LT(pipeIterator.getWindowCapacity(), 8 * blockSize);
+	EXPECT_GT(textIn.length(), 100 * blockSize);
+}
+
+class SlowPipeBuffer : public streambuf
+// A stream buffer that gives one line for each read, like a pipe that is
+// written one line at a time. The next line is not available until the
+// previous one has been read.
+{
+public:
+	explicit SlowPipeBuffer(const vector<string>& pipeLines) : lines(pipeLines), linesRead(0) {}
+	size_t getLinesRead() const { return linesRead; }
+
+protected:
+	int_type underflow()
+	{
+		if (linesRead == lines.size())
+			return traits_type::eof();
+		line = lines[linesRead++];
+		setg(&line[0], &line[0], &line[0] + line.length());
+		return traits_type::to_int_type(line[0]);
+	}
+
+private:
+	vector<string> lines;
+	string line;
+	size_t linesRead;
+};
+
+TEST(BufferIterator, SlowPipe)
+// A read of a stream does not wait for a full block.
+// The first line must be formatted before the pipe has written all of the lines.
+{
+	vector<string> lines;
+	for (int i = 0; i < 100; i++)
+	{
+		lines.emplace_back("void foo" + to_string(i) + "()\n");
+		lines.emplace_back("{\n");
+		lines.emplace_back("bar();\n");
+		lines.emplace_back("}\n");
+	}
+	string textIn;
+	for (const string& line : lines)
+		textIn.append(line);
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	// format from the buffer
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	vector<string> bufferLines;
+	while (formatter.hasMoreLines())
+		bufferLines.emplace_back(formatter.nextLine());
+	// format from the pipe
+	SlowPipeBuffer pipeBuffer(lines);
+	istream in(&pipeBuffer);
+	ASBufferIterator pipeIterator(&in);
+	formatter.init(&pipeIterator);
+	vector<string> pipeLines;
+	size_t linesReadForFirstLine = 0;
+	while (formatter.hasMoreLines())
+	{
+		pipeLines.emplace_back(formatter.nextLine());
+		if (pipeLines.size() == 1)
+			linesReadForFirstLine = pipeBuffer.getLinesRead();
+	}
+	EXPECT_TRUE(bufferLines == pipeLines);
+	EXPECT_LT(linesReadForFirstLine, 10U);
+	EXPECT_EQ(lines.size(), pipeBuffer.getLinesRead());
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASMappedFile tests
+//----------------------------------------------------------------------------
+
+TEST(MappedFile, RegularFileAndDevice)
+// A regular file is mapped, a device is read.
+// The data must be the same as the file.
+{
+	char textIn[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "    bar();\n"
+	    "}\n";
+	cleanTestDirectory(getTestDirectory());
+	string fileName = getTestDirectory() + "/mapped-file.cpp";
+	createTestFile(fileName, textIn);
+	ASMappedFile in;
+	ASSERT_TRUE(in.open(fileName));
+	EXPECT_EQ(string(textIn), string(in.getData(), in.getSize()));
+	// an empty device cannot be mapped
+#ifndef _WIN32
+	ASSERT_TRUE(in.open("/dev/null"));
+	EXPECT_EQ(0U, in.getSize());
+#endif
+	// a missing file
+	EXPECT_FALSE(in.open(getTestDirectory() + "/no-file.cpp"));
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASCheckpoint tests
+//----------------------------------------------------------------------------
+
+vector<string> formatRemainingLines(ASFormatter& formatter, size_t maxLines = string::npos)
+// Return the lines output by a formatter until the end of the input,
+// or until 'maxLines' lines have been output.
+{
+	vector<string> lines;
+	while (formatter.hasMoreLines() && lines.size() < maxLines)
+	{
+		lines.emplace_back(formatter.nextLine());
+		if (!formatter.hasMoreLines() && formatter.getIsLineReady())
+			lines.emplace_back(formatter.nextLine());
+	}
+	return lines;
+}
+
+void compareCheckpoints(const string& textIn, int interval)
+// Take a checkpoint every 'interval' lines and resume formatting from each one.
+// The resumed lines must be the same as the lines from the original formatter.
+{
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setBreakBlocksMode(true);
+	formatter.setSwitchIndent(true);
+	formatter.setPreprocDefineIndent(true);
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	vector<string> linesOut;
+	vector<unique_ptr<ASCheckpoint>> checkpoints;
+	while (formatter.hasMoreLines())
+	{
+		if (linesOut.size() % interval == 0)
+			checkpoints.emplace_back(new ASCheckpoint(formatter, static_cast<int>(linesOut.size())));
+		linesOut.emplace_back(formatter.nextLine());
+		if (!formatter.hasMoreLines() && formatter.getIsLineReady())
+			linesOut.emplace_back(formatter.nextLine());
+	}
+	ASSERT_FALSE(checkpoints.empty());
+	for (const unique_ptr<ASCheckpoint>& checkpoint : checkpoints)
+	{
+		ASBufferIterator resumeIterator(textIn.c_str(), textIn.length());
+		resumeIterator.seekg(checkpoint->getStreamPosition());
+		unique_ptr<ASFormatter> resumed(checkpoint->resumeFormatter(&resumeIterator));
+		vector<string> resumedLines = formatRemainingLines(*resumed);
+		vector<string> expectedLines(linesOut.begin() + checkpoint->getLineNumber(), linesOut.end());
+		EXPECT_EQ(expectedLines, resumedLines) << "checkpoint " << checkpoint->getLineNumber();
+	}
+}
+
+TEST(Checkpoint, ResumeEveryLine)
+// test resuming from a checkpoint at every line
+// the preprocessor conditionals have waiting and active beautifiers
+{
+	string textIn =
+	    "#ifdef __cplusplus\n"
+	    "extern \"C\" {\n"
+	    "#endif\n"
+	    "#define FOO(a) \\\n"
+	    "    if (a) \\\n"
+	    "        bar();\n"
+	    "\n"
+	    "class Foo {\n"
+	    "public:\n"
+	    "    void foo(int a) {\n"
+	    "        switch (a) {\n"
+	    "        case 1:\n"
+	    "            /* comment\n"
+	    "               continued */\n"
+	    "#if FOO\n"
+	    "            if (isFoo) {\n"
+	    "                bar(\"string\",\n"
+	    "                    a);\n"
+	    "#else\n"
+	    "            if (isBar) {\n"
+	    "                baz();\n"
+	    "#endif\n"
+	    "            }\n"
+	    "            break;\n"
+	    "        }\n"
+	    "    }\n"
+	    "};\n"
+	    "#ifdef __cplusplus\n"
+	    "}\n"
+	    "#endif\n";
+	compareCheckpoints(textIn, 1);
+}
+
+TEST(Checkpoint, ResumeInterval)
+// test resuming from checkpoints taken every K lines
+// the last line does not have a line end
+{
+	string block =
+	    "void foo()\r\n"
+	    "{\r\n"
+	    "    if (isFoo)\r\n"
+	    "    {\r\n"
+	    "        bar();\r\n"
+	    "    }\r\n"
+	    "}\r\n";
+	string textIn;
+	for (int i = 0; i < 20; i++)
+		textIn.append(block);
+	textIn.append("int a;");
+	compareCheckpoints(textIn, 7);
+}
+
+TEST(Checkpoint, DeleteFormatter)
+// test that a checkpoint can be resumed after the formatter is deleted
+{
+	string textIn =
+	    "namespace FooName {\n"
+	    "void foo() {\n"
+	    "    bar();\n"
+	    "}\n"
+	    "}\n";
+	string textOut =
+	    "void foo()\n"
+	    "{\n"
+	    "    bar();\n"
+	    "}\n"
+	    "}\n"
+	    "\n";
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	unique_ptr<ASFormatter> formatter(new ASFormatter);
+	formatter->setFormattingStyle(STYLE_KR);
+	formatter->init(&bufferIterator);
+	formatter->nextLine();
+	formatter->nextLine();
+	unique_ptr<ASCheckpoint> checkpoint(new ASCheckpoint(*formatter, 2));
+	formatter.reset();
+	ASBufferIterator resumeIterator(textIn.c_str(), textIn.length());
+	resumeIterator.seekg(checkpoint->getStreamPosition());
+	unique_ptr<ASFormatter> resumed(checkpoint->resumeFormatter(&resumeIterator));
+	string resumedOut;
+	while (resumed->hasMoreLines())
+		resumedOut.append(resumed->nextLine() + "\n");
+	EXPECT_EQ(2, checkpoint->getLineNumber());
+	EXPECT_EQ(textOut, resumedOut);
+}
+
+vector<string> getFormatterSources()
+// Return the AStyle source files, found from the path of this file.
+// If they are not available this file is returned.
+{
+	string testPath = __FILE__;
+	size_t separator = testPath.find_last_of("/\\");
+	string sourceDir = (separator == string::npos) ? string("..") : testPath.substr(0, separator) + "/..";
+	sourceDir += "/../AStyle/src/";
+	const char* fileNames[] =
+	{
+		"ASBeautifier.cpp", "ASEnhancer.cpp", "ASFormatter.cpp", "ASLocalizer.cpp",
+		"ASResource.cpp", "astyle_main.cpp", "ASLocalizer.h", "astyle.h", "astyle_main.h"
+	};
+	vector<string> sources;
+	for (const char* fileName : fileNames)
+	{
+		ifstream in(sourceDir + fileName, ios::binary);
+		if (!in)
+			continue;
+		stringstream text;
+		text << in.rdbuf();
+		sources.emplace_back(text.str());
+	}
+	if (sources.empty())
+	{
+		ifstream in(__FILE__, ios::binary);
+		stringstream text;
+		text << in.rdbuf();
+		sources.emplace_back(text.str());
+	}
+	return sources;
+}
+
+void compareCorpusCheckpoints(const string& textIn, const char* options)
+// Take a checkpoint every few lines and compare the lines from the resumed
+// formatter to the original. A member that is not copied by the copy
+// constructor changes the resumed lines.
+// The lines are compared to the end of the input for some of the checkpoints.
+{
+	const size_t interval = 13;
+	const size_t compareLines = 100;
+	ASFormatter formatter;
+	ASConsole console(formatter);
+	ASOptions asOptions(formatter, console);
+	vector<string> optionsVector;
+	stringstream optionsIn(options);
+	asOptions.importOptions(optionsIn, optionsVector);
+	ASSERT_TRUE(asOptions.parseOptions(optionsVector, "Invalid options:")) << options;
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	vector<string> linesOut;
+	vector<unique_ptr<ASCheckpoint>> checkpoints;
+	while (formatter.hasMoreLines())
+	{
+		if (linesOut.size() % interval == 0)
+			checkpoints.emplace_back(new ASCheckpoint(formatter, static_cast<int>(linesOut.size())));
+		linesOut.emplace_back(formatter.nextLine());
+		if (!formatter.hasMoreLines() && formatter.getIsLineReady())
+			linesOut.emplace_back(formatter.nextLine());
+	}
+	for (size_t i = 0; i < checkpoints.size(); i++)
+	{
+		const ASCheckpoint& checkpoint = *checkpoints[i];
+		ASBufferIterator resumeIterator(textIn.c_str(), textIn.length());
+		resumeIterator.seekg(checkpoint.getStreamPosition());
+		unique_ptr<ASFormatter> resumed(checkpoint.resumeFormatter(&resumeIterator));
+		size_t firstLine = static_cast<size_t>(checkpoint.getLineNumber());
+		size_t maxLines = (i % 50 == 0) ? string::npos : compareLines;
+		vector<string> resumedLines = formatRemainingLines(*resumed, maxLines);
+		size_t lastLine = (maxLines == string::npos) ? linesOut.size() : min(firstLine + maxLines, linesOut.size());
+		vector<string> expectedLines(linesOut.begin() + firstLine, linesOut.begin() + lastLine);
+		ASSERT_EQ(expectedLines, resumedLines) << options << "checkpoint " << firstLine;
+	}
+}
+
+TEST(Checkpoint, ResumeCorpus)
+// Test resuming from checkpoints in the AStyle source files with several styles.
+// This fails if a formatter member that affects the formatting is not copied.
+{
+	const char* styles[] =
+	{
+		"style=allman\nbreak-blocks\nindent-switches\nindent-preproc-define\npad-oper\n",
+		"style=kr\nattach-inlines\nadd-braces\nalign-pointer=type\npad-header\nunpad-paren\nmax-code-length=80\n",
+		"style=gnu\nindent-namespaces\nindent-classes\ndelete-empty-lines\nconvert-tabs\nindent-preproc-block\n",
+		"style=whitesmith\nbreak-closing-braces\nremove-braces\nbreak-return-type\nindent-col1-comments\n",
+		"style=google\nindent=tab\nbreak-blocks=all\nadd-one-line-braces\nalign-reference=name\nindent-after-parens\n",
+	};
+	vector<string> sources = getFormatterSources();
+	for (const char* style : styles)
+	{
+		for (const string& source : sources)
+		{
+			compareCorpusCheckpoints(source, style);
+			if (HasFatalFailure())
+				return;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASBase header index tests
+//----------------------------------------------------------------------------
+
+TEST(HeaderIndex, SameAsLinearScan)
+// test that findHeader returns the same header as the linear scan
+// for every word in the corpus, for all of the file types
+{
+	vector<string> block = getHeaderCorpus();
+	block.resize(block.size() / 2000);
+	for (int fileType = C_TYPE; fileType <= SHARP_TYPE; fileType++)
+	{
+		HeaderFinder finder(fileType);
+		for (const vector<const string*>* headers : finder.headerVectors)
+		{
+			for (const string& line : block)
+			{
+				for (size_t i = 0; i < line.length(); i++)
+				{
+					if (!finder.isWordStart(line, i))
+						continue;
+					EXPECT_EQ(finder.findHeaderLinear(line, i, headers),
+					          finder.findHeaderIndex(line, i, headers))
+					        << fileType << " " << line.substr(i);
+				}
+			}
+		}
+	}
+}
+
+TEST(HeaderIndex, WordEndings)
+// test the headers at the end of a line and followed by other characters
+{
+	HeaderFinder finder(SHARP_TYPE);
+	const vector<const string*>* headers = finder.headerVectors[0];
+	EXPECT_EQ(&ASResource::AS_IF, finder.findHeaderIndex("if", 0, headers));
+	EXPECT_EQ(&ASResource::AS_IF, finder.findHeaderIndex("x if", 2, headers));
+	EXPECT_EQ(&ASResource::AS_IF, finder.findHeaderIndex("if(", 0, headers));
+	EXPECT_EQ(&ASResource::AS_GET, finder.findHeaderIndex("get {", 0, headers));
+	EXPECT_TRUE(finder.findHeaderIndex("iff", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("if.x", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("if,", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("get;", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("default(int)", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("synchronized", 0, headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("a_much_longer_word_than_any_header", 0, headers) == nullptr);
+}
+
+TEST(HeaderIndex, NotIndexedVector)
+// test findHeader with a vector that is not in ASLanguageVectors
+// each entry is compared instead of the index
+{
+	HeaderFinder finder(C_TYPE);
+	vector<const string*> headers;
+	headers.emplace_back(&ASResource::AS_WHILE);
+	headers.emplace_back(&ASResource::AS_IF);
+	EXPECT_EQ(&ASResource::AS_IF, finder.findHeaderIndex("if (a)", 0, &headers));
+	EXPECT_EQ(&ASResource::AS_WHILE, finder.findHeaderIndex("while (a)", 0, &headers));
+	EXPECT_EQ(&ASResource::AS_IF, finder.findHeaderIndex("if", 0, &headers));
+	EXPECT_TRUE(finder.findHeaderIndex("for (;;)", 0, &headers) == nullptr);
+	EXPECT_TRUE(finder.findHeaderIndex("iff", 0, &headers) == nullptr);
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASBase operator index tests
+//----------------------------------------------------------------------------
+
+TEST(OperatorIndex, SameAsLinearScan)
+// test that findOperator returns the same operator as the linear scan
+// for every operator character in the corpus, for all of the file types
+{
+	vector<string> block = getOperatorCorpus();
+	block.resize(block.size() / 2000);
+	for (int fileType = C_TYPE; fileType <= SHARP_TYPE; fileType++)
+	{
+		OperatorFinder finder(fileType);
+		for (const vector<const string*>* operators : finder.operatorVectors)
+		{
+			for (const string& line : block)
+			{
+				for (size_t i = 0; i < line.length(); i++)
+				{
+					if (!finder.isOperatorStart(line, i))
+						continue;
+					EXPECT_EQ(finder.findOperatorLinear(line, i, operators),
+					          finder.findOperatorIndex(line, i, operators))
+					        << fileType << " " << line.substr(i);
+				}
+			}
+		}
+	}
+}
+
+TEST(OperatorIndex, LongestMatch)
+// test that the longest operator in the vector is found
+{
+	OperatorFinder finder(C_TYPE);
+	const vector<const string*>* operators = finder.operatorVectors[0];
+	const vector<const string*>* nonAssignmentOperators = finder.operatorVectors[2];
+	EXPECT_EQ(&ASResource::AS_GR_GR_GR_ASSIGN, finder.findOperatorIndex(">>>=", 0, operators));
+	EXPECT_EQ(&ASResource::AS_GR_GR_GR, finder.findOperatorIndex(">>>=", 0, nonAssignmentOperators));
+	EXPECT_EQ(&ASResource::AS_GR_GR_GR, finder.findOperatorIndex(">>>", 0, operators));
+	EXPECT_EQ(&ASResource::AS_GR_GR, finder.findOperatorIndex("a >>", 2, operators));
+	EXPECT_EQ(&ASResource::AS_GR, finder.findOperatorIndex(">", 0, operators));
+	EXPECT_EQ(&ASResource::AS_GCC_MAX_ASSIGN, finder.findOperatorIndex(">?", 0, operators));
+	EXPECT_TRUE(finder.findOperatorIndex("+", 0, nonAssignmentOperators) == nullptr);
+	EXPECT_TRUE(finder.findOperatorIndex("@", 0, operators) == nullptr);
+	// the gcc operators are C++ only
+	OperatorFinder finderJava(JAVA_TYPE);
+	EXPECT_EQ(&ASResource::AS_GR, finderJava.findOperatorIndex(">?", 0, finderJava.operatorVectors[0]));
+}
+
+TEST(OperatorIndex, NotIndexedVector)
+// test findOperator with a vector that is not in ASLanguageVectors
+// the vector is sorted longest first and each entry is compared
+{
+	OperatorFinder finder(C_TYPE);
+	vector<const string*> operators;
+	operators.emplace_back(&ASResource::AS_GR_GR_ASSIGN);
+	operators.emplace_back(&ASResource::AS_GR_GR);
+	operators.emplace_back(&ASResource::AS_GR);
+	EXPECT_EQ(&ASResource::AS_GR_GR_ASSIGN, finder.findOperatorIndex(">>= 1", 0, &operators));
+	EXPECT_EQ(&ASResource::AS_GR_GR, finder.findOperatorIndex("a >> 1", 2, &operators));
+	EXPECT_EQ(&ASResource::AS_GR, finder.findOperatorIndex(">", 0, &operators));
+	EXPECT_TRUE(finder.findOperatorIndex("<", 0, &operators) == nullptr);
+}
+
+//----------------------------------------------------------------------------
+// AStyle character class table tests
+//----------------------------------------------------------------------------
+
+TEST(CharClass, SameAsPredicates)
+// test that the table gives the same result as the predicates
+// for every character, for all of the file types
+{
+	const int fileTypes[] = { C_TYPE, JAVA_TYPE, SHARP_TYPE };
+	for (int fileType : fileTypes)
+	{
+		CharClassifier classifier(fileType);
+		for (int i = 0; i < 256; i++)
+		{
+			char ch = static_cast<char>(i);
+			EXPECT_EQ(ch == ' ' || ch == '\t', classifier.isWhiteSpaceTable(ch))
+			        << "file type " << fileType << " char " << i;
+			EXPECT_EQ(ch >= '0' && ch <= '9', classifier.isDigitTable(ch))
+			        << "file type " << fileType << " char " << i;
+			EXPECT_EQ(classifier.isLegalNameCharLinear(ch), classifier.isLegalNameCharTable(ch))
+			        << "file type " << fileType << " char " << i;
+			if (ch == ' ' || ch == '\t')
+				continue;
+			EXPECT_EQ(classifier.isCharPotentialOperatorLinear(ch), classifier.isCharPotentialOperatorTable(ch))
+			        << "file type " << fileType << " char " << i;
+		}
+	}
+}
+
+TEST(CharClass, LanguageNameChars)
+// test the name characters that depend on the file type
+{
+	CharClassifier classifierC(C_TYPE);
+	CharClassifier classifierJava(JAVA_TYPE);
+	CharClassifier classifierSharp(SHARP_TYPE);
+	EXPECT_FALSE(classifierC.isLegalNameCharTable('$'));
+	EXPECT_TRUE(classifierJava.isLegalNameCharTable('$'));
+	EXPECT_FALSE(classifierSharp.isLegalNameCharTable('$'));
+	EXPECT_FALSE(classifierC.isLegalNameCharTable('@'));
+	EXPECT_FALSE(classifierJava.isLegalNameCharTable('@'));
+	EXPECT_TRUE(classifierSharp.isLegalNameCharTable('@'));
+	// characters above 127 are never name characters
+	EXPECT_FALSE(classifierC.isLegalNameCharTable('\xE9'));
+	EXPECT_FALSE(classifierC.isCharPotentialOperatorTable('\xE9'));
+	EXPECT_EQ("abc.d_1", classifierC.getCurrentWordTable("abc.d_1$x", 0));
+	EXPECT_EQ("abc.d_1$x", classifierJava.getCurrentWordTable("abc.d_1$x", 0));
+	EXPECT_EQ("@name", classifierSharp.getCurrentWordTable("@name\xE9", 0));
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASScanner tests
+//----------------------------------------------------------------------------
+
+vector<string> getScannerLines()
+// Return short lines made of the characters the scanners look for,
+// with a block of the characters longer than the SIMD block size.
+{
+	const string chars = " \t*/\"';{}a\\";
+	vector<string> lines;
+	unsigned seed = 12345;
+	for (size_t length = 0; length < 70; length++)
+	{
+		for (int i = 0; i < 20; i++)
+		{
+			string line;
+			for (size_t j = 0; j < length; j++)
+			{
+				seed = seed * 1103515245 + 12345;
+				// use mostly blanks so the searches go past the first block
+				size_t pick = (seed >> 16) % (chars.length() * 4);
+				line += pick < chars.length() ? chars[pick] : (pick % 2 ? ' ' : '\t');
+			}
+			lines.emplace_back(line);
+		}
+	}
+	return lines;
+}
+
+TEST(Scanner, SameAsStringSearch)
+// test that the scanners return the same position as the string functions
+// for every start position, including the positions past the end
+{
+	vector<string> lines = getScannerLines();
+	for (const string& line : lines)
+	{
+		for (size_t i = 0; i <= line.length() + 1; i++)
+		{
+			ASSERT_EQ(line.find_first_not_of(" \t", i), ASScanner::findNonBlank(line, i)) << line;
+			ASSERT_EQ(line.find_last_not_of(" \t", i), ASScanner::findLastNonBlank(line, i)) << line;
+			ASSERT_EQ(line.find("*/", i), ASScanner::findCommentEnd(line, i)) << line;
+			ASSERT_EQ(line.find_first_of("\"'/;{}", i), ASScanner::findSyntaxChar(line, i)) << line;
+		}
+		ASSERT_EQ(line.find_last_not_of(" \t"), ASScanner::findLastNonBlank(line)) << line;
+		ASSERT_EQ(line.find_first_not_of(" \t", string::npos), ASScanner::findNonBlank(line, string::npos));
+		ASSERT_EQ(line.find("*/", string::npos), ASScanner::findCommentEnd(line, string::npos));
+	}
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASSharedStack tests
+//----------------------------------------------------------------------------
+
+TEST(SharedStack, CopyOnWrite)
+// test that a copy shares the elements until one of the stacks is changed
+{
+	ASSharedStack<int> stack;
+	stack.write().push_back(1);
+	stack.write().push_back(2);
+	EXPECT_FALSE(stack.isShared());
+	ASSharedStack<int> copy(stack);
+	EXPECT_TRUE(stack.isShared());
+	EXPECT_TRUE(copy.isShared());
+	EXPECT_EQ(&*stack, &*copy);
+	// changing the copy does not change the original
+	copy.write().push_back(3);
+	EXPECT_FALSE(stack.isShared());
+	EXPECT_FALSE(copy.isShared());
+	EXPECT_NE(&*stack, &*copy);
+	ASSERT_EQ(2U, stack->size());
+	ASSERT_EQ(3U, copy->size());
+	EXPECT_EQ(2, stack->back());
+	EXPECT_EQ(3, copy->back());
+	// an unshared stack is changed in place
+	const vector<int>* elements = &*stack;
+	stack.write().pop_back();
+	EXPECT_EQ(elements, &*stack);
+	EXPECT_EQ(1U, stack->size());
+}
+
+TEST(SharedStack, Clear)
+// test that clearing a stack does not clear the copies
+{
+	ASSharedStack<vector<const string*> > stack;
+	stack.write().emplace_back();
+	stack.write().back().emplace_back(&ASResource::AS_IF);
+	ASSharedStack<vector<const string*> > copy(stack);
+	stack.clear();
+	EXPECT_FALSE(stack.isShared());
+	EXPECT_TRUE(stack->empty());
+	ASSERT_EQ(1U, copy->size());
+	ASSERT_EQ(1U, copy->back().size());
+	EXPECT_EQ(&ASResource::AS_IF, copy->back().back());
+	// an unshared stack is cleared in place
+	copy.clear();
+	EXPECT_TRUE(copy->empty());
+}
+
+//----------------------------------------------------------------------------
+// AStyle ASFormatter object tests
+//----------------------------------------------------------------------------
+
+TEST(FormatterReuse, SameAsNewFormatter)
+// test that a formatter reused for several files gives the same output
+// as a new formatter, the stacks are cleared by init() and not reallocated
+{
+	const char* textIn[] =
+	{
+		"namespace FooName\n"
+		"{\n"
+		"class Foo\n"
+		"{\n"
+		"public:\n"
+		"    void foo(int a)\n"
+		"    {\n"
+		"#ifdef FOO\n"
+		"        if (a > 0 && (bar(a) || baz[a]))\n"
+		"        {\n"
+		"            for (int i = 0; i < a; i++)\n"
+		"                bar(i);\n"
+		"#endif\n",
+		// the previous file ends inside the braces and the preprocessor
+		"void bar()\n"
+		"{\n"
+		"    switch (x)\n"
+		"    {\n"
+		"    case 1: baz(); break;\n"
+		"    }\n"
+		"}\n",
+	};
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	for (int i = 0; i < 4; i++)
+	{
+		const char* text = textIn[i % 2];
+		ASFormatter newFormatter;
+		newFormatter.setFormattingStyle(STYLE_ALLMAN);
+		string textOut;
+		string newTextOut;
+		ASBufferIterator bufferIterator(text, strlen(text));
+		formatter.init(&bufferIterator);
+		while (formatter.hasMoreLines())
+			textOut.append(formatter.nextLine()).append("\n");
+		ASBufferIterator newBufferIterator(text, strlen(text));
+		newFormatter.init(&newBufferIterator);
+		while (newFormatter.hasMoreLines())
+			newTextOut.append(newFormatter.nextLine()).append("\n");
+		EXPECT_EQ(newTextOut, textOut) << "file " << i;
+	}
+}
+
+TEST(FormatterNesting, LambdasInNamespaces)
+// test the indent of lambdas in lambdas in nested namespaces
+// deeper than the initial size of the beautifier stacks
+{
+	const int depth = 40;
+	string textIn;
+	string textExpected;
+	for (int i = 0; i < depth; i++)
+	{
+		textIn.append("namespace N" + to_string(i) + " {\n");
+		textExpected.append(string(i * 4, ' ') + "namespace N" + to_string(i) + "\n");
+		textExpected.append(string(i * 4, ' ') + "{\n");
+	}
+	textIn.append("void foo() {\n");
+	textExpected.append(string(depth * 4, ' ') + "void foo()\n");
+	textExpected.append(string(depth * 4, ' ') + "{\n");
+	for (int i = 0; i < depth; i++)
+	{
+		textIn.append("auto f" + to_string(i) + " = [&](int a) {\n"
+		              "if (a) { bar(a); } else { baz(a); }\n");
+		string indent((depth + 1 + i) * 4, ' ');
+		textExpected.append(indent + "auto f" + to_string(i) + " = [&](int a)\n");
+		textExpected.append(indent + "{\n");
+		textExpected.append(indent + "    if (a)\n");
+		textExpected.append(indent + "    {\n");
+		textExpected.append(indent + "        bar(a);\n");
+		textExpected.append(indent + "    }\n");
+		textExpected.append(indent + "    else\n");
+		textExpected.append(indent + "    {\n");
+		textExpected.append(indent + "        baz(a);\n");
+		textExpected.append(indent + "    }\n");
+	}
+	for (int i = depth - 1; i >= 0; i--)
+	{
+		textIn.append("};\n");
+		textExpected.append(string((depth + 1 + i) * 4, ' ') + "};\n");
+	}
+	textIn.append("}\n");
+	textExpected.append(string(depth * 4, ' ') + "}\n");
+	for (int i = depth - 1; i >= 0; i--)
+	{
+		textIn.append("}\n");
+		textExpected.append(string(i * 4, ' ') + "}\n");
+	}
+	// the input ends with a line end, so the last line is empty
+	textExpected.append("\n");
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setNamespaceIndent(true);
+	string textOut;
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	while (formatter.hasMoreLines())
+		textOut.append(formatter.nextLine()).append("\n");
+	EXPECT_EQ(textExpected, textOut);
+}
+
+TEST(FormatterParsing, LongNamesAndPointers)
+// test the words, pointers, and preprocessor directives that are
+// parsed from the line without copying it
+{
+	string textIn =
+	    "#if defined(LONG_PREPROCESSOR_NAME)\n"
+	    "void formatterFunctionName(const std::string &referenceArgument, int *pointerArgument)\n"
+	    "{\n"
+	    "  // a comment with text\n"
+	    "  SomeLongClassName *pointerVariableName = getPointerVariableName(referenceArgument);\n"
+	    "  if (pointerVariableName != nullptr && *pointerArgument > 0) {\n"
+	    "    int &referenceVariableName = pointerVariableName->memberVariableName;\n"
+	    "    referenceVariableName = *pointerArgument; /* block comment */\n"
+	    "  }\n"
+	    "}\n"
+	    "#elif LONG_NAME\n"
+	    "#endif";
+	string textExpected =
+	    "#if defined(LONG_PREPROCESSOR_NAME)\n"
+	    "void formatterFunctionName(const std::string& referenceArgument, int* pointerArgument)\n"
+	    "{\n"
+	    "    // a comment with text\n"
+	    "    SomeLongClassName* pointerVariableName = getPointerVariableName(referenceArgument);\n"
+	    "    if (pointerVariableName != nullptr && *pointerArgument > 0)\n"
+	    "    {\n"
+	    "        int& referenceVariableName = pointerVariableName->memberVariableName;\n"
+	    "        referenceVariableName = *pointerArgument; /* block comment */\n"
+	    "    }\n"
+	    "}\n"
+	    "#elif LONG_NAME\n"
+	    "#endif\n";
+	ASFormatter formatter;
+	formatter.setFormattingStyle(STYLE_ALLMAN);
+	formatter.setPointerAlignment(PTR_ALIGN_TYPE);
+	string textOut;
+	ASBufferIterator bufferIterator(textIn.c_str(), textIn.length());
+	formatter.init(&bufferIterator);
+	while (formatter.hasMoreLines())
+		textOut.append(formatter.nextLine()).append("\n");
+	EXPECT_EQ(textExpected, textOut);
+}
+
 //----------------------------------------------------------------------------
 // AStyle other tests
 //----------------------------------------------------------------------------
@@ -438,11 +1371,11 @@ TEST(Other, MingwFileGlobbing)
 }
 
 TEST(Other, GlobalPreprocessorExternBracket)
-// Test that g_preprocessorCppExternCBracket is reset for each file.
+// Test that the extern "C" brace state is reset for each file.
 {
-	// The ASBeautifier global variable g_preprocessorCppExternCBracket
-	// must be cleared in the "init" method instead of the constructor.
-	// If not cleared, the "int a;" will not be indented
+	// The ASBeautifier variable pointed to by preprocessorCppExternCBrace
+	// was a global. It must be cleared in the "init" method instead of
+	// the constructor. If not cleared, the "int a;" will not be indented
 	ASFormatter formatter;
 	unique_ptr<ASConsole> console(new ASConsole(formatter));
 	vector<string> astyleOptionsVector;
@@ -469,10 +1402,10 @@ TEST(Other, GlobalPreprocessorExternBracket)
 	console->processOptions(astyleOptionsVector);
 	console->processFiles();
 	// Check for 2nd file not formatted.
-	// If the ASBeautifier global variable is not reset,
+	// If the ASBeautifier extern "C" state is not reset,
 	// "int a;" line will not be indented.
 	EXPECT_TRUE(console->getFilesAreIdentical())
-	        << "Global variable has not been reset";
+	        << "Extern \"C\" state has not been reset";
 }
 
 TEST(Other, ErrorExit)
@@ -340,6 +340,110 @@ TEST_F(PrintF, DefaultWildcard)
 	EXPECT_EQ(text, textOut);
 }
 
+TEST_F(PrintF, JobsWildcard)
+// test print wildcard with the jobs option
+// the report must be in the same order as a single job
+{
+	// expected text
+	string text =
+	    "------------------------------------------------------------\n"
+	    "Directory  <test_directory>/*.cpp\n"
+	    "------------------------------------------------------------\n"
+	    "Formatted  fileFormatted.cpp\n"
+	    "Unchanged  fileUnchanged.cpp\n";
+	adjustText(text);
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--ascii");
+	astyleOptionsVector.push_back("--jobs=2");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// redirect stdout and get the report
+	redirectStream();
+	console->processFiles();
+	string textOut = restoreStream();
+	adjustTextOut(textOut);
+	// check entries in the fileNameVector
+	vector<string> fileName = console->getFileName();
+	ASSERT_EQ(fileNames.size(), fileName.size()) << "Print format was not checked.";
+	// check the report content and the merged counts
+	EXPECT_EQ(text, textOut);
+	EXPECT_EQ(1, console->getFilesFormatted());
+}
+
+TEST_F(PrintF, CheckWildcard)
+// test print wildcard with the check option
+// the first changed line is displayed with the formatted file
+{
+	// expected text
+	string text =
+	    "------------------------------------------------------------\n"
+	    "Directory  <test_directory>/*.cpp\n"
+	    "------------------------------------------------------------\n"
+	    "Formatted  fileFormatted.cpp:4\n"
+	    "Unchanged  fileUnchanged.cpp\n";
+	adjustText(text);
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--ascii");
+	astyleOptionsVector.push_back("--check");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// redirect stdout and get the report
+	redirectStream();
+	console->processFiles();
+	string textOut = restoreStream();
+	adjustTextOut(textOut);
+	// check entries in the fileNameVector
+	vector<string> fileName = console->getFileName();
+	ASSERT_EQ(fileNames.size(), fileName.size()) << "Print format was not checked.";
+	// check the report content
+	EXPECT_EQ(text, textOut);
+	EXPECT_EQ(1, console->getFilesFormatted());
+}
+
+TEST_F(PrintF, CheckWildcard_LineEnds)
+// test print wildcard with the check option and a line end change
+// a line end change is not found until the end of the file
+// so the line number is not displayed
+{
+	char textLineEnds[] =
+	    "\nvoid foo()\n"
+	    "{\r\n"
+	    "    bar();\n"
+	    "}\n";
+	fileNames.push_back(getTestDirectory() + "/fileLineEnds.cpp");
+	console->standardizePath(fileNames.back());
+	createTestFile(fileNames.back(), textLineEnds);
+	// expected text
+	string text =
+	    "------------------------------------------------------------\n"
+	    "Directory  <test_directory>/*.cpp\n"
+	    "------------------------------------------------------------\n"
+	    "Formatted  fileFormatted.cpp:4\n"
+	    "Formatted  fileLineEnds.cpp\n"
+	    "Unchanged  fileUnchanged.cpp\n";
+	adjustText(text);
+	// call astyle processOptions()
+	vector<string> astyleOptionsVector;
+	astyleOptionsVector.push_back("--ascii");
+	astyleOptionsVector.push_back("--check");
+	astyleOptionsVector.push_back("--jobs=2");
+	astyleOptionsVector.push_back(getTestDirectory() + "/*.cpp");
+	console->processOptions(astyleOptionsVector);
+	// redirect stdout and get the report
+	redirectStream();
+	console->processFiles();
+	string textOut = restoreStream();
+	adjustTextOut(textOut);
+	// check entries in the fileNameVector
+	vector<string> fileName = console->getFileName();
+	ASSERT_EQ(fileNames.size(), fileName.size()) << "Print format was not checked.";
+	// check the report content
+	EXPECT_EQ(text, textOut);
+	EXPECT_EQ(2, console->getFilesFormatted());
+}
+
 TEST_F(PrintF, DefaultWildcard_Exclude)
 // test print wildcard with an exclude
 {
@@ -0,0 +1,248 @@
+// AStyleTestCon_Reference.h
+// Copyright (c) 2018 by Jim Pattee <jimp03@email.com>.
+// This code is licensed under the MIT License.
+// License.md describes the conditions under which this software may be distributed.
+
+// The code replaced by the header and operator indexes and the character
+// class table, and the corpora used to compare them. AStyleTestCon checks
+// that the replacements give the same results, and AStyleTestBench times them.
+
+#ifndef ASTYLE_TESTCON_REFERENCE_H
+#define ASTYLE_TESTCON_REFERENCE_H
+
+//-------------------------------------------------------------------------
+// headers
+//-------------------------------------------------------------------------
+
+#include "AStyleTestCon.h"
+
+//-------------------------------------------------------------------------
+// ASBase header index
+//-------------------------------------------------------------------------
+
+class HeaderFinder : public ASBase
+// Access the protected ASBase functions to compare findHeader()
+// to the linear scan of the header vectors that it replaced.
+{
+public:
+	// findHeader() is called with the shared language vectors
+	vector<const vector<const string*>*> headerVectors;
+
+	explicit HeaderFinder(int fileType)
+	{
+		ASBase::init(fileType);
+		const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+		headerVectors.emplace_back(&languageVectors.beautifierHeaders);
+		headerVectors.emplace_back(&languageVectors.beautifierNonParenHeaders);
+		headerVectors.emplace_back(&languageVectors.preBlockStatements);
+		headerVectors.emplace_back(&languageVectors.indentableHeaders);
+		headerVectors.emplace_back(&languageVectors.formatterHeaders);
+		headerVectors.emplace_back(&languageVectors.formatterNonParenHeaders);
+		headerVectors.emplace_back(&languageVectors.preDefinitionHeaders);
+		headerVectors.emplace_back(&languageVectors.castOperators);
+		headerVectors.emplace_back(&languageVectors.preCommandHeaders);
+	}
+
+	const string* findHeaderIndex(const string& line, int i, const vector<const string*>* headers) const
+	{ return findHeader(line, i, headers); }
+
+	const string* findHeaderLinear(const string& line, int i, const vector<const string*>* headers) const
+	// the linear scan used by findHeader() before the header index
+	{
+		for (size_t p = 0; p < headers->size(); p++)
+		{
+			const string* header = (*headers)[p];
+			const size_t wordEnd = i + header->length();
+			if (wordEnd > line.length())
+				continue;
+			int result = (line.compare(i, header->length(), *header));
+			if (result > 0)
+				continue;
+			if (result < 0)
+				break;
+			if (wordEnd == line.length())
+				return header;
+			if (isLegalNameChar(line[wordEnd]))
+				continue;
+			const char peekChar = peekNextChar(line, wordEnd - 1);
+			if (peekChar == ',' || peekChar == ')')
+				break;
+			else if ((header == &AS_GET
+			          || header == &AS_SET
+			          || header == &AS_DEFAULT)
+			         && (peekChar == ';' || peekChar == '(' || peekChar == '='))
+				break;
+			return header;
+		}
+		return nullptr;
+	}
+
+	bool isWordStart(const string& line, size_t i) const
+	{ return !isWhiteSpace(line[i]) && isCharPotentialHeader(line, i); }
+};
+
+inline vector<string> getHeaderCorpus()
+// Return the lines of a large source that uses all of the headers.
+{
+	const char* block[] =
+	{
+		"namespace FooName {",
+		"class Foo : public Bar, private Baz {",
+		"public:",
+		"    int getValue() const noexcept override final { return value; }",
+		"    void setValue(int newValue) volatile { value = newValue; }",
+		"    static_cast<int>(x) + const_cast<char*>(y) + dynamic_cast<Foo*>(z);",
+		"    reinterpret_cast<long>(ptr); int interface_count, default_value;",
+		"};",
+		"struct Point { int x, y; }; union Data { int i; float f; };",
+		"void foo(int forever, int iffy, bool doubled) {",
+		"    if (isFoo && !isBar) { bar(); } else if (x.if) { baz(); }",
+		"    for (int i = 0; i < count; i++) { total += items[i]; }",
+		"    while (isRunning) { do { process(); } while (hasMore); }",
+		"    switch (value) { case 1: break; default: break; }",
+		"    try { throwIt(); } catch (exception& e) { handle(e); }",
+		"    __try { run(); } __finally { cleanup(); } __except(filter) { }",
+		"    Q_FOREACH(item, items) { use(item); } Q_FOREVER { wait(); }",
+		"    foreach (item in items) forever { spin(); }",
+		"    synchronized (lock) { fixed (p) { unsafe(); } } goto default;",
+		"    int get; int set = default(int); get => value; set; remove(x); add(y);",
+		"    @autoreleasepool { $dollar = returnValue; return result; }",
+		"    template<typename T> sealed throws where interrupt module;",
+		"}",
+		"}",
+	};
+	vector<string> corpus;
+	for (int i = 0; i < 2000; i++)
+		for (const char* line : block)
+			corpus.emplace_back(line);
+	return corpus;
+}
+
+//-------------------------------------------------------------------------
+// ASBase operator index
+//-------------------------------------------------------------------------
+
+class OperatorFinder : public ASBase
+// Access the protected ASBase functions to compare findOperator()
+// to the linear scan of the operator vectors that it replaced.
+{
+public:
+	// findOperator() is called with the shared language vectors
+	vector<const vector<const string*>*> operatorVectors;
+
+	explicit OperatorFinder(int fileType)
+	{
+		ASBase::init(fileType);
+		const ASLanguageVectors& languageVectors = ASLanguageVectors::getLanguageVectors(fileType);
+		operatorVectors.emplace_back(&languageVectors.operators);
+		operatorVectors.emplace_back(&languageVectors.assignmentOperators);
+		operatorVectors.emplace_back(&languageVectors.nonAssignmentOperators);
+	}
+
+	const string* findOperatorIndex(const string& line, int i, const vector<const string*>* operators) const
+	{ return findOperator(line, i, operators); }
+
+	const string* findOperatorLinear(const string& line, int i, const vector<const string*>* operators) const
+	// the linear scan used by findOperator() before the operator index
+	{
+		for (size_t p = 0; p < operators->size(); p++)
+		{
+			const size_t wordEnd = i + (*(*operators)[p]).length();
+			if (wordEnd > line.length())
+				continue;
+			if (line.compare(i, (*(*operators)[p]).length(), *(*operators)[p]) == 0)
+				return (*operators)[p];
+		}
+		return nullptr;
+	}
+
+	bool isOperatorStart(const string& line, size_t i) const
+	{ return !isWhiteSpace(line[i]) && isCharPotentialOperator(line[i]); }
+};
+
+inline vector<string> getOperatorCorpus()
+// Return the lines of a large source that uses all of the operators.
+{
+	const char* block[] =
+	{
+		"    a = b + c - d * e / f % g;",
+		"    a += b; a -= b; a *= b; a /= b; a %= b; a |= b; a &= b; a ^= b;",
+		"    a <<= 1; a >>= 2; a >>>= 3; a <<<= 4; a <? b; a >? b; a <?= b; a >?= b;",
+		"    if (a == b && c != d || e <= f || g >= h) { i++; j--; }",
+		"    x = y << 2 >> 3 >>> 4 <<< 5; z = !x & ~y | w ^ v;",
+		"    p->member; q ?? r; list.Select(s => s.Name); Foo::bar();",
+		"    result = isFoo ? first : second; vector<vector<int>> nested;",
+		"    auto lambda = [&](int n) -> int { return n * 2; };",
+		"    if (a<b&&c>d) e=f==g?h:i; k=-l+ +m- -n; o=*p&*q;",
+	};
+	vector<string> corpus;
+	for (int i = 0; i < 2000; i++)
+		for (const char* line : block)
+			corpus.emplace_back(line);
+	return corpus;
+}
+
+//-------------------------------------------------------------------------
+// character class table
+//-------------------------------------------------------------------------
+
+class CharClassifier : public ASBase
+// Access the protected ASBase functions to compare the character class
+// table to the character predicates that it replaced.
+{
+public:
+	explicit CharClassifier(int fileType_) : fileType(fileType_)
+	{ ASBase::init(fileType_); }
+
+	bool isWhiteSpaceTable(char ch) const { return isWhiteSpace(ch); }
+	bool isDigitTable(char ch) const { return isDigit(ch); }
+	bool isLegalNameCharTable(char ch) const { return isLegalNameChar(ch); }
+	bool isCharPotentialOperatorTable(char ch) const { return isCharPotentialOperator(ch); }
+	string getCurrentWordTable(const string& line, size_t index) const { return getCurrentWord(line, index); }
+
+	bool isLegalNameCharLinear(char ch) const
+	// the isLegalNameChar() used before the character class table
+	{
+		if (ch == ' ' || ch == '\t')
+			return false;
+		if ((unsigned char) ch > 127)
+			return false;
+		return (isalnum((unsigned char) ch)
+		        || ch == '.' || ch == '_'
+		        || (fileType == JAVA_TYPE && ch == '$')
+		        || (fileType == SHARP_TYPE && ch == '@'));
+	}
+
+	bool isCharPotentialOperatorLinear(char ch) const
+	// the isCharPotentialOperator() used before the character class table
+	{
+		if ((unsigned char) ch > 127)
+			return false;
+		return (ispunct((unsigned char) ch)
+		        && ch != '{' && ch != '}'
+		        && ch != '(' && ch != ')'
+		        && ch != '[' && ch != ']'
+		        && ch != ';' && ch != ','
+		        && ch != '#' && ch != '\\'
+		        && ch != '\'' && ch != '\"');
+	}
+
+	string getCurrentWordLinear(const string& line, size_t index) const
+	// the getCurrentWord() used before the character class table
+	{
+		size_t i;
+		for (i = index; i < line.length(); i++)
+		{
+			if (!isLegalNameCharLinear(line[i]))
+				break;
+		}
+		return line.substr(index, i - index);
+	}
+
+private:
+	int fileType;
+};
+
+//-------------------------------------------------------------------------
+
+#endif // closes ASTYLE_TESTCON_REFERENCE_H
@@ -14,6 +14,7 @@
 //----------------------------------------------------------------------------
 
 #include "AStyleTestCon.h"
+#include <chrono>
 #ifdef _WIN32
 	#include <windows.h>
 #else
@@ -354,6 +355,148 @@ struct ASEncoding_Class : public Test
 	delete[]utf8Out;
 }
 
+//----------------------------------------------------------------------------
+// AStyle test ASEncoding ASCII blocks
+//----------------------------------------------------------------------------
+
+void appendUtf16(string& utf16, int value, bool isBigEndian)
+// Append a utf-16 character to a string of bytes.
+{
+	char low = static_cast<char>(value & 0xff);
+	char high = static_cast<char>(value >> 8);
+	utf16 += isBigEndian ? high : low;
+	utf16 += isBigEndian ? low : high;
+}
+
+string referenceUtf8ToUtf16(const string& utf8, bool isBigEndian)
+// Convert valid utf-8 text to utf-16 one character at a time.
+// It is used to check and benchmark the ASEncoding functions.
+{
+	string utf16;
+	for (size_t i = 0; i < utf8.length();)
+	{
+		unsigned char ch = static_cast<unsigned char>(utf8[i]);
+		int codePoint = ch;
+		size_t charLen = 1;
+		if (ch >= 0xF0)
+		{
+			codePoint = ch & 0x07;
+			charLen = 4;
+		}
+		else if (ch >= 0xE0)
+		{
+			codePoint = ch & 0x0F;
+			charLen = 3;
+		}
+		else if (ch >= 0xC0)
+		{
+			codePoint = ch & 0x1F;
+			charLen = 2;
+		}
+		for (size_t j = 1; j < charLen; j++)
+			codePoint = (codePoint << 6) | (utf8[i + j] & 0x3F);
+		i += charLen;
+		if (codePoint >= 0x10000)
+		{
+			appendUtf16(utf16, 0xD800 + ((codePoint - 0x10000) >> 10), isBigEndian);
+			appendUtf16(utf16, 0xDC00 + (codePoint & 0x3FF), isBigEndian);
+		}
+		else
+			appendUtf16(utf16, codePoint, isBigEndian);
+	}
+	return utf16;
+}
+
+string convertUtf8ToUtf16(const string& utf8, bool isBigEndian)
+// Convert utf-8 text to utf-16 with the ASEncoding functions.
+{
+	astyle::ASEncoding utf8_16;
+	string utf16(utf8_16.utf16LengthFromUtf8(utf8.c_str(), utf8.length()), '\0');
+	size_t utf16Len = utf8_16.utf8ToUtf16(const_cast<char*>(utf8.c_str()), utf8.length(),
+	                                      isBigEndian, &utf16[0]);
+	utf16.resize(utf16Len);
+	return utf16;
+}
+
+string convertUtf16ToUtf8(const string& utf16, bool isBigEndian)
+// Convert utf-16 text to utf-8 with the ASEncoding functions.
+{
+	astyle::ASEncoding utf8_16;
+	string utf8(utf8_16.utf8LengthFromUtf16(utf16.c_str(), utf16.length(), isBigEndian), '\0');
+	size_t utf8Len = utf8_16.utf16ToUtf8(const_cast<char*>(utf16.c_str()), utf16.length(),
+	                                     isBigEndian, true, &utf8[0]);
+	utf8.resize(utf8Len);
+	return utf8;
+}
+
+TEST(ASEncoding_Blocks, AllAlignments)
+// Test the ASCII blocks with non-ASCII characters at every position in a block.
+// The conversion must be the same as a conversion one character at a time.
+{
+	const char* nonAscii[] = { "\xc3\xa4", "\xe6\x96\x87", "\xf0\x9f\x98\x80" };
+	for (const char* ch : nonAscii)
+	{
+		for (size_t before = 0; before < 40; before++)
+		{
+			string utf8 = string(before, 'a') + ch + string(40 - before, 'b') + ch + "\n";
+			for (int i = 0; i < 2; i++)
+			{
+				bool isBigEndian = (i == 1);
+				string utf16 = convertUtf8ToUtf16(utf8, isBigEndian);
+				ASSERT_EQ(referenceUtf8ToUtf16(utf8, isBigEndian), utf16) << before;
+				ASSERT_EQ(utf8, convertUtf16ToUtf8(utf16, isBigEndian)) << before;
+			}
+		}
+	}
+}
+
+TEST(ASEncoding_Blocks, Benchmark)
+// Benchmark the ASEncoding functions on an ASCII and a mixed source.
+// The mixed source is this file, which has Chinese, Japanese, Korean, Greek,
+// Russian, and German text. The reference is a conversion one character at a
+// time. The bytes per microsecond are reported as properties of the test,
+// the results must be the same.
+{
+	ifstream fin(__FILE__, ios::binary);
+	ASSERT_TRUE(fin.is_open()) << "Cannot open " << __FILE__;
+	string source((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+	string mixed;
+	for (int i = 0; i < 20; i++)
+		mixed += source;
+	string ascii;
+	for (char ch : mixed)
+		if (static_cast<unsigned char>(ch) < 0x80)
+			ascii += ch;
+	ASSERT_NE(ascii.length(), mixed.length());
+
+	struct Corpus
+	{
+		const char* name;
+		const string& utf8;
+	} corpora[] = { { "Ascii", ascii }, { "Mixed", mixed } };
+	for (const Corpus& corpus : corpora)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		string referenceOut = referenceUtf8ToUtf16(corpus.utf8, false);
+		chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+		string utf16 = convertUtf8ToUtf16(corpus.utf8, false);
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		string utf8 = convertUtf16ToUtf8(utf16, false);
+		chrono::steady_clock::time_point end8 = chrono::steady_clock::now();
+		int bytes = static_cast<int>(corpus.utf8.length());
+		int referenceTime = static_cast<int>(chrono::duration_cast<chrono::microseconds>(middle - start).count());
+		int utf16Time = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end - middle).count());
+		int utf8Time = static_cast<int>(chrono::duration_cast<chrono::microseconds>(end8 - end).count());
+		string name = corpus.name;
+		RecordProperty(name + "Bytes", bytes);
+		RecordProperty(name + "ReferenceBytesPerMicrosecond", bytes / max(referenceTime, 1));
+		RecordProperty(name + "Utf8ToUtf16BytesPerMicrosecond", bytes / max(utf16Time, 1));
+		RecordProperty(name + "Utf16ToUtf8BytesPerMicrosecond", bytes / max(utf8Time, 1));
+		EXPECT_EQ(referenceOut, utf16) << corpus.name;
+		EXPECT_EQ(corpus.utf8, utf8) << corpus.name;
+	}
+}
+
 //----------------------------------------------------------------------------
 // AStyle test UTF-16 file processing
 //----------------------------------------------------------------------------
@@ -14,6 +14,10 @@
 #include "astyle_main.h"
 using namespace astyle;
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #ifdef _WIN32
 	#include <windows.h>
 #else
@@ -403,6 +407,50 @@ TEST_F(AStyleMainUtf16F1, InvalidOption)
 	delete[] text8Out;
 }
 
+TEST_F(AStyleMainUtf16F1, FormatLineEnds)
+{
+	// test AStyleMainUtf16 with Windows line ends, lines embedded in
+	// a comment and a raw string, and utf-8 characters of 2 to 4 bytes
+	// the 4 byte character is a utf-16 surrogate pair
+	// the result must be the same as AStyleMain
+	char text[] =
+	    "\r\nvoid foo()\r\n"
+	    "{\r\n"
+	    "bar(\"\xE6\x96\x87\");   // \xF0\x9F\x98\x80\r\n"
+	    " /* comment\r\n"
+	    "    \xC3\x9F */\r\n"
+	    "const char* s = R\"(\r\n"
+	    "  raw {\r\n"
+	    ")\";\r\n"
+	    "}\r\n";
+	char textExpected[] =
+	    "\r\nvoid foo() {\r\n"
+	    "    bar(\"\xE6\x96\x87\");   // \xF0\x9F\x98\x80\r\n"
+	    "    /* comment\r\n"
+	    "       \xC3\x9F */\r\n"
+	    "    const char* s = R\"(\r\n"
+	    "  raw {\r\n"
+	    ")\";\r\n"
+	    "}\r\n";
+	char options[] = "style=attach";
+	// convert 16 bit
+	ASLibrary library;
+	char16_t* text16_ = library.convertUtf8ToUtf16(text, memoryAlloc);
+	char16_t* options16_ = library.convertUtf8ToUtf16(options, memoryAlloc);
+	char16_t* text16Out = ::AStyleMainUtf16(text16_, options16_, errorHandler, memoryAlloc);
+	ASSERT_TRUE(text16Out != nullptr);
+	// convert text16Out to utf-8
+	char* text8Out = library.convertUtf16ToUtf8(text16Out);
+	EXPECT_STREQ(textExpected, text8Out);
+	char* textOut = ::AStyleMain(text, options, errorHandler, memoryAlloc);
+	EXPECT_STREQ(textOut, text8Out);
+	delete[] text16_;
+	delete[] options16_;
+	delete[] text16Out;
+	delete[] text8Out;
+	delete[] textOut;
+}
+
 //----------------------------------------------------------------------------
 // Test FormatUtf16 in ASLibrary
 // This uses the test fixture from above.
@@ -532,6 +580,794 @@ struct AStyleMainUtf16F2 : public Test
 #endif // __BORLANDC__
 }
 
+//----------------------------------------------------------------------------
+// Test AStyleMainRange
+//----------------------------------------------------------------------------
+
+struct AStyleMainRangeF : public Test
+// The source is formatted except for the lines in the second function.
+// Only the changed function should be formatted.
+{
+	string textIn;		// source with an unformatted function
+	string textOut;		// expected source after formatting
+
+	// c'tor - build the text
+	AStyleMainRangeF()
+	{
+		textIn =
+		    "\nvoid foo1()\n"
+		    "{\n"
+		    "    bar1();\n"
+		    "}\n"
+		    "\n"
+		    "void foo2()\n"
+		    "{\n"
+		    "if (isBar)\n"
+		    "bar2();\n"
+		    "}\n"
+		    "\n"
+		    "void foo3()\n"
+		    "{\n"
+		    "    bar3();\n"
+		    "}\n";
+		textOut =
+		    "\nvoid foo1()\n"
+		    "{\n"
+		    "    bar1();\n"
+		    "}\n"
+		    "\n"
+		    "void foo2()\n"
+		    "{\n"
+		    "    if (isBar)\n"
+		    "        bar2();\n"
+		    "}\n"
+		    "\n"
+		    "void foo3()\n"
+		    "{\n"
+		    "    bar3();\n"
+		    "}\n";
+	}
+
+	// replace the lines firstLine thru lastLine of text with the replacement
+	string replaceLines(const string& text, int firstLine, int lastLine, const char* replacement)
+	{
+		size_t start = 0;
+		for (int i = 0; i < firstLine; i++)
+			start = text.find('\n', start) + 1;
+		size_t end = start;
+		for (int i = firstLine; i <= lastLine && end != string::npos; i++)
+		{
+			end = text.find('\n', end);
+			if (end != string::npos)
+				end++;
+		}
+		if (end == string::npos)
+			end = text.length();
+		return text.substr(0, start) + replacement + text.substr(end);
+	}
+};
+
+TEST_F(AStyleMainRangeF, FormatRange)
+// Test formatting one line in the changed function.
+// The range is expanded to the lines that are changed.
+{
+	int firstLine = 8;
+	int lastLine = 8;
+	char* textRange = AStyleMainRange(textIn.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the range starts after the closing brace of foo1()
+	// and ends at the unchanged line after the closing brace of foo2()
+	EXPECT_EQ(5, firstLine);
+	EXPECT_EQ(11, lastLine);
+	char expected[] =
+	    "\n"
+	    "void foo2()\n"
+	    "{\n"
+	    "    if (isBar)\n"
+	    "        bar2();\n"
+	    "}\n"
+	    "\n";
+	EXPECT_STREQ(expected, textRange);
+	EXPECT_EQ(textOut, replaceLines(textIn, firstLine, lastLine, textRange));
+	delete[] textRange;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeToEnd)
+// Test formatting a range that includes the end of the source.
+{
+	int firstLine = 13;
+	int lastLine = 100;
+	char* textRange = AStyleMainRange(textOut.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the last line is the empty line after the final line end
+	EXPECT_EQ(11, firstLine);
+	EXPECT_EQ(16, lastLine);
+	EXPECT_EQ(textOut, replaceLines(textOut, firstLine, lastLine, textRange));
+	delete[] textRange;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeUnbalanced)
+// Test formatting a range with an unbalanced brace.
+// The state of the following lines is changed so the entire source is formatted.
+{
+	string text = replaceLines(textIn, 8, 8, "if (isBar) {\n");
+	int firstLine = 8;
+	int lastLine = 8;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(0, firstLine);
+	EXPECT_EQ(16, lastLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_STREQ(textAll, textRange);
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeBraceInComment)
+// Test a closing brace at the start of a line in a comment.
+// The range must not start in the comment.
+{
+	string text =
+	    "\nvoid foo1()\n"
+	    "{\n"
+	    "    bar1();\n"
+	    "}\n"
+	    "\n"
+	    "/* comment\n"
+	    "}\n"
+	    " * comment\n"
+	    " */\n"
+	    "void foo2()\n"
+	    "{\n"
+	    "if (isBar)\n"
+	    "bar2();\n"
+	    "}\n";
+	int firstLine = 12;
+	int lastLine = 12;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the range starts after the closing brace of foo1()
+	EXPECT_EQ(5, firstLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(text, firstLine, lastLine, textRange));
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeBraceInRawString)
+// Test a closing brace at the start of a line in a raw string.
+// The range must not start in the raw string.
+{
+	string text =
+	    "\nvoid foo1()\n"
+	    "{\n"
+	    "    bar1();\n"
+	    "}\n"
+	    "\n"
+	    "const char* text = R\"(\n"
+	    "}\n"
+	    "   int  a ;\n"
+	    ")\";\n"
+	    "\n"
+	    "void foo2()\n"
+	    "{\n"
+	    "if (isBar)\n"
+	    "bar2();\n"
+	    "}\n";
+	int firstLine = 13;
+	int lastLine = 13;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the range starts after the closing brace of foo1()
+	EXPECT_EQ(5, firstLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(text, firstLine, lastLine, textRange));
+	// the raw string is not changed
+	EXPECT_TRUE(strstr(textRange, "\n   int  a ;\n") != nullptr);
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeRawStringPrefix)
+// Test a raw string with a prefix and a delimiter.
+// The range must not start in the raw string.
+{
+	string text =
+	    "\nvoid foo1()\n"
+	    "{\n"
+	    "    bar1();\n"
+	    "}\n"
+	    "\n"
+	    "const wchar_t* text = LR\"end(\n"
+	    "}\n"
+	    "   f(\")\" ;\n"
+	    ")end\";\n"
+	    "\n"
+	    "void foo2()\n"
+	    "{\n"
+	    "if (isBar)\n"
+	    "bar2();\n"
+	    "}\n";
+	int firstLine = 13;
+	int lastLine = 13;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the range starts after the closing brace of foo1()
+	EXPECT_EQ(5, firstLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(text, firstLine, lastLine, textRange));
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeDigitSeparator)
+// Test a digit separator on a line with a paren.
+// The separator is not a quote, so the source is balanced.
+{
+	string text =
+	    "\nvoid foo1()\n"
+	    "{\n"
+	    "    if (ch == '{' && count > 1'000)\n"
+	    "        bar1();\n"
+	    "}\n"
+	    "\n"
+	    "void foo2()\n"
+	    "{\n"
+	    "if (isBar)\n"
+	    "bar2();\n"
+	    "}\n";
+	int firstLine = 10;
+	int lastLine = 10;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	// the range starts after the closing brace of foo1()
+	EXPECT_EQ(6, firstLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(text, firstLine, lastLine, textRange));
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, FormatRangeIndentOff)
+// Test a closing brace at the start of a line in a block that is not formatted.
+// The range must not start in the block.
+{
+	string text =
+	    "\n// *INDENT-OFF*\n"
+	    "void foo1() {\n"
+	    "  bar1();\n"
+	    "}\n"
+	    "void foo2() {\n"
+	    "  bar2();\n"
+	    "}\n"
+	    "// *INDENT-ON*\n"
+	    "\n"
+	    "void foo3()\n"
+	    "{\n"
+	    "if (isBar)\n"
+	    "bar3();\n"
+	    "}\n";
+	int firstLine = 6;
+	int lastLine = 6;
+	char* textRange = AStyleMainRange(text.c_str(), "", &firstLine, &lastLine,
+	                                  errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(0, firstLine);
+	char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(text, firstLine, lastLine, textRange));
+	// the block is not changed
+	EXPECT_TRUE(strstr(textRange, "\nvoid foo2() {\n  bar2();\n}\n") != nullptr);
+	delete[] textRange;
+	delete[] textAll;
+}
+
+TEST_F(AStyleMainRangeF, InvalidLineRange)
+{
+	// test error handling for an invalid line range
+	int errorsIn = getErrorHandler2Calls();
+	int firstLine = 5;
+	int lastLine = 4;
+	char* textOut1 = ::AStyleMainRange(textIn.c_str(), "", &firstLine, &lastLine,
+	                                   errorHandler2, memoryAlloc);
+	EXPECT_TRUE(textOut1 == nullptr);
+	char* textOut2 = ::AStyleMainRange(textIn.c_str(), "", nullptr, &lastLine,
+	                                   errorHandler2, memoryAlloc);
+	EXPECT_TRUE(textOut2 == nullptr);
+	int errorsOut = getErrorHandler2Calls();
+	EXPECT_EQ(errorsIn + 2, errorsOut);
+}
+
+//----------------------------------------------------------------------------
+// Test AStyleFormatRange with a handle from AStyleCreate
+//----------------------------------------------------------------------------
+
+struct AStyleFormatRangeF : public AStyleMainRangeF
+// The handle keeps checkpoints between calls, so the result of each call
+// must be the same as formatting the entire source with AStyleMain.
+{
+	// format the entire source with AStyleMain
+	string formatMain(const string& text)
+	{
+		char* textAll = AStyleMain(text.c_str(), "", errorHandler, memoryAlloc);
+		if (textAll == nullptr)
+			return string();
+		string out(textAll);
+		delete[] textAll;
+		return out;
+	}
+};
+
+TEST_F(AStyleFormatRangeF, FormatRange)
+// Test that the first call with a handle is the same as AStyleMainRange.
+{
+	AStyleHandle handle = AStyleCreate("", errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	int firstLine = 8;
+	int lastLine = 8;
+	char* textRange = AStyleFormatRange(handle, textIn.c_str(), &firstLine, &lastLine);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(5, firstLine);
+	EXPECT_EQ(11, lastLine);
+	EXPECT_EQ(textOut, replaceLines(textIn, firstLine, lastLine, textRange));
+	delete[] textRange;
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleFormatRangeF, FormatRangeCheckpoint)
+// Test formatting ranges with a handle in a source in a namespace.
+// There is no top level closing brace before the range, so the range starts
+// at a checkpoint from the previous call if the source read is unchanged.
+{
+	string block =
+	    "void foo()\n"
+	    "{\n"
+	    "    if (isBar)\n"
+	    "        bar();\n"
+	    "}\n"
+	    "\n";
+	string text = "namespace ns\n{\n\n";
+	for (int i = 0; i < 500; i++)
+		text.append(block);
+	text.append("}\n");
+	AStyleHandle handle = AStyleCreate("", errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	// the first call formats the entire source and takes the checkpoints
+	int firstLine = 0;
+	int lastLine = 0;
+	char* textRange = AStyleFormatRange(handle, text.c_str(), &firstLine, &lastLine);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(0, firstLine);
+	EXPECT_STREQ(text.c_str(), textRange);
+	delete[] textRange;
+	// an edit near the end is formatted from a checkpoint
+	int editLine = 2400;
+	string textEdit = replaceLines(text, editLine, editLine, "bar();\n");
+	firstLine = editLine;
+	lastLine = editLine;
+	textRange = AStyleFormatRange(handle, textEdit.c_str(), &firstLine, &lastLine);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_GT(firstLine, 1000);
+	EXPECT_LE(firstLine, editLine);
+	EXPECT_EQ(text, replaceLines(textEdit, firstLine, lastLine, textRange));
+	delete[] textRange;
+	// without a handle the source is formatted from the first line
+	firstLine = editLine;
+	lastLine = editLine;
+	textRange = AStyleMainRange(textEdit.c_str(), "", &firstLine, &lastLine,
+	                            errorHandler, memoryAlloc);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(0, firstLine);
+	EXPECT_EQ(text, replaceLines(textEdit, firstLine, lastLine, textRange));
+	delete[] textRange;
+	// an edit before the checkpoints makes them invalid
+	textEdit = replaceLines(textEdit, 5, 5, "{ {\n");
+	firstLine = editLine;
+	lastLine = editLine;
+	textRange = AStyleFormatRange(handle, textEdit.c_str(), &firstLine, &lastLine);
+	ASSERT_TRUE(textRange != nullptr);
+	EXPECT_EQ(0, firstLine);
+	char* textAll = AStyleMain(textEdit.c_str(), "", errorHandler, memoryAlloc);
+	ASSERT_TRUE(textAll != nullptr);
+	EXPECT_EQ(string(textAll), replaceLines(textEdit, firstLine, lastLine, textRange));
+	delete[] textRange;
+	delete[] textAll;
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleFormatRangeF, FormatRangeEdits)
+// Test a series of edits with the same handle, as an editor would send them.
+// Each edit is made in the source returned by the previous call, so the
+// checkpoints before the edit are used and the ones after it are discarded.
+{
+	string block =
+	    "void foo()\n"
+	    "{\n"
+	    "    if (isBar)\n"
+	    "        bar();\n"
+	    "}\n"
+	    "\n";
+	string text = "namespace ns\n{\n\n";
+	for (int i = 0; i < 300; i++)
+		text.append(block);
+	text.append("}\n");
+	AStyleHandle handle = AStyleCreate("", errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	// the edits are out of line order to use checkpoints from several calls
+	const int editLines[] = { 1700, 600, 1201, 1205, 30, 1750, 999 };
+	const char* edits[] = { "bar();\n", "if (isBar) {\n", "{ baz();\n" };
+	for (size_t i = 0; i < sizeof(editLines) / sizeof(editLines[0]); i++)
+	{
+		int editLine = editLines[i];
+		string textEdit = replaceLines(text, editLine, editLine, edits[i % 3]);
+		int firstLine = editLine;
+		int lastLine = editLine;
+		char* textRange = AStyleFormatRange(handle, textEdit.c_str(), &firstLine, &lastLine);
+		ASSERT_TRUE(textRange != nullptr) << "edit " << editLine;
+		EXPECT_LE(firstLine, editLine);
+		EXPECT_GE(lastLine, editLine);
+		text = replaceLines(textEdit, firstLine, lastLine, textRange);
+		EXPECT_EQ(formatMain(textEdit), text) << "edit " << editLine;
+		delete[] textRange;
+	}
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleFormatRangeF, NullPointers)
+// Test error handling for a null handle and an invalid line range.
+{
+	int errorsIn = getErrorHandler2Calls();
+	int firstLine = 5;
+	int lastLine = 4;
+	// no handle, no error is reported
+	EXPECT_TRUE(AStyleFormatRange(nullptr, textIn.c_str(), &firstLine, &lastLine) == nullptr);
+	AStyleHandle handle = AStyleCreate("", errorHandler2, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	EXPECT_TRUE(AStyleFormatRange(handle, textIn.c_str(), &firstLine, &lastLine) == nullptr);
+	EXPECT_TRUE(AStyleFormatRange(handle, textIn.c_str(), nullptr, &lastLine) == nullptr);
+	EXPECT_TRUE(AStyleFormatRange(handle, nullptr, &firstLine, &lastLine) == nullptr);
+	AStyleDestroy(handle);
+	int errorsOut = getErrorHandler2Calls();
+	EXPECT_EQ(errorsIn + 3, errorsOut);
+}
+
+//----------------------------------------------------------------------------
+// Test AStyleMain called concurrently from several threads
+//----------------------------------------------------------------------------
+
+struct AStyleMainThreadsF : public Test
+// Format the same sources from many threads at once.
+// The output must be the same as formatting from a single thread.
+{
+	vector<string> textIn;		// source to format
+	vector<string> optionsIn;	// options for each source
+	vector<string> textOut;		// single thread output for each source
+
+	// c'tor - format the sources in a single thread
+	AStyleMainThreadsF()
+	{
+		// the extern "C" state was global
+		addSource(
+		    "#ifdef __cplusplus\n"
+		    "extern \"C\" {\n"
+		    "#endif\n"
+		    "\n"
+		    "void foo(int a,\n"
+		    "int b);\n"
+		    "\n"
+		    "#ifdef __cplusplus\n"
+		    "}\n"
+		    "#endif\n",
+		    "style=allman");
+		addSource(
+		    "#ifdef __cplusplus\n"
+		    "extern \"C\"\n"
+		    "{\n"
+		    "#endif\n"
+		    "    void bar(int a,\n"
+		    "int b);\n"
+		    "#ifdef __cplusplus\n"
+		    "}\n"
+		    "#endif\n",
+		    "style=kr, indent=tab");
+		// the Objective-C keyword alignment was global
+		addSource(
+		    "- (void)foo\n"
+		    "{\n"
+		    "    [myObject methodWithArg:one\n"
+		    "    andArg:two\n"
+		    "    andLongerArg:three];\n"
+		    "}\n",
+		    "align-method-colon");
+		addSource(
+		    "- (void)foo\n"
+		    "{\n"
+		    "    [myObject methodWithArg:one\n"
+		    "    andArg:two];\n"
+		    "}\n",
+		    "");
+		addSource(
+		    "namespace FooName {\n"
+		    "class FooClass {\n"
+		    "public:\n"
+		    "void foo() {\n"
+		    "if (isFoo) bar(); else { baz(); }\n"
+		    "}\n"
+		    "};\n"
+		    "}\n",
+		    "style=gnu, indent-namespaces, add-braces, pad-oper");
+		for (size_t i = 0; i < textIn.size(); i++)
+			textOut.emplace_back(formatSource(i));
+	}
+
+	void addSource(const char* text, const char* options)
+	{
+		textIn.emplace_back(text);
+		optionsIn.emplace_back(options);
+	}
+
+	string formatSource(size_t i) const
+	{
+		char* formatted = AStyleMain(textIn[i].c_str(), optionsIn[i].c_str(),
+		                             errorHandler, memoryAlloc);
+		if (formatted == nullptr)
+			return string();
+		string out(formatted);
+		delete[] formatted;
+		return out;
+	}
+};
+
+TEST_F(AStyleMainThreadsF, FormatConcurrently)
+// Test AStyleMain from many threads with the output compared to a single thread.
+{
+	const size_t numThreads = 8;
+	const size_t repetitions = 200;
+	// use char instead of bool, vector<bool> cannot be written concurrently
+	vector<char> isDifferent(numThreads, false);
+	vector<thread> threads;
+	for (size_t t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([this, t, &isDifferent]()
+		{
+			for (size_t r = 0; r < repetitions; r++)
+			{
+				// each thread starts with a different source
+				size_t i = (t + r) % textIn.size();
+				if (formatSource(i) != textOut[i])
+					isDifferent[t] = true;
+			}
+		});
+	}
+	for (thread& formatThread : threads)
+		formatThread.join();
+	// check the results
+	for (size_t t = 0; t < numThreads; t++)
+		EXPECT_FALSE(isDifferent[t]) << "thread " << t;
+	// check that the single thread output was formatted
+	for (size_t i = 0; i < textIn.size(); i++)
+		EXPECT_NE(textIn[i], textOut[i]) << "source " << i;
+}
+
+//----------------------------------------------------------------------------
+// Test the formatter handle from AStyleCreate
+//----------------------------------------------------------------------------
+
+struct AStyleHandleF : public Test
+// Small sources like the ones sent by an editor for each change.
+// The output of the handle must be the same as the output of AStyleMain.
+{
+	vector<string> textIn;		// source to format
+	const char* options;		// options for all of the sources
+
+	// c'tor - set the sources
+	AStyleHandleF()
+	{
+		options = "style=kr, indent=tab, add-braces, pad-oper, align-pointer=type";
+		textIn.emplace_back(
+		    "void foo(int* a, char &b)\n"
+		    "{\n"
+		    "if (a) bar(a+1);\n"
+		    "}\n");
+		textIn.emplace_back(
+		    "class FooClass {\n"
+		    "public:\n"
+		    "    FooClass() : x(0) {}\n"
+		    "private:\n"
+		    "    int x;\n"
+		    "};\n");
+		textIn.emplace_back(
+		    "#ifdef FOO\n"
+		    "int baz()\n"
+		    "{\n"
+		    "    switch (x) {\n"
+		    "    case 1: return x*2;\n"
+		    "    default: return 0;\n"
+		    "    }\n"
+		    "}\n"
+		    "#endif\n");
+		textIn.emplace_back(
+		    "/* comment\n"
+		    " * continued\n"
+		    " */\n"
+		    "for (int i=0; i<10; i++) sum+=i;\n");
+	}
+
+	string formatMain(const string& text) const
+	{
+		char* formatted = AStyleMain(text.c_str(), options, errorHandler, memoryAlloc);
+		if (formatted == nullptr)
+			return string();
+		string out(formatted);
+		delete[] formatted;
+		return out;
+	}
+
+	string formatHandle(AStyleHandle handle, const string& text) const
+	{
+		char* formatted = AStyleFormat(handle, text.c_str());
+		if (formatted == nullptr)
+			return string();
+		string out(formatted);
+		delete[] formatted;
+		return out;
+	}
+};
+
+TEST_F(AStyleHandleF, FormatSameAsAStyleMain)
+// Test that a handle can format many sources with the same output as AStyleMain.
+{
+	AStyleHandle handle = AStyleCreate(options, errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	// the sources are formatted twice to check that the state is reset
+	for (int repeat = 0; repeat < 2; repeat++)
+	{
+		for (size_t i = 0; i < textIn.size(); i++)
+		{
+			string textMain = formatMain(textIn[i]);
+			EXPECT_FALSE(textMain.empty());
+			EXPECT_NE(textIn[i], textMain) << "source " << i;
+			EXPECT_EQ(textMain, formatHandle(handle, textIn[i])) << "source " << i;
+		}
+	}
+	AStyleDestroy(handle);
+}
+
+// output function for AStyleFormatBuffer, appends the text to a string
+void STDCALL writeToString(const char* text, size_t textLength, void* pWriteData)
+{
+	static_cast<string*>(pWriteData)->append(text, textLength);
+}
+
+TEST_F(AStyleHandleF, FormatBuffer)
+// Test that the buffer interface has the same output as AStyleFormat.
+// The source is not terminated by a NUL.
+{
+	AStyleHandle handle = AStyleCreate(options, errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	for (size_t i = 0; i < textIn.size(); i++)
+	{
+		string buffer = textIn[i] + "int unformatted=0;";
+		string textOut;
+		int ok = AStyleFormatBuffer(handle, buffer.data(), textIn[i].length(), writeToString, &textOut);
+		EXPECT_EQ(1, ok);
+		EXPECT_EQ(formatHandle(handle, textIn[i]), textOut) << "source " << i;
+	}
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleHandleF, FormatBufferEmbeddedNul)
+// Test that NUL characters in the source are formatted as text.
+{
+	const char text[] =
+	    "void foo()\n"
+	    "{\n"
+	    "char name[] = \"a\0b\";\n"
+	    "}\n";
+	const char expected[] =
+	    "void foo()\n"
+	    "{\n"
+	    "\tchar name[] = \"a\0b\";\n"
+	    "}\n";
+	AStyleHandle handle = AStyleCreate("indent=tab", errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	string textOut;
+	int ok = AStyleFormatBuffer(handle, text, sizeof(text) - 1, writeToString, &textOut);
+	EXPECT_EQ(1, ok);
+	EXPECT_EQ(string(expected, sizeof(expected) - 1), textOut);
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleHandleF, InvalidOption)
+// Test that an invalid option is reported and the handle is still created.
+// The source is formatted without the option.
+{
+	int errorsIn = getErrorHandler2Calls();
+	AStyleHandle handle = AStyleCreate("invalid-option, indent=tab", errorHandler2, memoryAlloc);
+	int errorsOut = getErrorHandler2Calls();
+	ASSERT_TRUE(handle != nullptr);
+	EXPECT_EQ(errorsIn + 1, errorsOut);
+	char text[] =
+	    "\nvoid foo()\n"
+	    "{\n"
+	    "\tbar();\n"
+	    "}\n";
+	EXPECT_EQ(text, formatHandle(handle, "\nvoid foo()\n{\n    bar();\n}\n"));
+	AStyleDestroy(handle);
+}
+
+TEST_F(AStyleHandleF, NullPointers)
+// Test error handling for null pointers.
+{
+	int errorsIn = getErrorHandler2Calls();
+	// no error handler, no error is reported
+	EXPECT_TRUE(AStyleCreate("", nullptr, memoryAlloc) == nullptr);
+	// no options and no memory allocation function
+	EXPECT_TRUE(AStyleCreate(nullptr, errorHandler2, memoryAlloc) == nullptr);
+	EXPECT_TRUE(AStyleCreate("", errorHandler2, nullptr) == nullptr);
+	// no handle, no error is reported
+	EXPECT_TRUE(AStyleFormat(nullptr, textIn[0].c_str()) == nullptr);
+	AStyleDestroy(nullptr);
+	// no source
+	AStyleHandle handle = AStyleCreate("", errorHandler2, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	EXPECT_TRUE(AStyleFormat(handle, nullptr) == nullptr);
+	// no source and no output function for the buffer interface
+	string textOut;
+	EXPECT_EQ(0, AStyleFormatBuffer(handle, nullptr, 0, writeToString, &textOut));
+	EXPECT_EQ(0, AStyleFormatBuffer(handle, textIn[0].data(), textIn[0].length(), nullptr, nullptr));
+	EXPECT_EQ(0, AStyleFormatBuffer(nullptr, textIn[0].data(), textIn[0].length(), writeToString, &textOut));
+	EXPECT_TRUE(textOut.empty());
+	AStyleDestroy(handle);
+	int errorsOut = getErrorHandler2Calls();
+	EXPECT_EQ(errorsIn + 5, errorsOut);
+}
+
+TEST_F(AStyleHandleF, Benchmark)
+// Benchmark the handle against AStyleMain on the small sources.
+// The time per call is reported as properties of the test,
+// the results must be the same.
+{
+	const int repetitions = 500;
+	vector<string> mainOut;
+	vector<string> handleOut;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (const string& text : textIn)
+			mainOut.emplace_back(formatMain(text));
+	}
+	chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+	AStyleHandle handle = AStyleCreate(options, errorHandler, memoryAlloc);
+	ASSERT_TRUE(handle != nullptr);
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (const string& text : textIn)
+			handleOut.emplace_back(formatHandle(handle, text));
+	}
+	AStyleDestroy(handle);
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	int calls = repetitions * static_cast<int>(textIn.size());
+	int mainTime = static_cast<int>(chrono::duration_cast<chrono::nanoseconds>(middle - start).count() / calls);
+	int handleTime = static_cast<int>(chrono::duration_cast<chrono::nanoseconds>(end - middle).count() / calls);
+	RecordProperty("Calls", calls);
+	RecordProperty("AStyleMainNanosecondsPerCall", mainTime);
+	RecordProperty("AStyleFormatNanosecondsPerCall", handleTime);
+	EXPECT_TRUE(mainOut == handleOut);
+}
+
 //----------------------------------------------------------------------------
 
 }  // namespace
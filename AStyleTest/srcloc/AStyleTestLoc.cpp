@@ -929,6 +929,7 @@ struct TranslationF : public Test
 		m_ascii.push_back("Did you intend to use --recursive");
 		m_ascii.push_back("Cannot process UTF-32 encoding");
 		m_ascii.push_back("Artistic Style has terminated\n");
+		m_ascii.push_back(" %s cache hits   %s cache misses\n");
 	}
 	void getPrintSpecifiers(string& stringIn, vector<string>& specifiers)
 	// Extract the print specifiers from a string.